@@ -1,8 +1,20 @@
 set -x
-gcc src/*.c -g -O3 -Iinclude -lpthread -ldl -o ddsbench
+gcc src/*.c -g -O3 -Iinclude -lpthread -ldl -rdynamic -o ddsbench
 cd ospl
 sh build.sh
 cd ..
 cd lite
 sh build.sh
 cd ..
+cd inproc
+sh build.sh
+cd ..
+cd shm
+sh build.sh
+cd ..
+cd udp
+sh build.sh
+cd ..
+cd cyclone
+sh build.sh
+cd ..
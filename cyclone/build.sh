@@ -0,0 +1,3 @@
+set -x
+idlc -o idl idl/ddsbench.idl
+gcc src/*.c idl/ddsbench.c -g -I$CYCLONEDDS_HOME/include -Iinclude -I../include -L$CYCLONEDDS_HOME/lib -Wl,-rpath,$CYCLONEDDS_HOME/lib -lddsc -pthread -pipe -Wall -fno-strict-aliasing -O3 -std=c99 -DNDEBUG -D_GNU_SOURCE -fPIC -shared -o libcyclone.so
@@ -0,0 +1,92 @@
+
+#ifndef CYCLONE_H
+#define CYCLONE_H
+
+#include <dds/dds.h>
+
+#include <ddsbench.h>
+
+#ifdef __cplusplus
+extern "c" {
+#endif
+
+/* The participant of the process, which the threads create their entities
+ * in, so that endpoints in one process are delivered to without the network */
+extern dds_entity_t cyclone_participant;
+
+/* Guard condition that is triggered when the benchmark is interrupted (SIGINT) */
+extern dds_entity_t cyclone_terminated;
+
+/* Whether cyclone_terminated was triggered */
+int cyclone_isTerminated(void);
+
+/* Exit on a negative return code, like DDS_ERR_CHECK of Lite */
+#define CYCLONE_CHECK(rc, what) \
+    do { \
+        if ((rc) < 0) { \
+            printf("error: %s: %s\n", (what), dds_strretcode(rc)); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+/* Configuration that keeps a domain on the loopback interface, used when
+ * CYCLONEDDS_URI is not set. Processes find each other by unicast on
+ * localhost, as multicast is not enabled on lo by default. */
+#define CYCLONE_LOOPBACK_CONFIG \
+    "<CycloneDDS><Domain id=\"any\">" \
+    "<General><Interfaces><NetworkInterface name=\"lo\"/></Interfaces>" \
+    "<AllowMulticast>false</AllowMulticast></General>" \
+    "<Discovery><ParticipantIndex>auto</ParticipantIndex>" \
+    "<MaxAutoParticipantIndex>64</MaxAutoParticipantIndex>" \
+    "<Peers><Peer Address=\"localhost\"/></Peers></Discovery>" \
+    "</Domain></CycloneDDS>"
+
+/* QoS of an endpoint, see ddsbench_qosInit. Everything keeps all history.
+ * Delete it with dds_delete_qos. */
+dds_qos_t* cyclone_qos(const ddsbench_qos *settings);
+
+/* Topic of the thread, with the QoS of the codes of the benchmark */
+dds_entity_t cyclone_topicNew(ddsbench_threadArg *arg, const dds_topic_descriptor_t *descriptor);
+
+/* Create a writer or reader of topic in partition, in a publisher or
+ * subscriber of its own, which cyclone_endpointFree deletes with it */
+dds_entity_t cyclone_writerNew(ddsbench_threadArg *arg, dds_entity_t topic, const char *partition,
+    const ddsbench_qos *settings);
+dds_entity_t cyclone_readerNew(ddsbench_threadArg *arg, dds_entity_t topic, const char *partition,
+    const ddsbench_qos *settings, const dds_listener_t *listener);
+void cyclone_endpointFree(dds_entity_t endpoint);
+
+/* Wait until writer and reader (either may be 0) are matched with the
+ * number of readers and writers the benchmark expects, and set readyNs */
+void cyclone_waitMatched(ddsbench_threadArg *arg, dds_entity_t writer, dds_entity_t reader);
+
+/* Whether the writers a reader was matched with are all gone */
+int cyclone_writersGone(dds_entity_t reader);
+
+/* Waitset that wakes up when the benchmark is interrupted, and when reader
+ * (unless 0) has samples */
+dds_entity_t cyclone_waitsetNew(dds_entity_t reader);
+
+/* Take up to maxs samples. In copy mode samples points to buffers of the
+ * application that are filled in, with --take loan the pointers are replaced
+ * by samples loaned from the reader. Return them with cyclone_takeDone once
+ * they have been used. */
+int cyclone_take(dds_entity_t reader, void **samples, uint32_t maxs, dds_sample_info_t *info, ddsbench_context *ctx);
+void cyclone_takeDone(dds_entity_t reader, void **samples, int count, ddsbench_context *ctx);
+
+/* Whether writer writes samples it loans with --take loan, which needs a
+ * type the middleware can lay out itself. Reports the fallback to copies. */
+int cyclone_writerLoans(ddsbench_threadArg *arg, dds_entity_t writer);
+
+/* Endpoints the harness runs the latency and throughput threads on */
+extern const ddsbench_ops cyclone_ops;
+
+/* Functions of the plugin, exported through its descriptor in cyclone.c */
+int init(ddsbench_context *ctx);
+void fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
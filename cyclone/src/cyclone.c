@@ -0,0 +1,259 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include <cyclone.h>
+
+dds_entity_t cyclone_participant;
+dds_entity_t cyclone_terminated;
+
+static volatile int terminated;
+static struct sigaction oldAction;
+
+static void CtrlHandler(int fdwCtrlType)
+{
+    terminated = 1;
+    dds_set_guardcondition(cyclone_terminated, true);
+}
+
+int cyclone_isTerminated(void)
+{
+    return terminated;
+}
+
+int init(ddsbench_context *ctx)
+{
+    struct sigaction sat;
+
+    /* Stay on the loopback interface, unless configured otherwise */
+    if (!getenv("CYCLONEDDS_URI")) {
+        setenv("CYCLONEDDS_URI", CYCLONE_LOOPBACK_CONFIG, 0);
+    }
+
+    cyclone_participant = dds_create_participant(DDS_DOMAIN_DEFAULT, NULL, NULL);
+    CYCLONE_CHECK(cyclone_participant, "dds_create_participant");
+    cyclone_terminated = dds_create_guardcondition(cyclone_participant);
+    CYCLONE_CHECK(cyclone_terminated, "dds_create_guardcondition");
+
+    terminated = 0;
+    sat.sa_handler = CtrlHandler;
+    sigemptyset(&sat.sa_mask);
+    sat.sa_flags = 0;
+    sigaction(SIGINT, &sat, &oldAction);
+
+    /* Readers copy into their own buffers unless loans are requested */
+    if (ctx->take == DDSBENCH_TAKE_DEFAULT) {
+        ctx->take = DDSBENCH_TAKE_COPY;
+    }
+
+    /* Writers pack samples in messages until they flush, at the end of a burst */
+    dds_write_set_batch(ctx->batch != 0);
+
+    return 0;
+}
+
+void fini(void)
+{
+    sigaction(SIGINT, &oldAction, 0);
+    dds_delete(cyclone_participant);
+}
+
+/* The plugin descriptor. Endpoints of all threads share one participant, so
+ * samples between them are delivered locally, and the default configuration
+ * keeps the traffic between processes on the loopback interface. Without a
+ * durability service the durability mode aligns transient local history only. */
+const ddsbench_plugin ddsbench_pluginDescriptor = {
+    .version = DDSBENCH_PLUGIN_VERSION,
+    .name = "cyclone",
+    .description = "Eclipse Cyclone DDS",
+    .capabilities = DDSBENCH_CAP_LOANS | DDSBENCH_CAP_FILTERS | DDSBENCH_CAP_LISTENERS | DDSBENCH_CAP_DURABILITY |
+                    DDSBENCH_CAP_BATCHING | DDSBENCH_CAP_DDSI,
+    .init = init,
+    .fini = fini,
+    .ops = &cyclone_ops
+};
+
+dds_qos_t* cyclone_qos(const ddsbench_qos *settings)
+{
+    dds_qos_t *qos = dds_create_qos();
+
+    if (settings->depth) {
+        dds_qset_history(qos, DDS_HISTORY_KEEP_LAST, settings->depth);
+    } else {
+        dds_qset_history(qos, DDS_HISTORY_KEEP_ALL, 0);
+    }
+    dds_qset_resource_limits(qos, settings->maxSamples < 0 ? DDS_LENGTH_UNLIMITED : settings->maxSamples,
+        DDS_LENGTH_UNLIMITED, DDS_LENGTH_UNLIMITED);
+    if (settings->reliable) {
+        dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, (dds_duration_t)settings->maxBlockingNs);
+    } else {
+        dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+    }
+
+    /* There is no durability service, so transient and persistent data is
+     * kept by the writers, like transient local */
+    dds_qset_durability(qos, settings->durability == DDSBENCH_VOLATILE ?
+        DDS_DURABILITY_VOLATILE : DDS_DURABILITY_TRANSIENT_LOCAL);
+    return qos;
+}
+
+dds_entity_t cyclone_topicNew(ddsbench_threadArg *arg, const dds_topic_descriptor_t *descriptor)
+{
+    ddsbench_qos settings;
+    dds_qos_t *qos;
+    dds_entity_t topic;
+
+    ddsbench_qosInit(&settings, arg->ctx, DDSBENCH_LATENCY, 0);
+    qos = cyclone_qos(&settings);
+    topic = dds_create_topic(cyclone_participant, descriptor, arg->topicName, qos, NULL);
+    CYCLONE_CHECK(topic, "dds_create_topic");
+    dds_delete_qos(qos);
+    return topic;
+}
+
+dds_entity_t cyclone_writerNew(ddsbench_threadArg *arg, dds_entity_t topic, const char *partition,
+    const ddsbench_qos *settings)
+{
+    dds_qos_t *qos = dds_create_qos();
+    dds_entity_t publisher, writer;
+
+    dds_qset_partition1(qos, partition);
+    publisher = dds_create_publisher(cyclone_participant, qos, NULL);
+    CYCLONE_CHECK(publisher, "dds_create_publisher");
+    dds_delete_qos(qos);
+
+    qos = cyclone_qos(settings);
+    writer = dds_create_writer(publisher, topic, qos, NULL);
+    CYCLONE_CHECK(writer, "dds_create_writer");
+    dds_delete_qos(qos);
+    return writer;
+}
+
+dds_entity_t cyclone_readerNew(ddsbench_threadArg *arg, dds_entity_t topic, const char *partition,
+    const ddsbench_qos *settings, const dds_listener_t *listener)
+{
+    dds_qos_t *qos = dds_create_qos();
+    dds_entity_t subscriber, reader;
+
+    dds_qset_partition1(qos, partition);
+    subscriber = dds_create_subscriber(cyclone_participant, qos, NULL);
+    CYCLONE_CHECK(subscriber, "dds_create_subscriber");
+    dds_delete_qos(qos);
+
+    qos = cyclone_qos(settings);
+    reader = dds_create_reader(subscriber, topic, qos, listener);
+    CYCLONE_CHECK(reader, "dds_create_reader");
+    dds_delete_qos(qos);
+    return reader;
+}
+
+void cyclone_endpointFree(dds_entity_t endpoint)
+{
+    /* The publisher or subscriber of the endpoint belongs to it alone */
+    if (endpoint > 0) {
+        dds_delete(dds_get_parent(endpoint));
+    }
+}
+
+void cyclone_waitMatched(ddsbench_threadArg *arg, dds_entity_t writer, dds_entity_t reader)
+{
+    dds_publication_matched_status_t pms = { 0 };
+    dds_subscription_matched_status_t sms = { 0 };
+    unsigned long long deadline = ddsbench_time() + DDSBENCH_MATCH_TIMEOUT_NS;
+    dds_return_t rc;
+
+    for (;;) {
+        if (writer) {
+            rc = dds_get_publication_matched_status(writer, &pms);
+            CYCLONE_CHECK(rc, "dds_get_publication_matched_status");
+        }
+        if (reader) {
+            rc = dds_get_subscription_matched_status(reader, &sms);
+            CYCLONE_CHECK(rc, "dds_get_subscription_matched_status");
+        }
+        if ((!writer || pms.current_count >= arg->ctx->readers) &&
+            (!reader || sms.current_count >= arg->ctx->writers)) {
+            break;
+        }
+        if (terminated || ddsbench_time() > deadline) {
+            printf("%s %d: matched %u of %u readers and %u of %u writers, starting anyway\n",
+                arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id,
+                writer ? pms.current_count : 0, writer ? arg->ctx->readers : 0,
+                reader ? sms.current_count : 0, reader ? arg->ctx->writers : 0);
+            break;
+        }
+        dds_sleepfor(DDS_MSECS(1));
+    }
+
+    arg->result.readyNs = ddsbench_time() - arg->startNs;
+}
+
+int cyclone_writersGone(dds_entity_t reader)
+{
+    dds_subscription_matched_status_t sms;
+
+    return dds_get_subscription_matched_status(reader, &sms) == DDS_RETCODE_OK &&
+        sms.total_count && !sms.current_count;
+}
+
+dds_entity_t cyclone_waitsetNew(dds_entity_t reader)
+{
+    dds_entity_t waitset, condition;
+    dds_return_t rc;
+
+    waitset = dds_create_waitset(cyclone_participant);
+    CYCLONE_CHECK(waitset, "dds_create_waitset");
+    rc = dds_waitset_attach(waitset, cyclone_terminated, 0);
+    CYCLONE_CHECK(rc, "dds_waitset_attach");
+    if (reader) {
+        condition = dds_create_readcondition(reader, DDS_ANY_STATE);
+        CYCLONE_CHECK(condition, "dds_create_readcondition");
+        rc = dds_waitset_attach(waitset, condition, reader);
+        CYCLONE_CHECK(rc, "dds_waitset_attach");
+    }
+    return waitset;
+}
+
+int cyclone_take(dds_entity_t reader, void **samples, uint32_t maxs, dds_sample_info_t *info, ddsbench_context *ctx)
+{
+    dds_return_t n;
+
+    /* A null first pointer makes the reader loan its own samples */
+    if (ctx->take == DDSBENCH_TAKE_LOAN) {
+        samples[0] = NULL;
+    }
+    n = dds_take(reader, samples, info, maxs, maxs);
+    CYCLONE_CHECK(n, "dds_take");
+    return n;
+}
+
+void cyclone_takeDone(dds_entity_t reader, void **samples, int count, ddsbench_context *ctx)
+{
+    dds_return_t rc;
+
+    if (ctx->take == DDSBENCH_TAKE_LOAN && count > 0) {
+        rc = dds_return_loan(reader, samples, count);
+        CYCLONE_CHECK(rc, "dds_return_loan");
+    }
+}
+
+int cyclone_writerLoans(ddsbench_threadArg *arg, dds_entity_t writer)
+{
+    void *sample;
+    dds_return_t rc;
+
+    if (arg->ctx->take != DDSBENCH_TAKE_LOAN) {
+        return 0;
+    }
+
+    /* Writers loan samples of types that the middleware can lay out itself */
+    if ((rc = dds_loan_sample(writer, &sample)) != DDS_RETCODE_OK) {
+        printf("pub %d: writer loans are not supported for this type (%s), writing copies\n",
+            arg->id, dds_strretcode(rc));
+        return 0;
+    }
+    dds_return_loan(writer, &sample, 1);
+    return 1;
+}
@@ -0,0 +1,339 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cyclone.h>
+#include <../idl/ddsbench.h>
+
+/* Samples a reader takes at once */
+#define MAX_SAMPLES 100
+
+/* A sample of either type, as a reader takes it in copy mode */
+typedef union cycloneData {
+    ddsbench_Latency latency;
+    ddsbench_Throughput throughput;
+} cycloneData;
+
+/* An endpoint of the engine, with the topic of its own that it was created on */
+typedef struct cycloneEndpoint {
+    ddsbench_threadArg *arg;
+    ddsbench_endpointKind kind;
+    const dds_topic_descriptor_t *descriptor;
+    dds_entity_t topic;
+    dds_entity_t entity;
+    int loans;                      /* Writer loans its samples, see cyclone_writerLoans */
+
+    /* Readers only */
+    dds_entity_t waitset;
+    dds_listener_t *listener;
+    ddsbench_listenerFn listenerFn;
+    void *listenerArg;
+    int gone;                       /* An instance lost its writers, or was disposed */
+    int taken;                      /* Samples of the last take, returned by takeDone */
+    void *samples[MAX_SAMPLES];
+    dds_sample_info_t info[MAX_SAMPLES];
+    cycloneData data[MAX_SAMPLES];
+} cycloneEndpoint;
+
+static void sampleFields(const ddsbench_Throughput *sample, long long *fields)
+{
+    fields[DDSBENCH_FIELD_ID] = sample->id;
+    fields[DDSBENCH_FIELD_FILTER] = sample->filter;
+    fields[DDSBENCH_FIELD_COUNT] = sample->count;
+}
+
+/* Filter of the topic, which the reader applies before samples are stored */
+static bool topicFilter(const void *sample, void *predicate)
+{
+    long long fields[DDSBENCH_FIELD_MAX];
+
+    sampleFields(sample, fields);
+    return ddsbench_predicateEval(predicate, fields);
+}
+
+static void dataAvailable(dds_entity_t reader, void *arg)
+{
+    cycloneEndpoint *endpoint = arg;
+
+    endpoint->listenerFn(endpoint, endpoint->listenerArg);
+}
+
+static cycloneEndpoint* endpointNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const ddsbench_qos *qos)
+{
+    cycloneEndpoint *endpoint;
+
+    /* Without a durability service history that outlives its writers cannot
+     * be aligned to late joiners */
+    if (qos->depth && qos->durability > DDSBENCH_TRANSIENT_LOCAL) {
+        printf("%s %d: there is no durability service, only transient local (l) is supported\n",
+            arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id);
+        return NULL;
+    }
+
+    if (!(endpoint = calloc(1, sizeof(cycloneEndpoint)))) {
+        printf("%s %d: out of memory\n", arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id);
+        return NULL;
+    }
+    endpoint->arg = arg;
+    endpoint->kind = kind;
+    endpoint->descriptor = kind == DDSBENCH_LATENCY ? &ddsbench_Latency_desc : &ddsbench_Throughput_desc;
+    endpoint->topic = cyclone_topicNew(arg, endpoint->descriptor);
+    return endpoint;
+}
+
+static void* opsWriterNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos)
+{
+    cycloneEndpoint *writer = endpointNew(arg, kind, qos);
+
+    if (writer) {
+        writer->entity = cyclone_writerNew(arg, writer->topic, partition, qos);
+        writer->loans = kind == DDSBENCH_THROUGHPUT && cyclone_writerLoans(arg, writer->entity);
+    }
+    return writer;
+}
+
+static void* opsReaderNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos, ddsbench_listenerFn listener, void *listenerArg)
+{
+    ddsbench_context *ctx = arg->ctx;
+    cycloneEndpoint *reader = endpointNew(arg, kind, qos);
+    dds_return_t rc;
+    int i;
+
+    if (!reader) {
+        return NULL;
+    }
+    for (i = 0; i < MAX_SAMPLES; i++) {
+        reader->samples[i] = &reader->data[i];
+    }
+
+    /* The predicate compiled by ddsbench filters samples in the reader */
+    if (kind == DDSBENCH_THROUGHPUT && ctx->filter && !ctx->localfilter) {
+        if (ctx->predicate) {
+            dds_set_topic_filter_and_arg(reader->topic, topicFilter, ctx->predicate);
+        } else {
+            printf("sub %d: filter '%s' is not supported, ignoring\n", arg->id, ctx->filter);
+        }
+    }
+
+    reader->entity = cyclone_readerNew(arg, reader->topic, partition, qos, NULL);
+    reader->waitset = cyclone_waitsetNew(reader->entity);
+
+    /* The listener is set once the reader is complete, it may run right away */
+    if (listener) {
+        reader->listenerFn = listener;
+        reader->listenerArg = listenerArg;
+        reader->listener = dds_create_listener(reader);
+        dds_lset_data_available(reader->listener, dataAvailable);
+        rc = dds_set_listener(reader->entity, reader->listener);
+        CYCLONE_CHECK(rc, "dds_set_listener");
+    }
+    return reader;
+}
+
+static void opsWriterFree(void *ptr)
+{
+    cycloneEndpoint *writer = ptr;
+
+    cyclone_endpointFree(writer->entity);
+    dds_delete(writer->topic);
+    free(writer);
+}
+
+static void opsReaderFree(void *ptr)
+{
+    cycloneEndpoint *reader = ptr;
+    int i;
+
+    /* Resetting the listener waits for a callback that is running */
+    if (reader->listener) {
+        dds_set_listener(reader->entity, NULL);
+        dds_delete_listener(reader->listener);
+    }
+    dds_delete(reader->waitset);
+    cyclone_endpointFree(reader->entity);
+    dds_delete(reader->topic);
+    for (i = 0; i < MAX_SAMPLES; i++) {
+        dds_sample_free(&reader->data[i], reader->descriptor, DDS_FREE_CONTENTS);
+    }
+    free(reader);
+}
+
+static void opsWaitMatched(ddsbench_threadArg *arg, void *writer, void *reader)
+{
+    cyclone_waitMatched(arg, writer ? ((cycloneEndpoint *)writer)->entity : 0,
+        reader ? ((cycloneEndpoint *)reader)->entity : 0);
+}
+
+/* The payload is written from where the engine has it, the writer does not free it */
+static int opsWrite(void *ptr, const ddsbench_sample *sample)
+{
+    cycloneEndpoint *writer = ptr;
+    cycloneData data;
+    void *loan;
+    dds_return_t rc;
+
+    if (writer->kind == DDSBENCH_LATENCY) {
+        data.latency.filter = sample->filter;
+        data.latency.payload._buffer = sample->payload;
+        data.latency.payload._length = data.latency.payload._maximum = sample->length;
+        data.latency.payload._release = false;
+    } else {
+        data.throughput.id = sample->id;
+        data.throughput.filter = sample->filter;
+        data.throughput.count = sample->count;
+        data.throughput.payload._buffer = sample->payload;
+        data.throughput.payload._length = data.throughput.payload._maximum = sample->length;
+        data.throughput.payload._release = false;
+    }
+
+    if (writer->loans) {
+        if ((rc = dds_loan_sample(writer->entity, &loan)) == DDS_RETCODE_OK) {
+            memcpy(loan, &data.throughput, sizeof(data.throughput));
+            rc = dds_write(writer->entity, loan);
+        }
+    } else {
+        rc = dds_write(writer->entity, &data);
+    }
+    if (rc == DDS_RETCODE_TIMEOUT) {
+        return DDSBENCH_WRITE_TIMEOUT;
+    } else if (rc < 0) {
+        printf("%s %d: dds_write failed: %s\n",
+            writer->arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", writer->arg->id, dds_strretcode(rc));
+        return DDSBENCH_WRITE_ERROR;
+    }
+    return DDSBENCH_WRITE_OK;
+}
+
+static void opsFlush(void *writer)
+{
+    dds_write_flush(((cycloneEndpoint *)writer)->entity);
+}
+
+/* Take samples and return the ones with data, an instance that lost its
+ * writers is remembered for opsWritersGone */
+static int opsTake(void *ptr, ddsbench_sample *samples, int max)
+{
+    cycloneEndpoint *reader = ptr;
+    int i, n, valid = 0;
+
+    n = cyclone_take(reader->entity, reader->samples, max < MAX_SAMPLES ? max : MAX_SAMPLES,
+        reader->info, reader->arg->ctx);
+    for (i = 0; i < n; i++) {
+        if (!reader->info[i].valid_data) {
+            if (reader->info[i].instance_state != DDS_IST_ALIVE) {
+                reader->gone = 1;
+            }
+            continue;
+        }
+        if (reader->kind == DDSBENCH_LATENCY) {
+            ddsbench_Latency *sample = reader->samples[i];
+            samples[valid].id = 0;
+            samples[valid].filter = sample->filter;
+            samples[valid].count = DDSBENCH_NO_COUNT;
+            samples[valid].payload = sample->payload._buffer;
+            samples[valid].length = sample->payload._length;
+        } else {
+            ddsbench_Throughput *sample = reader->samples[i];
+            samples[valid].id = sample->id;
+            samples[valid].filter = sample->filter;
+            samples[valid].count = sample->count;
+            samples[valid].payload = sample->payload._buffer;
+            samples[valid].length = sample->payload._length;
+        }
+
+        /* Samples are written on this host, the source timestamp is on its clock */
+        samples[valid++].timestamp = ddsbench_timeFromWall(reader->info[i].source_timestamp);
+    }
+
+    /* Without data there is no takeDone to return the loan */
+    reader->taken = n;
+    if (n > 0 && !valid) {
+        cyclone_takeDone(reader->entity, reader->samples, n, reader->arg->ctx);
+        reader->taken = 0;
+    }
+    return valid;
+}
+
+static void opsTakeDone(void *ptr)
+{
+    cycloneEndpoint *reader = ptr;
+
+    cyclone_takeDone(reader->entity, reader->samples, reader->taken, reader->arg->ctx);
+    reader->taken = 0;
+}
+
+static void opsWait(void *reader, unsigned long long timeoutNs)
+{
+    dds_waitset_wait(((cycloneEndpoint *)reader)->waitset, NULL, 0, (dds_duration_t)timeoutNs);
+}
+
+static int opsWritersGone(void *ptr)
+{
+    cycloneEndpoint *reader = ptr;
+
+    return reader->gone || cyclone_writersGone(reader->entity);
+}
+
+/* A waitset over the readers of a pool worker, on read conditions that are
+ * deleted with the readers */
+static void* opsWaitSetNew(void **readers, int count)
+{
+    dds_entity_t *waitset, condition;
+    dds_return_t rc;
+    int i;
+
+    if (!(waitset = malloc(sizeof(dds_entity_t)))) {
+        printf("worker: out of memory\n");
+        return NULL;
+    }
+    *waitset = cyclone_waitsetNew(0);
+    for (i = 0; i < count; i++) {
+        condition = dds_create_readcondition(((cycloneEndpoint *)readers[i])->entity, DDS_ANY_STATE);
+        CYCLONE_CHECK(condition, "dds_create_readcondition");
+        rc = dds_waitset_attach(*waitset, condition, i + 1);
+        CYCLONE_CHECK(rc, "dds_waitset_attach");
+    }
+    return waitset;
+}
+
+static void opsWaitAny(void *waitset, unsigned long long timeoutNs)
+{
+    dds_waitset_wait(*(dds_entity_t *)waitset, NULL, 0, (dds_duration_t)timeoutNs);
+}
+
+static void opsWaitSetFree(void *waitset)
+{
+    dds_delete(*(dds_entity_t *)waitset);
+    free(waitset);
+}
+
+static void opsWaitAcked(void *writer, unsigned long long timeoutNs)
+{
+    dds_return_t rc = dds_wait_for_acks(((cycloneEndpoint *)writer)->entity, (dds_duration_t)timeoutNs);
+
+    if (rc != DDS_RETCODE_TIMEOUT) {
+        CYCLONE_CHECK(rc, "dds_wait_for_acks");
+    }
+}
+
+const ddsbench_ops cyclone_ops = {
+    .writerNew = opsWriterNew,
+    .readerNew = opsReaderNew,
+    .writerFree = opsWriterFree,
+    .readerFree = opsReaderFree,
+    .waitMatched = opsWaitMatched,
+    .write = opsWrite,
+    .flush = opsFlush,
+    .take = opsTake,
+    .takeDone = opsTakeDone,
+    .wait = opsWait,
+    .writersGone = opsWritersGone,
+    .terminated = cyclone_isTerminated,
+    .waitSetNew = opsWaitSetNew,
+    .waitAny = opsWaitAny,
+    .waitSetFree = opsWaitSetFree,
+    .waitAcked = opsWaitAcked
+};
@@ -2,45 +2,484 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <limits.h>
+
 #ifdef __cplusplus
 extern "c" {
 #endif
 
+/* Fields of the benchmark types that can be used in a filter expression */
+typedef enum ddsbench_filterField {
+    DDSBENCH_FIELD_ID,
+    DDSBENCH_FIELD_FILTER,
+    DDSBENCH_FIELD_COUNT,
+    DDSBENCH_FIELD_MAX
+} ddsbench_filterField;
+
+/* Filter expression compiled by the harness, see ddsbench_predicateCompile */
+typedef struct ddsbench_predicate ddsbench_predicate;
+
+/* Countdown latch used to order the phases of a trial across threads */
+typedef struct ddsbench_latch ddsbench_latch;
+
+/* Barrier that all threads of a run cross once their entities are matched */
+typedef struct ddsbench_barrier ddsbench_barrier;
+
+/* Histogram of durations in nanoseconds. Each power of two is divided in 8
+ * linear buckets, which bounds the error of a quantile to 12.5%. */
+#define DDSBENCH_HISTOGRAM_BUCKETS 320
+
+typedef struct ddsbench_histogram {
+    unsigned long long count;
+    unsigned long long totalNs;
+    unsigned long long maxNs;
+    unsigned long long bucket[DDSBENCH_HISTOGRAM_BUCKETS];
+} ddsbench_histogram;
+
+/* How receiving threads wait for data, see ddsbench_poll */
+typedef enum ddsbench_recvMode {
+    DDSBENCH_RECV_BLOCK,    /* Block in a waitset (or listener) */
+    DDSBENCH_RECV_SPIN,     /* Take without ever blocking */
+    DDSBENCH_RECV_HYBRID    /* Spin, then yield, then block */
+} ddsbench_recvMode;
+
+/* How readers get samples from the middleware, see --take */
+typedef enum ddsbench_takeMode {
+    DDSBENCH_TAKE_DEFAULT,  /* The way the product takes by default, set by its init */
+    DDSBENCH_TAKE_COPY,     /* Copy samples into buffers of the application */
+    DDSBENCH_TAKE_LOAN      /* Loan samples from the middleware and return them after use */
+} ddsbench_takeMode;
+
+/* Content of the payloads that are written, see --pattern */
+typedef enum ddsbench_payloadPattern {
+    DDSBENCH_PATTERN_CONST,         /* Every byte is 'a' */
+    DDSBENCH_PATTERN_ZERO,          /* Every byte is zero */
+    DDSBENCH_PATTERN_RANDOM,        /* Pseudo random, so incompressible, bytes */
+    DDSBENCH_PATTERN_COUNTER        /* 64 bit words that count up over all payloads */
+} ddsbench_payloadPattern;
+
+/* A write call that takes longer than this is counted as blocked */
+#define DDSBENCH_BLOCKED_NS 100000ULL
+
+/* Time a thread waits for its entities to be matched before it starts anyway */
+#define DDSBENCH_MATCH_TIMEOUT_NS 10000000000ULL
+
 typedef struct ddsbench_context {
     char *qos;
     char *filter;
     unsigned int payload;
+    ddsbench_payloadPattern pattern; /* Content of payloads */
+    unsigned int rotate;            /* Payload buffers a writer rotates through */
+    int hugepages;                  /* Place payload buffers in huge pages */
+    int verify;                     /* Stamp payloads with a checksum that receivers verify */
     unsigned int burstsize;
     unsigned int burstinterval;
+    int batch;                      /* Write a burst as one batch, see DDSBENCH_CAP_BATCHING */
     unsigned int pollingdelay;
     unsigned int subid;
     unsigned int pubid;
     unsigned int topicid;
+    unsigned int duration;          /* Seconds to run, 0 runs until interrupted */
+    int maxsamples;                 /* Writer resource_limits.max_samples, -1 is unlimited */
+    ddsbench_recvMode recv;         /* How receiving threads wait for data */
+    unsigned int spin;              /* Microseconds a hybrid receiver spins, and then yields, before blocking */
+    ddsbench_takeMode take;         /* Copy or loan samples on take */
+    int localfilter;                /* Apply predicate after take instead of in the middleware */
+    ddsbench_predicate *predicate;  /* Compiled form of filter, NULL if it could not be compiled */
+    unsigned int history;           /* Historical samples each publisher writes before late joiners start */
+    unsigned int instances;         /* Number of instances the history is spread over */
+    unsigned long long expected;    /* Samples a subscriber expects to receive, 0 if unknown */
+    ddsbench_latch *historyWritten; /* Publishers arrive when their history is written */
+    ddsbench_latch *historyAligned; /* Subscribers arrive when their history is received */
+    unsigned int readers;           /* Readers a writer must be matched with before it starts */
+    unsigned int writers;           /* Writers a reader must be matched with before it starts */
+    ddsbench_barrier *start;        /* Threads cross it once matched, see ddsbench_startBarrier */
     char topicname[256];
-    char filtername[256];
+    char filtername[256 + 32];      /* Name of a trial topic with _filter */
 } ddsbench_context;
 
+typedef enum ddsbench_role {
+    DDSBENCH_SUBSCRIBER,
+    DDSBENCH_PUBLISHER
+} ddsbench_role;
+
+/* Hardware counters of a thread, see --perf */
+typedef enum ddsbench_perfCounter {
+    DDSBENCH_PERF_CYCLES,
+    DDSBENCH_PERF_INSTRUCTIONS,
+    DDSBENCH_PERF_L1D_MISSES,
+    DDSBENCH_PERF_LLC_MISSES,
+    DDSBENCH_PERF_BRANCH_MISSES,
+    DDSBENCH_PERF_COUNTERS
+} ddsbench_perfCounter;
+
+/* Allocations of a thread, see --allocs. Sizes are counted per power of
+ * two, bucket b holds sizes up to 2^b bytes and the last one the rest. */
+#define DDSBENCH_ALLOC_BUCKETS 24
+
+typedef struct ddsbench_allocStats {
+    unsigned long long allocs;      /* Calls of malloc, calloc and realloc */
+    unsigned long long frees;
+    unsigned long long bytes;       /* Bytes requested by those calls */
+    unsigned long long sizes[DDSBENCH_ALLOC_BUCKETS];
+} ddsbench_allocStats;
+
+/* Results a thread reports back to the harness when it finishes */
+typedef struct ddsbench_threadResult {
+    unsigned long long samples;     /* Samples written (pub) or accepted (sub) */
+    unsigned long long evaluated;   /* Samples passed through the local predicate */
+    unsigned long long filterNs;    /* Thread CPU time spent in the local predicate */
+    unsigned long long cpuNs;       /* Process CPU time consumed while writing */
+    unsigned long long bytes;       /* Payload bytes written or received */
+    unsigned long long waitNs;      /* Time until the middleware reported history to be aligned */
+    unsigned long long alignNs;     /* Time until all expected history was received */
+    unsigned long long blocked;     /* Write calls that took longer than DDSBENCH_BLOCKED_NS */
+    unsigned long long timeouts;    /* Write calls that returned a timeout */
+    ddsbench_histogram writeNs;     /* Duration of every write call */
+    ddsbench_histogram latencyNs;   /* Time from source timestamp until take */
+    unsigned long long readyNs;     /* Time from thread start until its entities were matched */
+    unsigned long long threadCpuNs; /* CPU time of the thread */
+    unsigned long long systemNs;    /* Part of threadCpuNs spent in the kernel */
+    unsigned long long voluntarySwitches;   /* Context switches because the thread blocked */
+    unsigned long long involuntarySwitches; /* Context switches because the thread was preempted */
+    unsigned long long perf[DDSBENCH_PERF_COUNTERS]; /* Counted from the start barrier until the thread finished */
+    unsigned int perfMask;          /* Bit per counter in perf that was counted, 0 if none */
+    unsigned long long emptyTakes;  /* Takes that returned no data while polling */
+    unsigned long long yields;      /* Times a polling thread yielded the cpu */
+    unsigned long long blocks;      /* Times a receiving thread blocked */
+    unsigned long long verified;    /* Payloads checked against their checksum */
+    unsigned long long corrupt;     /* Verified payloads that did not match their checksum */
+    unsigned long long verifiedBytes; /* Bytes of the intact verified payloads */
+    unsigned long long verifyNs;    /* Thread CPU time spent verifying */
+    ddsbench_allocStats allocs;     /* Counted from the start barrier until the thread finished */
+    ddsbench_histogram roundTripNs; /* Round trips of ping after warm up, from write until pong's answer was taken */
+    unsigned long long measureNs;   /* Time from the start barrier until a subscriber stopped receiving */
+} ddsbench_threadResult;
+
+/* Product a thread runs on, see ddsbench_plugin */
+typedef struct ddsbench_plugin ddsbench_plugin;
+
+/* Receive loop state of a thread, see ddsbench_pollInit */
+typedef struct ddsbench_poll {
+    ddsbench_recvMode mode;
+    unsigned long long budgetNs;
+    unsigned long long idleStart;   /* Time of the first empty take, 0 when not idle */
+    ddsbench_threadResult *result;
+} ddsbench_poll;
+
 typedef struct ddsbench_threadArg {
     int id;
+    ddsbench_role role;
     char topicName[256];
     ddsbench_context *ctx;
+    ddsbench_threadResult result;
+    int cpu;                        /* Cpu the thread is pinned to, -1 if not pinned to one cpu */
+    int node;                       /* Numa node the thread is pinned to, -1 if not pinned */
+    unsigned long long startNs;     /* Time the thread was started */
+    int tid;                        /* Kernel id of the thread, to tell it from middleware threads */
+    int status;                     /* Value the thread function returned */
+    void *context;                  /* State of the plugin for this thread, NULL until it sets it */
+    const ddsbench_plugin *plugin;  /* Product the thread runs on */
 } ddsbench_threadArg;
 
-typedef struct ddsbench_libraryInterface {
+/* A pool worker runs the endpoints of many topics on a single thread, see
+ * --workers. Endpoints report their results in their own threadArg. */
+typedef struct ddsbench_worker {
+    int id;
+    int count;                      /* Number of endpoints */
+    ddsbench_threadArg **args;      /* Publishers and subscribers of this worker */
+    ddsbench_context *ctx;
+} ddsbench_worker;
+
+/* Pacing wheel that schedules the writers of a pool worker, see ddsbench_wheelInit */
+typedef struct ddsbench_wheel {
+    unsigned long long intervalNs;
+    unsigned long long tickNs;
+    unsigned long long cursor;      /* Tick that is being expired */
+    int slots;
+    int *head;                      /* First entry of every slot, -1 if empty */
+    int *tail;                      /* Last entry of every slot */
+    int *next;                      /* Next entry in the slot of every entry */
+    unsigned long long *due;        /* Deadline of every entry */
+} ddsbench_wheel;
+
+/* Version of ddsbench_plugin and of the harness services below. A plugin
+ * that was built against another version is not loaded. */
+#define DDSBENCH_PLUGIN_VERSION 3
+
+/* Oldest version that is still loaded, version 1 descriptors end before ops */
+#define DDSBENCH_PLUGIN_VERSION_MIN 1
+
+/* Every plugin exports its descriptor under this name */
+#define DDSBENCH_PLUGIN_SYMBOL "ddsbench_pluginDescriptor"
+
+/* Features a plugin supports. The harness only offers the options and modes
+ * that need one of them when the plugin that is loaded has it. */
+typedef enum ddsbench_capability {
+    DDSBENCH_CAP_LOANS = 1 << 0,        /* Readers can loan samples, --take loan */
+    DDSBENCH_CAP_FILTERS = 1 << 1,      /* Filters are evaluated by the product, --filterin dds */
+    DDSBENCH_CAP_LISTENERS = 1 << 2,    /* Subscribers take in a listener with --pollingdelay 0 */
+    DDSBENCH_CAP_DURABILITY = 1 << 3,   /* dpub and dsub, the durability mode */
+    DDSBENCH_CAP_BATCHING = 1 << 4,     /* Writers can send a burst as one batch, --batch */
+    DDSBENCH_CAP_WORKERS = 1 << 5,      /* tworker, --workers, which every plugin with ops has */
+    DDSBENCH_CAP_DDSI = 1 << 6          /* Endpoints match those of other products over DDSI, --pub-lib and --sub-lib */
+} ddsbench_capability;
+
+/* Thread functions return 0 when they completed, nonzero when they failed */
+typedef int (*ddsbench_threadFn)(ddsbench_threadArg *arg);
+typedef int (*ddsbench_workerFn)(ddsbench_worker *worker);
+
+/* Endpoints of the shared measurement loops. A plugin that has ddsbench_ops
+ * only creates endpoints, writes and takes, and the harness runs the latency
+ * and throughput threads on them (src/engine.c), so that every backend is
+ * measured with the same warm-up, timing points, statistics and output. */
+typedef enum ddsbench_endpointKind {
+    DDSBENCH_LATENCY,               /* Ping and pong, the type has no id or count */
+    DDSBENCH_THROUGHPUT             /* The type is keyed by the id of the publisher */
+} ddsbench_endpointKind;
+
+typedef enum ddsbench_durabilityKind {
+    DDSBENCH_VOLATILE,
+    DDSBENCH_TRANSIENT_LOCAL,
+    DDSBENCH_TRANSIENT,
+    DDSBENCH_PERSISTENT
+} ddsbench_durabilityKind;
+
+/* QoS of an endpoint, from the codes of --qos, see ddsbench_qosInit. Every
+ * endpoint keeps all history, except those of the durability mode. */
+typedef struct ddsbench_qos {
+    ddsbench_durabilityKind durability;
+    int reliable;
+    unsigned long long maxBlockingNs;   /* Time a reliable write waits for resources */
+    int maxSamples;                     /* resource_limits.max_samples, -1 is unlimited */
+    int depth;                          /* Samples kept of every instance for late joiners, 0 keeps all */
+} ddsbench_qos;
+
+/* A sample as the engine writes and takes it */
+typedef struct ddsbench_sample {
+    int id;                         /* Publisher that wrote it */
+    int filter;                     /* count % 10, the field filters select on */
+    unsigned long long count;       /* Sequence number of the publisher, DDSBENCH_NO_COUNT if the type has none */
+    unsigned long long timestamp;   /* ddsbench_time of the write, 0 if not known */
+    void *payload;
+    unsigned int length;
+} ddsbench_sample;
+
+#define DDSBENCH_NO_COUNT (~0ULL)
+
+/* Results of ddsbench_ops.write */
+#define DDSBENCH_WRITE_OK 0
+#define DDSBENCH_WRITE_TIMEOUT 1
+#define DDSBENCH_WRITE_ERROR -1
+
+/* Called by a reader when data is available, see ddsbench_ops.readerNew */
+typedef void (*ddsbench_listenerFn)(void *reader, void *arg);
+
+typedef struct ddsbench_ops {
+    /* Create a writer or reader on the topic of the thread (arg->topicName)
+     * in partition, or report why not and return NULL. A reader that gets
+     * a listener calls it from a thread of the product whenever data is
+     * available, the engine only passes one with DDSBENCH_CAP_LISTENERS.
+     * Throughput readers filter with ctx->filter unless ctx->localfilter is
+     * set, in which case the engine applies ctx->predicate. */
+    void* (*writerNew)(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+        const ddsbench_qos *qos);
+    void* (*readerNew)(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+        const ddsbench_qos *qos, ddsbench_listenerFn listener, void *listenerArg);
+    void (*writerFree)(void *writer);
+    void (*readerFree)(void *reader);
+
+    /* Wait until writer and reader (either may be NULL) are matched with the
+     * number of readers and writers the benchmark expects, and set readyNs */
+    void (*waitMatched)(ddsbench_threadArg *arg, void *writer, void *reader);
+
+    /* Write a sample, returning a DDSBENCH_WRITE_ result. The payload may be
+     * referenced until flush with --batch, which sends what a batching
+     * writer holds back and does nothing otherwise. */
+    int (*write)(void *writer, const ddsbench_sample *sample);
+    void (*flush)(void *writer);
+
+    /* Take up to max samples with valid data without blocking, copied or
+     * loaned as ctx->take selects. Their payloads stay valid until takeDone,
+     * which follows every take that returned samples. */
+    int (*take)(void *reader, ddsbench_sample *samples, int max);
+    void (*takeDone)(void *reader);
+
+    /* Block until reader may have data, the benchmark is interrupted or
+     * timeoutNs passed */
+    void (*wait)(void *reader, unsigned long long timeoutNs);
+
+    /* Whether the writers reader was matched with are gone, or disposed the
+     * data, which ends pong */
+    int (*writersGone)(void *reader);
+
+    /* Whether the benchmark was interrupted (SIGINT) */
+    int (*terminated)(void);
+
+    /* Version 3, optional. A wait set over the readers of a pool worker,
+     * waitAny blocks until one of them may have data, the benchmark is
+     * interrupted or timeoutNs passed. The readers stay valid until
+     * waitSetFree. Without them a worker waits on its only reader, or polls
+     * its readers. */
+    void* (*waitSetNew)(void **readers, int count);
+    void (*waitAny)(void *waitSet, unsigned long long timeoutNs);
+    void (*waitSetFree)(void *waitSet);
+
+    /* Version 3, optional. Block until the readers acknowledged what writer
+     * wrote, and until a late joining reader received the history that is
+     * available to it, or timeoutNs passed. For the durability mode, where
+     * a writer or reader with a qos depth the product cannot align is not
+     * created. */
+    void (*waitAcked)(void *writer, unsigned long long timeoutNs);
+    void (*waitHistory)(void *reader, unsigned long long timeoutNs);
+} ddsbench_ops;
+
+struct ddsbench_plugin {
+    unsigned int version;           /* DDSBENCH_PLUGIN_VERSION */
+    const char *name;
+    const char *description;
+    unsigned int capabilities;      /* ddsbench_capability flags */
+
     /* Product initialization */
     int (*init)(ddsbench_context *ctx);
     void (*fini)(void);
 
-    /* Thread callbacks */
-    void* (*lpub)(void *ctx);
-    void* (*lsub)(void *ctx);
-    void* (*tpub)(void *ctx);
-    void* (*tsub)(void *ctx);
+    /* Thread functions of the latency and throughput modes */
+    ddsbench_threadFn lpub;
+    ddsbench_threadFn lsub;
+    ddsbench_threadFn tpub;
+    ddsbench_threadFn tsub;
+
+    /* Optional thread functions, NULL unless the capability is set */
+    ddsbench_threadFn dpub;         /* DDSBENCH_CAP_DURABILITY */
+    ddsbench_threadFn dsub;         /* DDSBENCH_CAP_DURABILITY */
+    ddsbench_workerFn tworker;      /* DDSBENCH_CAP_WORKERS */
+
+    /* Endpoints for the engine, which then runs lpub, lsub, tpub, tsub and
+     * tworker that are left NULL (version 2), and dpub and dsub with
+     * DDSBENCH_CAP_DURABILITY */
+    const ddsbench_ops *ops;
+};
+
+/* A plugin that is loaded by the harness */
+typedef struct ddsbench_libraryInterface {
+    const ddsbench_plugin *plugin;
+    ddsbench_plugin descriptor;     /* Descriptor as the harness completed it, plugin points here */
+    ddsbench_ops ops;               /* Ops as the harness completed it, descriptor.ops points here */
+    char path[PATH_MAX];
 
     /* Pointer to library */
     void *lib;
 } ddsbench_libraryInterface;
 
+/* Harness services, exported by the ddsbench executable to product libraries */
+
+/* Compile a filter expression of the form 'field op value [AND|OR ...]' */
+ddsbench_predicate* ddsbench_predicateCompile(const char *expr);
+void ddsbench_predicateFree(ddsbench_predicate *predicate);
+
+/* Evaluate a predicate against field values indexed by ddsbench_filterField */
+int ddsbench_predicateEval(const ddsbench_predicate *predicate, const long long *fields);
+
+/* CPU time in nanoseconds of the calling thread, or of the whole process */
+unsigned long long ddsbench_cpuTime(int thread);
+
+/* Monotonic time in nanoseconds */
+unsigned long long ddsbench_time(void);
+
+/* A wall clock time in nanoseconds, like a source timestamp, as ddsbench_time */
+unsigned long long ddsbench_timeFromWall(long long wallNs);
+
+/* QoS of an endpoint of the engine from ctx->qos. Latency endpoints hold
+ * 100 samples, throughput writers ctx->maxsamples and throughput readers
+ * DDSBENCH_READER_SAMPLES. */
+#define DDSBENCH_READER_SAMPLES 4000
+
+void ddsbench_qosInit(ddsbench_qos *qos, const ddsbench_context *ctx, ddsbench_endpointKind kind, int writer);
+
+/* Payload buffers of a writer. There are ctx->rotate of them, each starts on
+ * a page of its own and they are filled according to ctx->pattern before
+ * measuring, so all pages are faulted in. ddsbench_payloadNext returns the
+ * buffers in turn, so consecutive samples do not share cache lines. */
+typedef struct ddsbench_payloadPool {
+    unsigned char *base;
+    unsigned long size;             /* Bytes of one payload */
+    unsigned long stride;           /* Distance between payloads, a multiple of the page size */
+    unsigned long mapped;           /* Bytes mapped at base */
+    unsigned int count;
+    unsigned int next;
+} ddsbench_payloadPool;
+
+int ddsbench_payloadAlloc(ddsbench_payloadPool *pool, ddsbench_context *ctx, unsigned long size);
+void* ddsbench_payloadNext(ddsbench_payloadPool *pool);
+void ddsbench_payloadFree(ddsbench_payloadPool *pool);
+
+/* With --verify every payload starts with this header. The checksum is a
+ * CRC32C of the bytes that follow it, so payloads are at least 8 bytes. */
+typedef struct ddsbench_payloadHeader {
+    unsigned int crc;
+    unsigned int length;            /* Length of the complete payload */
+} ddsbench_payloadHeader;
+
+/* CRC32C of length bytes, continuing from crc (0 for the first part) */
+unsigned int ddsbench_crc32c(unsigned int crc, const void *data, unsigned long length);
+
+/* Writers stamp their payloads once when allocated, see ddsbench_payloadAlloc.
+ * Receivers verify every payload over its full length, which counts it as
+ * verified, and as corrupt when it returns nonzero. Receivers time a batch
+ * of verifications in result->verifyNs. */
+void ddsbench_payloadStamp(void *payload, unsigned long length);
+int ddsbench_payloadVerify(const void *payload, unsigned long length, ddsbench_threadResult *result);
+
+/* Receive loops call ddsbench_pollBlock before they take, and block in their
+ * waitset when it returns nonzero. After the (non-blocking) take they call
+ * ddsbench_pollTaken, which returns nonzero if samples were taken and
+ * otherwise spins or yields as configured by ctx->recv. In block mode this
+ * is the usual wait-then-take loop. */
+void ddsbench_pollInit(ddsbench_poll *poll, ddsbench_context *ctx, ddsbench_threadResult *result);
+int ddsbench_pollBlock(ddsbench_poll *poll);
+int ddsbench_pollTaken(ddsbench_poll *poll, int count);
+
+/* Nanoseconds a polling thread has been taking without receiving data */
+unsigned long long ddsbench_pollIdle(ddsbench_poll *poll);
+
+/* Schedule count entries, each due once every intervalNs. The first
+ * deadlines are spread over one interval from now. ddsbench_wheelPop returns
+ * an entry that is due, or -1 and the time until the next one may be. Popped
+ * entries are rescheduled with ddsbench_wheelPush. With an interval of 0 an
+ * entry is due again right away, so callers pop at most count entries before
+ * they do other work. */
+int ddsbench_wheelInit(ddsbench_wheel *wheel, int count, unsigned long long intervalNs, unsigned long long now);
+void ddsbench_wheelFree(ddsbench_wheel *wheel);
+int ddsbench_wheelPop(ddsbench_wheel *wheel, unsigned long long now, unsigned long long *waitNs);
+void ddsbench_wheelPush(ddsbench_wheel *wheel, int entry, unsigned long long now);
+
+/* Add a duration to a histogram */
+void ddsbench_histogramAdd(ddsbench_histogram *histogram, unsigned long long ns);
+
+/* Merge histograms, and return the value below which a fraction q of the samples fall */
+void ddsbench_histogramMerge(ddsbench_histogram *to, const ddsbench_histogram *from);
+unsigned long long ddsbench_histogramQuantile(const ddsbench_histogram *histogram, double q);
+
+/* Report a sample into the statistics of a thread. Writers report the start
+ * and end time of every write call, and whether it timed out (a sample that
+ * timed out is not counted as written). Readers report every sample they
+ * accept with its payload length and its latency from the source timestamp,
+ * or -1 when that is not known. */
+void ddsbench_reportWrite(ddsbench_threadArg *arg, unsigned long long startNs, unsigned long long endNs, int timedOut);
+void ddsbench_reportTake(ddsbench_threadArg *arg, unsigned long long bytes, long long latencyNs);
+
+/* Wait until all threads of the run have matched their entities, and return
+ * the common start time of the measurement. Threads report ready by calling
+ * this once their matched counts reached ctx->readers and ctx->writers (or
+ * DDSBENCH_MATCH_TIMEOUT_NS passed), after setting result.readyNs. Hardware
+ * counters of the calling thread (--perf) start counting here. */
+unsigned long long ddsbench_startBarrier(ddsbench_context *ctx);
+
+/* Count down a latch, or wait until it has reached zero. NULL latches are ignored. */
+void ddsbench_latchArrive(ddsbench_latch *latch);
+void ddsbench_latchWait(ddsbench_latch *latch);
+
 #ifdef __cplusplus
 }
 #endif
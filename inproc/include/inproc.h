@@ -0,0 +1,151 @@
+
+#ifndef INPROC_H
+#define INPROC_H
+
+#include <ddsbench.h>
+
+#ifdef __cplusplus
+extern "c" {
+#endif
+
+/* Set when the benchmark is interrupted (SIGINT) */
+extern volatile int inproc_terminated;
+
+/* Time waits are cut into, so that termination and deadlines are noticed */
+#define INPROC_WAIT_NS 100000000ULL
+
+/* Time a reliable writer waits for space in a full ring, like max_blocking_time */
+#define INPROC_BLOCKING_NS 10000000000ULL
+
+/* A sample as it is stored in a slot of a ring. The header takes one cache
+ * line, the payload follows it. */
+typedef struct inproc_sample {
+    unsigned long long seq;         /* Position of the slot in a multi-producer ring */
+    unsigned long long count;
+    unsigned long long timestamp;   /* ddsbench_time of the write */
+    int id;
+    int filter;
+    unsigned int length;            /* Bytes of payload */
+    unsigned int flags;
+    char pad[24];
+} inproc_sample;
+
+#define INPROC_PAYLOAD(sample) ((unsigned char *)(sample) + sizeof(inproc_sample))
+
+/* A bounded ring of samples with one consumer, the reader that owns it. A
+ * ring with a single producer uses the head and tail counters only. A ring
+ * with more producers is a sequenced queue (after Vyukov's bounded MPMC
+ * queue), where every slot carries the position it may be written or read
+ * at and producers claim positions with compare-and-swap. Producers and
+ * consumers that find the ring full or empty block on a futex, which is
+ * only woken when somebody waits on it. */
+typedef struct inproc_ring {
+    /* Consumer side */
+    unsigned long long head __attribute__((aligned(64)));
+    unsigned long long consumerNext;   /* Next position to peek, ahead of head with loans */
+    unsigned long long cachedTail;
+    unsigned int dataSeq;              /* Futex of consumers waiting for data */
+    unsigned int dataWaiters;
+
+    /* Producer side */
+    unsigned long long tail __attribute__((aligned(64)));
+    unsigned long long producerNext;   /* Next position to reserve, ahead of tail with batches */
+    unsigned long long cachedHead;
+    unsigned int spaceSeq;             /* Futex of producers waiting for space */
+    unsigned int spaceWaiters;
+
+    /* Read only */
+    unsigned char *slots __attribute__((aligned(64)));
+    unsigned long slotSize;
+    unsigned long mapped;
+    unsigned int capacity;             /* A power of two */
+    int multi;                         /* Multiple producers */
+} inproc_ring;
+
+int inproc_ringInit(inproc_ring *ring, unsigned int capacity, unsigned long payload, int multi);
+void inproc_ringFini(inproc_ring *ring);
+
+/* Producers reserve a slot, fill it and commit it. With flush zero a single
+ * producer ring publishes the slot with the next flushed commit, so that a
+ * burst becomes visible at once. Reserve returns NULL when the ring is full. */
+inproc_sample* inproc_ringReserve(inproc_ring *ring, unsigned long long *pos);
+void inproc_ringCommit(inproc_ring *ring, unsigned long long pos, int flush);
+
+/* Publish the samples a single producer committed without flush */
+void inproc_ringFlush(inproc_ring *ring);
+
+/* Consumers peek at the next sample and release it when done, which makes
+ * the slot available again. Peeked samples are released in order, releasing
+ * a sample releases the samples peeked before it. Peek returns NULL when
+ * the ring is empty. */
+inproc_sample* inproc_ringPeek(inproc_ring *ring, unsigned long long *pos);
+void inproc_ringRelease(inproc_ring *ring, unsigned long long pos);
+
+/* Wake consumers after committing, or producers after releasing */
+void inproc_ringWakeData(inproc_ring *ring);
+void inproc_ringWakeSpace(inproc_ring *ring);
+
+/* Block until the ring has data or space, or timeoutNs passed */
+void inproc_ringWaitData(inproc_ring *ring, unsigned long long timeoutNs);
+void inproc_ringWaitSpace(inproc_ring *ring, unsigned long long timeoutNs);
+
+/* Samples in the ring, as seen by the consumer */
+int inproc_ringEmpty(inproc_ring *ring);
+
+/* Endpoints. Topics are matched by name and partition, every reader has a
+ * ring of its own that the writers of its topic write to. */
+typedef struct inproc_topic inproc_topic;
+
+typedef struct inproc_reader {
+    inproc_topic *topic;
+    inproc_ring ring;
+    const ddsbench_predicate *predicate;    /* Content filter, evaluated by writers */
+    int refs;                               /* The reader and the writers that write to it */
+    int closed;                             /* Deleted, writers skip it until they refresh */
+} inproc_reader;
+
+typedef struct inproc_writer {
+    inproc_topic *topic;
+    inproc_reader **readers;                /* Readers matched when the topic last changed */
+    int numReaders;
+    unsigned int generation;
+    int reliable;
+    int batch;                              /* Commit a burst with one flush */
+} inproc_writer;
+
+/* Create endpoints on topic in partition. Readers of a ring with capacity
+ * samples, of single or multiple producers depending on ctx->writers. */
+inproc_writer* inproc_writerNew(ddsbench_threadArg *arg, const char *partition, int reliable);
+void inproc_writerFree(inproc_writer *writer);
+inproc_reader* inproc_readerNew(ddsbench_threadArg *arg, const char *partition, unsigned int capacity);
+void inproc_readerFree(inproc_reader *reader);
+
+/* Write a sample to every matched reader whose filter passes it. A full
+ * reader drops the sample of a best effort writer. Without flush a batching
+ * writer leaves the sample unpublished until the next flushed write or
+ * inproc_writerFlush. Returns nonzero if a reliable reader stayed full for
+ * INPROC_BLOCKING_NS. */
+int inproc_write(inproc_writer *writer, int id, unsigned long long count, const void *payload, unsigned int length, int flush);
+void inproc_writerFlush(inproc_writer *writer);
+
+/* Matched counts, and whether the topic of a reader ever had a writer */
+int inproc_matchedReaders(inproc_writer *writer);
+int inproc_matchedWriters(inproc_reader *reader);
+int inproc_everMatched(inproc_reader *reader);
+
+/* Wait until writer and reader (either may be NULL) are matched with the
+ * number of readers and writers the benchmark expects, and set readyNs */
+void inproc_waitMatched(ddsbench_threadArg *arg, inproc_writer *writer, inproc_reader *reader);
+
+/* Endpoints the harness runs the latency and throughput threads on */
+extern const ddsbench_ops inproc_ops;
+
+/* Functions of the plugin, exported through its descriptor in inproc.c */
+int init(ddsbench_context *ctx);
+void fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,393 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <inproc.h>
+
+#define LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+
+/* Endpoints of a topic in a partition. The reader list only changes under
+ * inproc_lock, writers copy it when they see that generation changed. */
+struct inproc_topic {
+    char name[512];
+    inproc_reader **readers;
+    int numReaders;
+    int maxReaders;
+    int numWriters;
+    int everMatched;                /* A writer was created on the topic */
+    unsigned int generation;
+    inproc_topic *next;
+};
+
+volatile int inproc_terminated;
+
+static pthread_mutex_t inproc_lock = PTHREAD_MUTEX_INITIALIZER;
+static inproc_topic *inproc_topics;
+static struct sigaction oldAction;
+
+static void CtrlHandler(int fdwCtrlType)
+{
+    inproc_terminated = 1;
+}
+
+int init(ddsbench_context *ctx)
+{
+    struct sigaction sat;
+
+    sat.sa_handler = CtrlHandler;
+    sigemptyset(&sat.sa_mask);
+    sat.sa_flags = 0;
+    sigaction(SIGINT, &sat, &oldAction);
+    inproc_terminated = 0;
+
+    /* Readers process samples in the ring unless copies are requested */
+    if (ctx->take == DDSBENCH_TAKE_DEFAULT) {
+        ctx->take = DDSBENCH_TAKE_LOAN;
+    }
+
+    return 0;
+}
+
+void fini(void)
+{
+    inproc_topic *topic;
+
+    sigaction(SIGINT, &oldAction, 0);
+
+    while ((topic = inproc_topics)) {
+        inproc_topics = topic->next;
+        free(topic->readers);
+        free(topic);
+    }
+}
+
+/* The plugin descriptor. Writers and readers of a process exchange samples
+ * through rings in memory, there is no middleware to listen, to keep
+ * historical data or to run endpoints on workers. */
+const ddsbench_plugin ddsbench_pluginDescriptor = {
+    .version = DDSBENCH_PLUGIN_VERSION,
+    .name = "inproc",
+    .description = "in-process lock-free rings, no middleware",
+    .capabilities = DDSBENCH_CAP_LOANS | DDSBENCH_CAP_FILTERS | DDSBENCH_CAP_BATCHING,
+    .init = init,
+    .fini = fini,
+    .ops = &inproc_ops
+};
+
+/* Look up a topic, or create it. Called with inproc_lock held. */
+static inproc_topic* topicGet(const char *topicName, const char *partition)
+{
+    char name[512];
+    inproc_topic *topic;
+
+    snprintf(name, sizeof(name), "%s/%s", partition, topicName);
+    for (topic = inproc_topics; topic; topic = topic->next) {
+        if (!strcmp(topic->name, name)) {
+            return topic;
+        }
+    }
+
+    if (!(topic = calloc(1, sizeof(inproc_topic)))) {
+        return NULL;
+    }
+    strcpy(topic->name, name);
+    topic->next = inproc_topics;
+    inproc_topics = topic;
+    return topic;
+}
+
+/* Drop a reference to a reader. Called with inproc_lock held. */
+static void readerRelease(inproc_reader *reader)
+{
+    if (!--reader->refs) {
+        inproc_ringFini(&reader->ring);
+        free(reader);
+    }
+}
+
+/* Copy the reader list of the topic if it changed since the last write */
+static int writerRefresh(inproc_writer *writer)
+{
+    inproc_topic *topic = writer->topic;
+    int i, result = 0;
+
+    if (LOAD(&topic->generation) == writer->generation) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&inproc_lock);
+    for (i = 0; i < writer->numReaders; i++) {
+        readerRelease(writer->readers[i]);
+    }
+    writer->numReaders = 0;
+    free(writer->readers);
+    writer->readers = NULL;
+    if (topic->numReaders) {
+        if (!(writer->readers = malloc(topic->numReaders * sizeof(inproc_reader*)))) {
+            result = -1;
+            goto error;
+        }
+        for (i = 0; i < topic->numReaders; i++) {
+            writer->readers[i] = topic->readers[i];
+            writer->readers[i]->refs++;
+        }
+        writer->numReaders = topic->numReaders;
+    }
+    writer->generation = topic->generation;
+error:
+    pthread_mutex_unlock(&inproc_lock);
+    return result;
+}
+
+inproc_writer* inproc_writerNew(ddsbench_threadArg *arg, const char *partition, int reliable)
+{
+    inproc_writer *writer;
+    int i;
+
+    if (!(writer = calloc(1, sizeof(inproc_writer)))) {
+        return NULL;
+    }
+    writer->reliable = reliable;
+    writer->batch = arg->ctx->batch;
+
+    pthread_mutex_lock(&inproc_lock);
+    if (!(writer->topic = topicGet(arg->topicName, partition))) {
+        goto error;
+    }
+
+    /* Readers that expect a single writer have rings without producer synchronization */
+    for (i = 0; i < writer->topic->numReaders && writer->topic->numWriters; i++) {
+        if (!writer->topic->readers[i]->ring.multi) {
+            printf("pub %d: topic %s has more writers than --writers %u\n",
+                arg->id, arg->topicName, arg->ctx->writers);
+            goto error;
+        }
+    }
+    writer->topic->numWriters++;
+    writer->topic->everMatched = 1;
+    writer->generation = writer->topic->generation - 1;
+    pthread_mutex_unlock(&inproc_lock);
+
+    if (writerRefresh(writer)) {
+        inproc_writerFree(writer);
+        return NULL;
+    }
+    return writer;
+error:
+    pthread_mutex_unlock(&inproc_lock);
+    free(writer);
+    return NULL;
+}
+
+void inproc_writerFree(inproc_writer *writer)
+{
+    int i;
+
+    if (!writer) {
+        return;
+    }
+
+    /* Readers wake up to the last samples, and notice that the writer is gone */
+    __atomic_sub_fetch(&writer->topic->numWriters, 1, __ATOMIC_RELEASE);
+    inproc_writerFlush(writer);
+
+    pthread_mutex_lock(&inproc_lock);
+    for (i = 0; i < writer->numReaders; i++) {
+        readerRelease(writer->readers[i]);
+    }
+    pthread_mutex_unlock(&inproc_lock);
+    free(writer->readers);
+    free(writer);
+}
+
+inproc_reader* inproc_readerNew(ddsbench_threadArg *arg, const char *partition, unsigned int capacity)
+{
+    inproc_reader *reader;
+    inproc_topic *topic;
+
+    if (!(reader = calloc(1, sizeof(inproc_reader)))) {
+        return NULL;
+    }
+    if (inproc_ringInit(&reader->ring, capacity, arg->ctx->payload, arg->ctx->writers != 1)) {
+        printf("sub %d: failed to map a ring of %u samples of %u bytes\n", arg->id, capacity, arg->ctx->payload);
+        free(reader);
+        return NULL;
+    }
+    reader->refs = 1;
+
+    /* Writers evaluate the filter, unless it is applied after take */
+    if (arg->ctx->filter && !arg->ctx->localfilter) {
+        if (arg->ctx->predicate) {
+            reader->predicate = arg->ctx->predicate;
+        } else {
+            printf("sub %d: filter '%s' is not supported, ignoring\n", arg->id, arg->ctx->filter);
+        }
+    }
+
+    pthread_mutex_lock(&inproc_lock);
+    if (!(topic = topicGet(arg->topicName, partition))) {
+        goto error;
+    }
+    if (topic->numReaders == topic->maxReaders) {
+        int max = topic->maxReaders ? topic->maxReaders * 2 : 4;
+        inproc_reader **readers = realloc(topic->readers, max * sizeof(inproc_reader*));
+        if (!readers) {
+            goto error;
+        }
+        topic->readers = readers;
+        topic->maxReaders = max;
+    }
+    reader->topic = topic;
+    topic->readers[topic->numReaders] = reader;
+    __atomic_add_fetch(&topic->numReaders, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&topic->generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&inproc_lock);
+
+    return reader;
+error:
+    pthread_mutex_unlock(&inproc_lock);
+    inproc_ringFini(&reader->ring);
+    free(reader);
+    return NULL;
+}
+
+void inproc_readerFree(inproc_reader *reader)
+{
+    inproc_topic *topic;
+    int i;
+
+    if (!reader) {
+        return;
+    }
+    topic = reader->topic;
+
+    pthread_mutex_lock(&inproc_lock);
+    for (i = 0; i < topic->numReaders; i++) {
+        if (topic->readers[i] == reader) {
+            topic->readers[i] = topic->readers[topic->numReaders - 1];
+            __atomic_sub_fetch(&topic->numReaders, 1, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    __atomic_add_fetch(&topic->generation, 1, __ATOMIC_RELEASE);
+
+    /* Writers that still hold it stop writing to it, and stop waiting for space */
+    __atomic_store_n(&reader->closed, 1, __ATOMIC_RELEASE);
+    inproc_ringWakeSpace(&reader->ring);
+    readerRelease(reader);
+    pthread_mutex_unlock(&inproc_lock);
+}
+
+int inproc_write(inproc_writer *writer, int id, unsigned long long count, const void *payload, unsigned int length, int flush)
+{
+    long long fields[DDSBENCH_FIELD_MAX];
+    unsigned long long now, pos;
+    int i, timedOut = 0;
+
+    writerRefresh(writer);
+    fields[DDSBENCH_FIELD_ID] = id;
+    fields[DDSBENCH_FIELD_FILTER] = count % 10;
+    fields[DDSBENCH_FIELD_COUNT] = count;
+    flush = flush || !writer->batch;
+
+    now = ddsbench_time();
+    for (i = 0; i < writer->numReaders; i++) {
+        inproc_reader *reader = writer->readers[i];
+        inproc_sample *sample;
+
+        if (LOAD(&reader->closed) ||
+            (reader->predicate && !ddsbench_predicateEval(reader->predicate, fields))) {
+            continue;
+        }
+
+        /* A full ring blocks a reliable writer, after the batch so far is published */
+        if (!(sample = inproc_ringReserve(&reader->ring, &pos))) {
+            unsigned long long deadline = now + INPROC_BLOCKING_NS;
+
+            if (!writer->reliable) {
+                continue;
+            }
+            inproc_ringFlush(&reader->ring);
+            inproc_ringWakeData(&reader->ring);
+            while (!(sample = inproc_ringReserve(&reader->ring, &pos))) {
+                unsigned long long t = ddsbench_time();
+                if (inproc_terminated || LOAD(&reader->closed) || t >= deadline) {
+                    break;
+                }
+                inproc_ringWaitSpace(&reader->ring, deadline - t < INPROC_WAIT_NS ? deadline - t : INPROC_WAIT_NS);
+            }
+            if (!sample) {
+                timedOut = !LOAD(&reader->closed) && !inproc_terminated;
+                continue;
+            }
+        }
+
+        sample->count = count;
+        sample->timestamp = now;
+        sample->id = id;
+        sample->filter = count % 10;
+        sample->length = length;
+        sample->flags = 0;
+        memcpy(INPROC_PAYLOAD(sample), payload, length);
+        inproc_ringCommit(&reader->ring, pos, flush);
+        if (flush) {
+            inproc_ringWakeData(&reader->ring);
+        }
+    }
+
+    return timedOut;
+}
+
+void inproc_writerFlush(inproc_writer *writer)
+{
+    int i;
+
+    for (i = 0; i < writer->numReaders; i++) {
+        if (!LOAD(&writer->readers[i]->closed)) {
+            inproc_ringFlush(&writer->readers[i]->ring);
+            inproc_ringWakeData(&writer->readers[i]->ring);
+        }
+    }
+}
+
+int inproc_matchedReaders(inproc_writer *writer)
+{
+    return LOAD(&writer->topic->numReaders);
+}
+
+int inproc_matchedWriters(inproc_reader *reader)
+{
+    return LOAD(&reader->topic->numWriters);
+}
+
+int inproc_everMatched(inproc_reader *reader)
+{
+    return LOAD(&reader->topic->everMatched);
+}
+
+void inproc_waitMatched(ddsbench_threadArg *arg, inproc_writer *writer, inproc_reader *reader)
+{
+    unsigned long long deadline = ddsbench_time() + DDSBENCH_MATCH_TIMEOUT_NS;
+    struct timespec delay = { 0, 1000000 };
+
+    for (;;) {
+        if ((!writer || inproc_matchedReaders(writer) >= (int)arg->ctx->readers) &&
+            (!reader || inproc_matchedWriters(reader) >= (int)arg->ctx->writers)) {
+            break;
+        }
+        if (inproc_terminated || ddsbench_time() > deadline) {
+            printf("%s %d: matched %d of %u readers and %d of %u writers, starting anyway\n",
+                arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id,
+                writer ? inproc_matchedReaders(writer) : 0, writer ? arg->ctx->readers : 0,
+                reader ? inproc_matchedWriters(reader) : 0, reader ? arg->ctx->writers : 0);
+            break;
+        }
+        nanosleep(&delay, NULL);
+    }
+
+    arg->result.readyNs = ddsbench_time() - arg->startNs;
+}
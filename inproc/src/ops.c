@@ -0,0 +1,173 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <inproc.h>
+
+/* Samples in the ring of a latency reader, a roundtrip has one in flight */
+#define ROUNDTRIP_RING_SAMPLES 16
+
+/* Samples in the ring of a throughput reader when --maxsamples is unlimited,
+ * and the most memory a ring maps. The ring is the history of the writers as
+ * well, so it is sized by the resource limits of the writers. */
+#define THROUGHPUT_RING_SAMPLES 4096
+#define THROUGHPUT_RING_BYTES (256UL * 1024 * 1024)
+
+/* The most memory a copying reader takes samples into */
+#define COPY_BYTES (16UL * 1024 * 1024)
+
+/* A reader of the engine, which takes samples in place or copies them out */
+typedef struct opsReader {
+    inproc_reader *reader;
+    unsigned char *copies;          /* Copies of the samples taken, NULL when loaned */
+    unsigned long slotSize;
+    int maxTake;
+    unsigned long long pos;         /* Position of the last sample taken */
+    int taken;                      /* Samples taken and not yet released */
+} opsReader;
+
+static void* opsWriterNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos)
+{
+    return inproc_writerNew(arg, partition, qos->reliable);
+}
+
+static void* opsReaderNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos, ddsbench_listenerFn listener, void *listenerArg)
+{
+    ddsbench_context *ctx = arg->ctx;
+    unsigned long slotSize = sizeof(inproc_sample) + ctx->payload;
+    unsigned int capacity = ROUNDTRIP_RING_SAMPLES;
+    opsReader *reader;
+
+    if (kind == DDSBENCH_THROUGHPUT) {
+        capacity = ctx->maxsamples > 0 ? (unsigned int)ctx->maxsamples : THROUGHPUT_RING_SAMPLES;
+        if (capacity > THROUGHPUT_RING_BYTES / slotSize) {
+            capacity = THROUGHPUT_RING_BYTES / slotSize;
+        }
+    }
+
+    if (!(reader = calloc(1, sizeof(opsReader)))) {
+        printf("sub %d: out of memory\n", arg->id);
+        return NULL;
+    }
+    reader->slotSize = slotSize;
+    reader->maxTake = COPY_BYTES / slotSize ? COPY_BYTES / slotSize : 1;
+
+    /* Bound the memory of the copies a reader takes */
+    if (ctx->take == DDSBENCH_TAKE_COPY && !(reader->copies = malloc(reader->maxTake * slotSize))) {
+        printf("sub %d: out of memory\n", arg->id);
+        free(reader);
+        return NULL;
+    }
+    if (!(reader->reader = inproc_readerNew(arg, partition, capacity))) {
+        free(reader->copies);
+        free(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+static void opsWriterFree(void *writer)
+{
+    inproc_writerFree(writer);
+}
+
+static void opsReaderFree(void *ptr)
+{
+    opsReader *reader = ptr;
+
+    inproc_readerFree(reader->reader);
+    free(reader->copies);
+    free(reader);
+}
+
+static void opsWaitMatched(ddsbench_threadArg *arg, void *writer, void *reader)
+{
+    inproc_waitMatched(arg, writer, reader ? ((opsReader *)reader)->reader : NULL);
+}
+
+static int opsWrite(void *writer, const ddsbench_sample *sample)
+{
+    return inproc_write(writer, sample->id, sample->count, sample->payload, sample->length, 0) ?
+        DDSBENCH_WRITE_TIMEOUT : DDSBENCH_WRITE_OK;
+}
+
+static void opsFlush(void *writer)
+{
+    inproc_writerFlush(writer);
+}
+
+/* Take the samples in the ring, copied out or in place */
+static int opsTake(void *ptr, ddsbench_sample *samples, int max)
+{
+    opsReader *reader = ptr;
+    inproc_sample *sample;
+    int n;
+
+    if (reader->copies && max > reader->maxTake) {
+        max = reader->maxTake;
+    }
+    for (n = 0; n < max && (sample = inproc_ringPeek(&reader->reader->ring, &reader->pos)); n++) {
+        if (reader->copies) {
+            sample = memcpy(reader->copies + n * reader->slotSize, sample, sizeof(inproc_sample) + sample->length);
+        }
+        samples[n].id = sample->id;
+        samples[n].filter = sample->filter;
+        samples[n].count = sample->count;
+        samples[n].timestamp = sample->timestamp;
+        samples[n].payload = INPROC_PAYLOAD(sample);
+        samples[n].length = sample->length;
+    }
+    if (n && reader->copies) {
+        inproc_ringRelease(&reader->reader->ring, reader->pos);
+        inproc_ringWakeSpace(&reader->reader->ring);
+    } else {
+        reader->taken = n;
+    }
+    return n;
+}
+
+static void opsTakeDone(void *ptr)
+{
+    opsReader *reader = ptr;
+
+    if (reader->taken) {
+        inproc_ringRelease(&reader->reader->ring, reader->pos);
+        inproc_ringWakeSpace(&reader->reader->ring);
+        reader->taken = 0;
+    }
+}
+
+static void opsWait(void *reader, unsigned long long timeoutNs)
+{
+    inproc_ringWaitData(&((opsReader *)reader)->reader->ring, timeoutNs);
+}
+
+static int opsWritersGone(void *ptr)
+{
+    inproc_reader *reader = ((opsReader *)ptr)->reader;
+
+    return inproc_everMatched(reader) && !inproc_matchedWriters(reader) && inproc_ringEmpty(&reader->ring);
+}
+
+static int opsTerminated(void)
+{
+    return inproc_terminated;
+}
+
+const ddsbench_ops inproc_ops = {
+    .writerNew = opsWriterNew,
+    .readerNew = opsReaderNew,
+    .writerFree = opsWriterFree,
+    .readerFree = opsReaderFree,
+    .waitMatched = opsWaitMatched,
+    .write = opsWrite,
+    .flush = opsFlush,
+    .take = opsTake,
+    .takeDone = opsTakeDone,
+    .wait = opsWait,
+    .writersGone = opsWritersGone,
+    .terminated = opsTerminated
+};
@@ -0,0 +1,226 @@
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include <inproc.h>
+
+#define LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define STORE(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+
+static void futexWait(unsigned int *word, unsigned int value, unsigned long long timeoutNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = timeoutNs / 1000000000ULL;
+    ts.tv_nsec = timeoutNs % 1000000000ULL;
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, &ts, NULL, 0);
+}
+
+static void futexWake(unsigned int *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static inproc_sample* slot(inproc_ring *ring, unsigned long long pos)
+{
+    return (inproc_sample *)(ring->slots + (pos & (ring->capacity - 1)) * ring->slotSize);
+}
+
+int inproc_ringInit(inproc_ring *ring, unsigned int capacity, unsigned long payload, int multi)
+{
+    unsigned int i;
+
+    memset(ring, 0, sizeof(inproc_ring));
+    ring->capacity = 2;
+    while (ring->capacity < capacity) {
+        ring->capacity <<= 1;
+    }
+    ring->slotSize = (sizeof(inproc_sample) + payload + 63) & ~63UL;
+    ring->mapped = ring->slotSize * ring->capacity;
+    ring->multi = multi;
+
+    /* Slots are touched now, so that writing them does not fault later */
+    ring->slots = mmap(NULL, ring->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (ring->slots == MAP_FAILED) {
+        ring->slots = NULL;
+        return -1;
+    }
+    for (i = 0; i < ring->capacity; i++) {
+        slot(ring, i)->seq = i;
+    }
+
+    return 0;
+}
+
+void inproc_ringFini(inproc_ring *ring)
+{
+    if (ring->slots) {
+        munmap(ring->slots, ring->mapped);
+        ring->slots = NULL;
+    }
+}
+
+inproc_sample* inproc_ringReserve(inproc_ring *ring, unsigned long long *pos)
+{
+    inproc_sample *sample;
+    unsigned long long p;
+
+    if (!ring->multi) {
+        p = ring->producerNext;
+        if (p - ring->cachedHead >= ring->capacity) {
+            ring->cachedHead = LOAD(&ring->head);
+            if (p - ring->cachedHead >= ring->capacity) {
+                return NULL;
+            }
+        }
+        ring->producerNext = p + 1;
+        *pos = p;
+        return slot(ring, p);
+    }
+
+    /* A slot is free for position p when its sequence is p */
+    p = __atomic_load_n(&ring->producerNext, __ATOMIC_RELAXED);
+    for (;;) {
+        long long diff;
+        sample = slot(ring, p);
+        diff = (long long)(LOAD(&sample->seq) - p);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->producerNext, &p, p + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *pos = p;
+                return sample;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            p = __atomic_load_n(&ring->producerNext, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void inproc_ringCommit(inproc_ring *ring, unsigned long long pos, int flush)
+{
+    if (ring->multi) {
+        STORE(&slot(ring, pos)->seq, pos + 1);
+    } else if (flush) {
+        STORE(&ring->tail, ring->producerNext);
+    }
+}
+
+void inproc_ringFlush(inproc_ring *ring)
+{
+    if (!ring->multi) {
+        STORE(&ring->tail, ring->producerNext);
+    }
+}
+
+inproc_sample* inproc_ringPeek(inproc_ring *ring, unsigned long long *pos)
+{
+    inproc_sample *sample;
+    unsigned long long p;
+
+    if (!ring->multi) {
+        p = ring->consumerNext;
+        if (p == ring->cachedTail) {
+            ring->cachedTail = LOAD(&ring->tail);
+            if (p == ring->cachedTail) {
+                return NULL;
+            }
+        }
+        ring->consumerNext = p + 1;
+        *pos = p;
+        return slot(ring, p);
+    }
+
+    /* A slot holds the sample of position p when its sequence is p + 1 */
+    p = ring->consumerNext;
+    sample = slot(ring, p);
+    if (LOAD(&sample->seq) != p + 1) {
+        return NULL;
+    }
+    ring->consumerNext = p + 1;
+    *pos = p;
+    return sample;
+}
+
+void inproc_ringRelease(inproc_ring *ring, unsigned long long pos)
+{
+    if (ring->multi) {
+        /* Samples are released in order, so the slots before pos are released too */
+        unsigned long long p = ring->head;
+
+        for (; p <= pos; p++) {
+            STORE(&slot(ring, p)->seq, p + ring->capacity);
+        }
+    }
+    STORE(&ring->head, pos + 1);
+}
+
+int inproc_ringEmpty(inproc_ring *ring)
+{
+    unsigned long long p = ring->consumerNext;
+
+    if (!ring->multi) {
+        return p == LOAD(&ring->tail);
+    }
+    return LOAD(&slot(ring, p)->seq) != p + 1;
+}
+
+static int ringFull(inproc_ring *ring)
+{
+    unsigned long long p = __atomic_load_n(&ring->producerNext, __ATOMIC_RELAXED);
+
+    if (!ring->multi) {
+        return p - LOAD(&ring->head) >= ring->capacity;
+    }
+    return (long long)(LOAD(&slot(ring, p)->seq) - p) < 0;
+}
+
+/* The waiter announces itself before it checks the ring, the waker checks
+ * for waiters after it changed the ring, so that one of them sees the other */
+void inproc_ringWakeData(inproc_ring *ring)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->dataWaiters, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&ring->dataSeq, 1, __ATOMIC_SEQ_CST);
+        futexWake(&ring->dataSeq);
+    }
+}
+
+void inproc_ringWakeSpace(inproc_ring *ring)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->spaceWaiters, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&ring->spaceSeq, 1, __ATOMIC_SEQ_CST);
+        futexWake(&ring->spaceSeq);
+    }
+}
+
+void inproc_ringWaitData(inproc_ring *ring, unsigned long long timeoutNs)
+{
+    unsigned int seq;
+
+    __atomic_add_fetch(&ring->dataWaiters, 1, __ATOMIC_SEQ_CST);
+    seq = __atomic_load_n(&ring->dataSeq, __ATOMIC_SEQ_CST);
+    if (inproc_ringEmpty(ring)) {
+        futexWait(&ring->dataSeq, seq, timeoutNs);
+    }
+    __atomic_sub_fetch(&ring->dataWaiters, 1, __ATOMIC_SEQ_CST);
+}
+
+void inproc_ringWaitSpace(inproc_ring *ring, unsigned long long timeoutNs)
+{
+    unsigned int seq;
+
+    __atomic_add_fetch(&ring->spaceWaiters, 1, __ATOMIC_SEQ_CST);
+    seq = __atomic_load_n(&ring->spaceSeq, __ATOMIC_SEQ_CST);
+    if (ringFull(ring)) {
+        futexWait(&ring->spaceSeq, seq, timeoutNs);
+    }
+    __atomic_sub_fetch(&ring->spaceWaiters, 1, __ATOMIC_SEQ_CST);
+}
@@ -11,6 +11,24 @@ extern dds_entity_t ddsbench_dp;
 
 //DDS_TopicQos* ddsbench_getQos(char *qos);
 
+/* Endpoints the harness runs all threads on */
+extern const ddsbench_ops lite_ops;
+
+/* Functions of the plugin, exported through its descriptor in lite.c */
+int init(ddsbench_context *ctx);
+void fini(void);
+
+/* Wait until writer and reader (either may be 0) are matched with the
+ * number of readers and writers the benchmark expects, and set readyNs */
+void ddsbench_waitMatched (ddsbench_threadArg *arg, dds_entity_t writer, dds_entity_t reader);
+
+/* Take up to maxs samples. In copy mode samples points to buffers of the
+ * application that are filled in, with --take loan the pointers are replaced
+ * by samples loaned from the reader. Return them with ddsbench_takeDone once
+ * they have been used. */
+int ddsbench_take (dds_entity_t reader, void ** samples, uint32_t maxs, dds_sample_info_t * info, ddsbench_context * ctx);
+void ddsbench_takeDone (dds_entity_t reader, void ** samples, int count, ddsbench_context * ctx);
+
 #ifdef __cplusplus
 }
 #endif
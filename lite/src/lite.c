@@ -1,6 +1,7 @@
 
 #include <ddsbench.h>
 #include <../idl/ddsbench.h>
+#include <lite.h>
 
 dds_condition_t terminated;
 dds_entity_t ddsbench_dp;
@@ -23,6 +24,10 @@ static struct sigaction oldAction;
 int init(ddsbench_context *ctx) {
     int status;
 
+    /* Created before the handler that triggers it, shared by all threads */
+
+    terminated = dds_guardcondition_create ();
+
 #ifdef _WIN32
     SetConsoleCtrlHandler ((PHANDLER_ROUTINE)CtrlHandler, TRUE);
 #else
@@ -33,12 +38,23 @@ int init(ddsbench_context *ctx) {
     sigaction (SIGINT, &sat, &oldAction);
 #endif
 
+    /* Readers copy into their own buffers unless loans are requested */
+
+    if (ctx->take == DDSBENCH_TAKE_DEFAULT)
+    {
+      ctx->take = DDSBENCH_TAKE_COPY;
+    }
+
     status = dds_init (0, NULL);
     DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
 
     status = dds_participant_create (&ddsbench_dp, DDS_DOMAIN_DEFAULT, NULL, NULL);
     DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
 
+    /* Writes are held back until dds_write_flush only with --batch */
+
+    dds_write_set_batch (ctx->batch != 0);
+
     return 0;
 }
 
@@ -52,3 +68,67 @@ void fini(void) {
     dds_condition_delete (terminated);
     dds_fini ();
 }
+
+/* The plugin descriptor. The engine runs all threads on lite_ops,
+ * subscribers take in a listener with pollingdelay 0. Without a durability
+ * service the durability mode aligns transient local history only. */
+
+const ddsbench_plugin ddsbench_pluginDescriptor = {
+  .version = DDSBENCH_PLUGIN_VERSION,
+  .name = "lite",
+  .description = "Vortex Lite",
+  .capabilities = DDSBENCH_CAP_LOANS | DDSBENCH_CAP_FILTERS | DDSBENCH_CAP_LISTENERS |
+                  DDSBENCH_CAP_DURABILITY | DDSBENCH_CAP_BATCHING | DDSBENCH_CAP_DDSI,
+  .init = init,
+  .fini = fini,
+  .ops = &lite_ops
+};
+
+void ddsbench_waitMatched (ddsbench_threadArg *arg, dds_entity_t writer, dds_entity_t reader) {
+    dds_publication_matched_status_t pms = { 0 };
+    dds_subscription_matched_status_t sms = { 0 };
+    unsigned long long deadline = ddsbench_time () + DDSBENCH_MATCH_TIMEOUT_NS;
+    int status;
+
+    for (;;) {
+        if (writer) {
+            status = dds_get_publication_matched_status (writer, &pms);
+            DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+        }
+        if (reader) {
+            status = dds_get_subscription_matched_status (reader, &sms);
+            DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+        }
+        if ((!writer || pms.current_count >= (int32_t) arg->ctx->readers) &&
+            (!reader || sms.current_count >= (int32_t) arg->ctx->writers)) {
+            break;
+        }
+        if ((terminated && dds_condition_triggered (terminated)) || ddsbench_time () > deadline) {
+            printf ("%s %d: matched %d of %u readers and %d of %u writers, starting anyway\n",
+                arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id,
+                writer ? pms.current_count : 0, writer ? arg->ctx->readers : 0,
+                reader ? sms.current_count : 0, reader ? arg->ctx->writers : 0);
+            break;
+        }
+        dds_sleepfor (DDS_MSECS (1));
+    }
+
+    arg->result.readyNs = ddsbench_time () - arg->startNs;
+}
+
+int ddsbench_take (dds_entity_t reader, void ** samples, uint32_t maxs, dds_sample_info_t * info, ddsbench_context * ctx) {
+    /* A null first pointer makes the reader loan its own samples */
+    if (ctx->take == DDSBENCH_TAKE_LOAN) {
+        samples[0] = NULL;
+    }
+    return dds_take (reader, samples, maxs, info, 0);
+}
+
+void ddsbench_takeDone (dds_entity_t reader, void ** samples, int count, ddsbench_context * ctx) {
+    int status;
+
+    if (ctx->take == DDSBENCH_TAKE_LOAN && count > 0) {
+        status = dds_return_loan (reader, samples, count);
+        DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+    }
+}
@@ -0,0 +1,586 @@
+
+#include <pthread.h>
+
+#include <ddsbench.h>
+#include <../idl/ddsbench.h>
+#include <lite.h>
+
+#define MAX_SAMPLES 100
+
+/*
+ * Endpoints of the engine. Every endpoint is created on a participant of its
+ * own, like the threads of the benchmark had before, so that the filter set
+ * on the topic of a reader applies to that reader only.
+ */
+
+typedef struct lite_endpoint
+{
+  ddsbench_threadArg * arg;
+  ddsbench_endpointKind kind;
+  dds_entity_t participant;
+  dds_entity_t topic;
+  dds_entity_t entity;
+
+  /* Readers only */
+  dds_waitset_t waitSet;
+  dds_condition_t readCond;
+  ddsbench_listenerFn listenerFn;
+  void * listenerArg;
+  bool gone;                      /* An instance lost its writers, or was disposed */
+  int taken;                      /* Samples of the last take, returned by takeDone */
+  void * samples[MAX_SAMPLES];
+  dds_sample_info_t info[MAX_SAMPLES];
+  union
+  {
+    ddsbench_Latency latency[MAX_SAMPLES];
+    ddsbench_Throughput throughput[MAX_SAMPLES];
+  } data;
+  struct lite_endpoint * next;    /* In the list of readers with a listener */
+} lite_endpoint;
+
+/* Lite calls the filter of a topic and the listener of a reader without an
+ * argument. The predicate is the same for every reader, the listener finds
+ * its endpoint in the list of readers with a listener. A listener that runs
+ * before dds_reader_create returned claims the reader that is being created,
+ * which is one at a time. */
+
+static ddsbench_predicate * topicPredicate = NULL;
+static lite_endpoint * listeners = NULL;
+static pthread_mutex_t listenersLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t createLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Threads of the harness register with Lite before they use it */
+static __thread bool threadInitialized = false;
+
+static bool topic_filter (const void * sample)
+{
+  const ddsbench_Throughput * this_sample = sample;
+  long long fields[DDSBENCH_FIELD_MAX];
+
+  fields[DDSBENCH_FIELD_ID] = this_sample->id;
+  fields[DDSBENCH_FIELD_FILTER] = this_sample->filter;
+  fields[DDSBENCH_FIELD_COUNT] = this_sample->count;
+  return ddsbench_predicateEval (topicPredicate, fields);
+}
+
+static void data_available_handler (dds_entity_t reader)
+{
+  lite_endpoint * endpoint;
+
+  pthread_mutex_lock (&listenersLock);
+  for (endpoint = listeners; endpoint && endpoint->entity != reader; endpoint = endpoint->next)
+  {
+  }
+  if (!endpoint)
+  {
+    for (endpoint = listeners; endpoint && endpoint->entity; endpoint = endpoint->next)
+    {
+    }
+    if (endpoint)
+    {
+      endpoint->entity = reader;
+    }
+  }
+  pthread_mutex_unlock (&listenersLock);
+
+  if (endpoint)
+  {
+    endpoint->listenerFn (endpoint, endpoint->listenerArg);
+  }
+}
+
+/* QoS of a writer or reader. Lite has no durability service, so transient
+ * and persistent data is kept by the writers, like transient local. */
+
+static dds_qos_t * endpoint_qos (const ddsbench_qos * settings)
+{
+  dds_qos_t * qos = dds_qos_create ();
+
+  if (settings->depth)
+  {
+    dds_qset_history (qos, DDS_HISTORY_KEEP_LAST, settings->depth);
+  }
+  else
+  {
+    dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  }
+  dds_qset_resource_limits (qos, settings->maxSamples < 0 ? DDS_LENGTH_UNLIMITED : settings->maxSamples,
+    DDS_LENGTH_UNLIMITED, DDS_LENGTH_UNLIMITED);
+  if (settings->reliable)
+  {
+    dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, (dds_duration_t) settings->maxBlockingNs);
+  }
+  else
+  {
+    dds_qset_reliability (qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+  }
+  dds_qset_durability (qos, settings->durability == DDSBENCH_VOLATILE ?
+    DDS_DURABILITY_VOLATILE : DDS_DURABILITY_TRANSIENT_LOCAL);
+  return qos;
+}
+
+static lite_endpoint * endpoint_new (ddsbench_threadArg * arg, ddsbench_endpointKind kind)
+{
+  lite_endpoint * endpoint;
+  char threadName[16];
+  int status;
+
+  if (!threadInitialized)
+  {
+    snprintf (threadName, sizeof (threadName), "%s_%d", arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id);
+    status = dds_thread_init (threadName);
+    DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+    threadInitialized = true;
+  }
+
+  endpoint = calloc (1, sizeof (*endpoint));
+  if (!endpoint)
+  {
+    printf ("%s %d: out of memory\n", arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id);
+    return NULL;
+  }
+  endpoint->arg = arg;
+  endpoint->kind = kind;
+
+  status = dds_participant_create (&endpoint->participant, DDS_DOMAIN_DEFAULT, NULL, NULL);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+
+  status = dds_topic_create (endpoint->participant, &endpoint->topic,
+    kind == DDSBENCH_LATENCY ? &ddsbench_Latency_desc : &ddsbench_Throughput_desc,
+    arg->topicName, NULL, NULL);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  return endpoint;
+}
+
+/* Without a durability service history that outlives its writers cannot be
+ * aligned to late joiners */
+
+static bool aligned (ddsbench_threadArg * arg, const ddsbench_qos * settings)
+{
+  if (settings->depth && settings->durability > DDSBENCH_TRANSIENT_LOCAL)
+  {
+    printf ("%s %d: Lite has no durability service, only transient local (l) is supported\n",
+      arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id);
+    return false;
+  }
+  return true;
+}
+
+static void * ops_writer_new (ddsbench_threadArg * arg, ddsbench_endpointKind kind, const char * partition,
+  const ddsbench_qos * settings)
+{
+  lite_endpoint * writer = aligned (arg, settings) ? endpoint_new (arg, kind) : NULL;
+  const char * pubParts[1] = { partition };
+  dds_entity_t publisher;
+  dds_qos_t * qos;
+  int status;
+
+  if (!writer)
+  {
+    return NULL;
+  }
+
+  qos = dds_qos_create ();
+  dds_qset_partition (qos, 1, pubParts);
+  status = dds_publisher_create (writer->participant, &publisher, qos, NULL);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  dds_qos_delete (qos);
+
+  qos = endpoint_qos (settings);
+  status = dds_writer_create (publisher, &writer->entity, writer->topic, qos, NULL);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  dds_qos_delete (qos);
+  return writer;
+}
+
+static void * ops_reader_new (ddsbench_threadArg * arg, ddsbench_endpointKind kind, const char * partition,
+  const ddsbench_qos * settings, ddsbench_listenerFn listener, void * listenerArg)
+{
+  ddsbench_context * ctx = arg->ctx;
+  lite_endpoint * reader = aligned (arg, settings) ? endpoint_new (arg, kind) : NULL;
+  const char * subParts[1] = { partition };
+  dds_readerlistener_t rd_listener;
+  dds_entity_t subscriber;
+  dds_entity_t entity;
+  dds_qos_t * qos;
+  int status;
+  int i;
+
+  if (!reader)
+  {
+    return NULL;
+  }
+  for (i = 0; i < MAX_SAMPLES; i++)
+  {
+    reader->samples[i] = kind == DDSBENCH_LATENCY ?
+      (void *) &reader->data.latency[i] : (void *) &reader->data.throughput[i];
+  }
+
+  /* Lite has no SQL filters, the predicate compiled by ddsbench is used as
+   * topic filter so that samples are filtered by the middleware. */
+
+  if (kind == DDSBENCH_THROUGHPUT && ctx->filter && !ctx->localfilter)
+  {
+    if (ctx->predicate)
+    {
+      topicPredicate = ctx->predicate;
+      dds_topic_set_filter (reader->topic, topic_filter);
+    }
+    else
+    {
+      printf ("sub %d: filter '%s' is not supported, ignoring\n", arg->id, ctx->filter);
+    }
+  }
+
+  qos = dds_qos_create ();
+  dds_qset_partition (qos, 1, subParts);
+  status = dds_subscriber_create (reader->participant, &subscriber, qos, NULL);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  dds_qos_delete (qos);
+
+  qos = endpoint_qos (settings);
+  if (listener)
+  {
+    reader->listenerFn = listener;
+    reader->listenerArg = listenerArg;
+    memset (&rd_listener, 0, sizeof (rd_listener));
+    rd_listener.on_data_available = data_available_handler;
+
+    pthread_mutex_lock (&createLock);
+    pthread_mutex_lock (&listenersLock);
+    reader->next = listeners;
+    listeners = reader;
+    pthread_mutex_unlock (&listenersLock);
+
+    status = dds_reader_create (subscriber, &entity, reader->topic, qos, &rd_listener);
+    DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+
+    pthread_mutex_lock (&listenersLock);
+    reader->entity = entity;
+    pthread_mutex_unlock (&listenersLock);
+    pthread_mutex_unlock (&createLock);
+  }
+  else
+  {
+    status = dds_reader_create (subscriber, &reader->entity, reader->topic, qos, NULL);
+    DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  }
+  dds_qos_delete (qos);
+
+  /* Waiting ends when data is available or the benchmark is interrupted */
+
+  reader->waitSet = dds_waitset_create ();
+  reader->readCond = dds_readcondition_create (reader->entity, DDS_ANY_SAMPLE_STATE | DDS_ANY_VIEW_STATE | DDS_ANY_INSTANCE_STATE);
+  status = dds_waitset_attach (reader->waitSet, reader->readCond, reader->entity);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  status = dds_waitset_attach (reader->waitSet, terminated, terminated);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  return reader;
+}
+
+static void ops_writer_free (void * ptr)
+{
+  lite_endpoint * writer = ptr;
+
+  /* Deleting the participant deletes the writer, which disposes its instances */
+
+  dds_entity_delete (writer->participant);
+  free (writer);
+}
+
+static void ops_reader_free (void * ptr)
+{
+  lite_endpoint * reader = ptr;
+  lite_endpoint ** prev;
+  int status;
+  int i;
+
+  /* Disable callbacks before the endpoint of the listener goes away */
+
+  if (reader->listenerFn)
+  {
+    dds_status_set_enabled (reader->entity, 0);
+    pthread_mutex_lock (&listenersLock);
+    for (prev = &listeners; *prev != reader; prev = &(*prev)->next)
+    {
+    }
+    *prev = reader->next;
+    pthread_mutex_unlock (&listenersLock);
+  }
+
+  status = dds_waitset_detach (reader->waitSet, reader->readCond);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  status = dds_waitset_detach (reader->waitSet, terminated);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  dds_condition_delete (reader->readCond);
+  status = dds_waitset_delete (reader->waitSet);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  dds_entity_delete (reader->participant);
+
+  for (i = 0; i < MAX_SAMPLES; i++)
+  {
+    if (reader->kind == DDSBENCH_LATENCY)
+    {
+      ddsbench_Latency_free (&reader->data.latency[i], DDS_FREE_CONTENTS);
+    }
+    else
+    {
+      ddsbench_Throughput_free (&reader->data.throughput[i], DDS_FREE_CONTENTS);
+    }
+  }
+  free (reader);
+}
+
+static void ops_wait_matched (ddsbench_threadArg * arg, void * writer, void * reader)
+{
+  ddsbench_waitMatched (arg, writer ? ((lite_endpoint *) writer)->entity : 0,
+    reader ? ((lite_endpoint *) reader)->entity : 0);
+}
+
+/* The payload is written from where the engine has it, the writer does not free it */
+
+static int ops_write (void * ptr, const ddsbench_sample * sample)
+{
+  lite_endpoint * writer = ptr;
+  ddsbench_Latency latency;
+  ddsbench_Throughput throughput;
+  int status;
+
+  if (writer->kind == DDSBENCH_LATENCY)
+  {
+    latency.filter = sample->filter;
+    latency.payload._buffer = sample->payload;
+    latency.payload._length = latency.payload._maximum = sample->length;
+    latency.payload._release = false;
+    status = dds_write (writer->entity, &latency);
+  }
+  else
+  {
+    throughput.id = sample->id;
+    throughput.filter = sample->filter;
+    throughput.count = sample->count;
+    throughput.payload._buffer = sample->payload;
+    throughput.payload._length = throughput.payload._maximum = sample->length;
+    throughput.payload._release = false;
+    status = dds_write (writer->entity, &throughput);
+  }
+
+  if (dds_err_no (status) == DDS_RETCODE_TIMEOUT)
+  {
+    return DDSBENCH_WRITE_TIMEOUT;
+  }
+  if (status < 0)
+  {
+    DDS_ERR_CHECK (status, DDS_CHECK_REPORT);
+    return DDSBENCH_WRITE_ERROR;
+  }
+  return DDSBENCH_WRITE_OK;
+}
+
+/* Writes are only held back with --batch, see init */
+
+static void ops_flush (void * writer)
+{
+  dds_write_flush (((lite_endpoint *) writer)->entity);
+}
+
+/* Take samples and return the ones with data, an instance that lost its
+ * writers is remembered for ops_writers_gone */
+
+static int ops_take (void * ptr, ddsbench_sample * samples, int max)
+{
+  lite_endpoint * reader = ptr;
+  int i, n, valid = 0;
+
+  n = ddsbench_take (reader->entity, reader->samples, max < MAX_SAMPLES ? max : MAX_SAMPLES,
+    reader->info, reader->arg->ctx);
+  DDS_ERR_CHECK (n, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+
+  for (i = 0; i < n; i++)
+  {
+    if (!reader->info[i].valid_data)
+    {
+      if (reader->info[i].instance_state != DDS_IST_ALIVE)
+      {
+        reader->gone = true;
+      }
+      continue;
+    }
+    if (reader->kind == DDSBENCH_LATENCY)
+    {
+      ddsbench_Latency * sample = reader->samples[i];
+      samples[valid].id = 0;
+      samples[valid].filter = sample->filter;
+      samples[valid].count = DDSBENCH_NO_COUNT;
+      samples[valid].payload = sample->payload._buffer;
+      samples[valid].length = sample->payload._length;
+    }
+    else
+    {
+      ddsbench_Throughput * sample = reader->samples[i];
+      samples[valid].id = sample->id;
+      samples[valid].filter = sample->filter;
+      samples[valid].count = sample->count;
+      samples[valid].payload = sample->payload._buffer;
+      samples[valid].length = sample->payload._length;
+    }
+
+    /* Samples are written on this host, the source timestamp is on its clock */
+
+    samples[valid++].timestamp = ddsbench_timeFromWall (reader->info[i].source_timestamp);
+  }
+
+  /* Without data there is no takeDone to return the loan */
+
+  reader->taken = n;
+  if (n > 0 && !valid)
+  {
+    ddsbench_takeDone (reader->entity, reader->samples, n, reader->arg->ctx);
+    reader->taken = 0;
+  }
+  return valid;
+}
+
+static void ops_take_done (void * ptr)
+{
+  lite_endpoint * reader = ptr;
+
+  ddsbench_takeDone (reader->entity, reader->samples, reader->taken, reader->arg->ctx);
+  reader->taken = 0;
+}
+
+static void ops_wait (void * ptr, unsigned long long timeoutNs)
+{
+  lite_endpoint * reader = ptr;
+  dds_attach_t wsresults[2];
+  int status;
+
+  status = dds_waitset_wait (reader->waitSet, wsresults, 2, (dds_duration_t) timeoutNs);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+}
+
+static int ops_writers_gone (void * ptr)
+{
+  lite_endpoint * reader = ptr;
+  dds_subscription_matched_status_t sms = { 0 };
+  int status;
+
+  if (reader->gone)
+  {
+    return true;
+  }
+  status = dds_get_subscription_matched_status (reader->entity, &sms);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  return sms.total_count > 0 && sms.current_count == 0;
+}
+
+static int ops_terminated (void)
+{
+  return dds_condition_triggered (terminated);
+}
+
+/* A waitset over the readers of a pool worker, with a read condition of its
+ * own for every reader */
+
+typedef struct lite_waitset
+{
+  dds_waitset_t waitSet;
+  int count;
+  dds_condition_t * conds;
+  dds_attach_t * results;
+} lite_waitset;
+
+static void * ops_waitset_new (void ** readers, int count)
+{
+  lite_waitset * ws = calloc (1, sizeof (*ws));
+  lite_endpoint * reader;
+  int status;
+  int i;
+
+  if (!ws || !(ws->conds = calloc (count, sizeof (dds_condition_t))) ||
+      !(ws->results = calloc (count + 1, sizeof (dds_attach_t))))
+  {
+    printf ("worker: out of memory\n");
+    if (ws)
+    {
+      free (ws->conds);
+      free (ws);
+    }
+    return NULL;
+  }
+  ws->count = count;
+  ws->waitSet = dds_waitset_create ();
+  for (i = 0; i < count; i++)
+  {
+    reader = readers[i];
+    ws->conds[i] = dds_readcondition_create (reader->entity, DDS_ANY_SAMPLE_STATE | DDS_ANY_VIEW_STATE | DDS_ANY_INSTANCE_STATE);
+    status = dds_waitset_attach (ws->waitSet, ws->conds[i], reader->entity);
+    DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  }
+  status = dds_waitset_attach (ws->waitSet, terminated, terminated);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  return ws;
+}
+
+static void ops_wait_any (void * ptr, unsigned long long timeoutNs)
+{
+  lite_waitset * ws = ptr;
+  int status;
+
+  status = dds_waitset_wait (ws->waitSet, ws->results, ws->count + 1, (dds_duration_t) timeoutNs);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+}
+
+static void ops_waitset_free (void * ptr)
+{
+  lite_waitset * ws = ptr;
+  int status;
+  int i;
+
+  for (i = 0; i < ws->count; i++)
+  {
+    status = dds_waitset_detach (ws->waitSet, ws->conds[i]);
+    DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+    dds_condition_delete (ws->conds[i]);
+  }
+  status = dds_waitset_detach (ws->waitSet, terminated);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  status = dds_waitset_delete (ws->waitSet);
+  DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  free (ws->conds);
+  free (ws->results);
+  free (ws);
+}
+
+/* Wait until the history the writers keep has arrived */
+
+static void ops_wait_history (void * ptr, unsigned long long timeoutNs)
+{
+  lite_endpoint * reader = ptr;
+  int status;
+
+  status = dds_reader_wait_for_historical_data (reader->entity, (dds_duration_t) timeoutNs);
+  if (dds_err_no (status) != DDS_RETCODE_TIMEOUT)
+  {
+    DDS_ERR_CHECK (status, DDS_CHECK_REPORT | DDS_CHECK_EXIT);
+  }
+}
+
+const ddsbench_ops lite_ops = {
+  .writerNew = ops_writer_new,
+  .readerNew = ops_reader_new,
+  .writerFree = ops_writer_free,
+  .readerFree = ops_reader_free,
+  .waitMatched = ops_wait_matched,
+  .write = ops_write,
+  .flush = ops_flush,
+  .take = ops_take,
+  .takeDone = ops_take_done,
+  .wait = ops_wait,
+  .writersGone = ops_writers_gone,
+  .terminated = ops_terminated,
+  .waitSetNew = ops_waitset_new,
+  .waitAny = ops_wait_any,
+  .waitSetFree = ops_waitset_free,
+  .waitHistory = ops_wait_history
+};
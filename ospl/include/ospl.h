@@ -3,6 +3,7 @@
 #define OSPL_H
 
 #include <dds_dcps.h>
+#include <ddsbench.h>
 
 #ifdef __cplusplus
 extern "c" {
@@ -12,7 +13,21 @@ extern DDS_DomainParticipantFactory ddsbench_factory;
 extern DDS_DomainParticipant ddsbench_dp;
 extern DDS_GuardCondition terminated;
 
-DDS_TopicQos* ddsbench_getQos(char *qos);
+/* Endpoints the harness runs all threads on */
+extern const ddsbench_ops ospl_ops;
+
+/* Functions of the plugin, exported through its descriptor in ospl.c */
+int init(ddsbench_context *ctx);
+void fini(void);
+
+/* Generate the domain configuration selected by DDSBENCH_OSPL_MODE and point
+ * OSPL_URI at it, and remove it again (see config.c) */
+int ddsbench_osplConfigInit(void);
+void ddsbench_osplConfigFini(void);
+
+/* Wait until writer and reader (either may be NULL) are matched with the
+ * number of readers and writers the benchmark expects, and set readyNs */
+void ddsbench_waitMatched(ddsbench_threadArg *arg, DDS_DataWriter writer, DDS_DataReader reader);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,263 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <ddsbench.h>
+#include <ospl.h>
+
+/**
+ * @file
+ * Domain configurations generated by ddsbench. When DDSBENCH_OSPL_MODE is set
+ * (--ospl-mode) init writes the configuration of a single process or a shared
+ * memory deployment and points OSPL_URI at it, so that both architectures can
+ * be measured without maintaining a file for each. Otherwise the domain is
+ * configured by OSPL_URI as set by the user. The DDSI2 settings default to
+ * those of ospl.xml, ddsbench tune varies them through DDSBENCH_OSPL_WHCHIGH,
+ * DDSBENCH_OSPL_MAXMESSAGESIZE, DDSBENCH_OSPL_FRAGMENTSIZE and
+ * DDSBENCH_OSPL_MCLOOPBACK.
+ */
+
+/** Size of the shared memory database, unless DDSBENCH_OSPL_DBSIZE is set */
+#define OSPL_DATABASE_MB 64
+
+/**
+ * The deployment the domain configuration is generated for
+ */
+typedef struct OsplConfig {
+    /** Applications attach to a shared memory database instead of running the services themselves */
+    int shm;
+    /** Size of the shared memory database in MB */
+    unsigned long databaseMb;
+    /** Run the ddsi2 networking service, without it the domain is local only */
+    int ddsi2;
+    /** Run the durability service */
+    int durability;
+    /** DDSI2Service settings, as they appear in the configuration */
+    char whcHigh[32];
+    char maxMessageSize[32];
+    char fragmentSize[32];
+    char multicastLoopback[32];
+} OsplConfig;
+
+/** The directory the configuration is written to, empty when there is none */
+static char configDir[PATH_MAX];
+static char configUri[PATH_MAX + 32];
+
+
+/**
+ * Parses DDSBENCH_OSPL_SERVICES, a comma separated list of ddsi2 and
+ * durability, or none.
+ */
+static int parseServices(const char *list, OsplConfig *config)
+{
+    char buf[256], *name, *save = NULL;
+
+    if (strlen(list) >= sizeof(buf)) {
+        printf("error: DDSBENCH_OSPL_SERVICES is too long\n");
+        return -1;
+    }
+    strcpy(buf, list);
+    config->ddsi2 = 0;
+    config->durability = 0;
+    for (name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        if (!strcmp(name, "ddsi2")) {
+            config->ddsi2 = 1;
+        } else if (!strcmp(name, "durability")) {
+            config->durability = 1;
+        } else if (strcmp(name, "none")) {
+            printf("error: unknown OpenSplice service %s, expected ddsi2, durability or none\n", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Reads a DDSI2 setting from the environment into value, which holds the
+ * default otherwise. Settings are sizes like '400 kB' or true and false.
+ */
+static int ddsi2Setting(const char *name, char *value, size_t size)
+{
+    const char *env = getenv(name);
+
+    if (!env) {
+        return 0;
+    }
+    if (!env[0] || strlen(env) >= size || strspn(env, "0123456789 .abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ") != strlen(env)) {
+        printf("error: invalid value for %s: '%s'\n", name, env);
+        return -1;
+    }
+    strcpy(value, env);
+    return 0;
+}
+
+static void writeConfig(FILE *f, const OsplConfig *config)
+{
+    fprintf(f, "<OpenSplice>\n");
+    fprintf(f, "    <Domain>\n");
+    fprintf(f, "        <Name>ddsbench_%s</Name>\n", config->shm ? "shm" : "single");
+    fprintf(f, "        <Id>0</Id>\n");
+    if (config->shm) {
+        fprintf(f, "        <Database>\n");
+        fprintf(f, "            <Size>%lu</Size>\n", config->databaseMb * 1024 * 1024);
+        fprintf(f, "        </Database>\n");
+    } else {
+        fprintf(f, "        <SingleProcess>true</SingleProcess>\n");
+    }
+    if (config->ddsi2) {
+        fprintf(f, "        <Service name=\"ddsi2\">\n");
+        fprintf(f, "            <Command>ddsi2</Command>\n");
+        fprintf(f, "        </Service>\n");
+    }
+    if (config->durability) {
+        fprintf(f, "        <Service name=\"durability\">\n");
+        fprintf(f, "            <Command>durability</Command>\n");
+        fprintf(f, "        </Service>\n");
+    }
+    fprintf(f, "    </Domain>\n");
+
+    /** The settings of ospl.xml, except the ones that are tuned */
+    if (config->ddsi2) {
+        fprintf(f, "    <DDSI2Service name=\"ddsi2\">\n");
+        fprintf(f, "        <General>\n");
+        fprintf(f, "            <NetworkInterfaceAddress>Auto</NetworkInterfaceAddress>\n");
+        fprintf(f, "            <AllowMulticast>true</AllowMulticast>\n");
+        fprintf(f, "            <EnableMulticastLoopback>%s</EnableMulticastLoopback>\n", config->multicastLoopback);
+        fprintf(f, "            <CoexistWithNativeNetworking>false</CoexistWithNativeNetworking>\n");
+        fprintf(f, "        </General>\n");
+        fprintf(f, "        <Compatibility>\n");
+        fprintf(f, "            <StandardsConformance>lax</StandardsConformance>\n");
+        fprintf(f, "        </Compatibility>\n");
+        fprintf(f, "        <Internal>\n");
+        fprintf(f, "            <Watermarks>\n");
+        fprintf(f, "                <WhcHigh>%s</WhcHigh>\n", config->whcHigh);
+        fprintf(f, "            </Watermarks>\n");
+        fprintf(f, "            <MaxMessageSize>%s</MaxMessageSize>\n", config->maxMessageSize);
+        fprintf(f, "            <FragmentSize>%s</FragmentSize>\n", config->fragmentSize);
+        fprintf(f, "        </Internal>\n");
+        fprintf(f, "    </DDSI2Service>\n");
+    }
+    if (config->durability) {
+        fprintf(f, "    <DurabilityService name=\"durability\">\n");
+        fprintf(f, "        <Network>\n");
+        fprintf(f, "            <Alignment>\n");
+        fprintf(f, "                <TimeAlignment>false</TimeAlignment>\n");
+        fprintf(f, "                <RequestCombinePeriod>\n");
+        fprintf(f, "                    <Initial>0.5</Initial>\n");
+        fprintf(f, "                    <Operational>0.01</Operational>\n");
+        fprintf(f, "                </RequestCombinePeriod>\n");
+        fprintf(f, "            </Alignment>\n");
+        if (config->ddsi2) {
+            fprintf(f, "            <WaitForAttachment maxWaitCount=\"10\">\n");
+            fprintf(f, "                <ServiceName>ddsi2</ServiceName>\n");
+            fprintf(f, "            </WaitForAttachment>\n");
+        }
+        fprintf(f, "        </Network>\n");
+        fprintf(f, "        <NameSpaces>\n");
+        fprintf(f, "            <NameSpace name=\"defaultNamespace\">\n");
+        fprintf(f, "                <Partition>*</Partition>\n");
+        fprintf(f, "            </NameSpace>\n");
+        fprintf(f, "            <Policy alignee=\"Initial\" aligner=\"true\" durability=\"Durable\" nameSpace=\"defaultNamespace\"/>\n");
+        fprintf(f, "        </NameSpaces>\n");
+        fprintf(f, "    </DurabilityService>\n");
+    }
+    fprintf(f, "</OpenSplice>\n");
+}
+
+int ddsbench_osplConfigInit(void)
+{
+    OsplConfig config = { 0, OSPL_DATABASE_MB, 1, 1, "400 kB", "62 kB", "60 kB", "true" };
+    const char *mode = getenv("DDSBENCH_OSPL_MODE");
+    const char *value, *tmp = getenv("TMPDIR");
+    char path[PATH_MAX + 16];
+    FILE *f;
+
+    /** Without a mode the domain is configured by the environment */
+    if (!mode) {
+        return 0;
+    }
+    if (!strcmp(mode, "shm")) {
+        config.shm = 1;
+    } else if (strcmp(mode, "single")) {
+        printf("error: DDSBENCH_OSPL_MODE must be single or shm, not %s\n", mode);
+        return -1;
+    }
+    if ((value = getenv("DDSBENCH_OSPL_SERVICES")) && parseServices(value, &config)) {
+        return -1;
+    }
+    if ((value = getenv("DDSBENCH_OSPL_DBSIZE")) && !(config.databaseMb = strtoul(value, NULL, 10))) {
+        printf("error: DDSBENCH_OSPL_DBSIZE must be a size in MB, not %s\n", value);
+        return -1;
+    }
+    if (ddsi2Setting("DDSBENCH_OSPL_WHCHIGH", config.whcHigh, sizeof(config.whcHigh)) ||
+        ddsi2Setting("DDSBENCH_OSPL_MAXMESSAGESIZE", config.maxMessageSize, sizeof(config.maxMessageSize)) ||
+        ddsi2Setting("DDSBENCH_OSPL_FRAGMENTSIZE", config.fragmentSize, sizeof(config.fragmentSize)) ||
+        ddsi2Setting("DDSBENCH_OSPL_MCLOOPBACK", config.multicastLoopback, sizeof(config.multicastLoopback)))
+    {
+        return -1;
+    }
+
+    /**
+     * A shared memory domain is shared by every process on the host, so none
+     * of them owns it: ddsbench never starts or stops it. Its configuration is
+     * kept in a file of the user that is the same for every run, from which
+     * the domain is started before, and stopped after, all processes that use
+     * it. A single process domain lives in a temporary directory of its own.
+     */
+    if (config.shm) {
+        snprintf(path, sizeof(path), "%s/ddsbench-ospl-shm-%u.xml", tmp && tmp[0] ? tmp : "/tmp", (unsigned)getuid());
+    } else {
+        snprintf(configDir, sizeof(configDir), "%s/ddsbench-ospl-XXXXXX", tmp && tmp[0] ? tmp : "/tmp");
+        if (!mkdtemp(configDir)) {
+            printf("error: failed to create a directory for the domain configuration: %s\n", configDir);
+            configDir[0] = '\0';
+            return -1;
+        }
+        snprintf(path, sizeof(path), "%s/ospl.xml", configDir);
+    }
+    if (!(f = fopen(path, "w"))) {
+        printf("error: failed to write %s\n", path);
+        ddsbench_osplConfigFini();
+        return -1;
+    }
+    writeConfig(f, &config);
+    fclose(f);
+    snprintf(configUri, sizeof(configUri), "file://%s", path);
+    setenv("OSPL_URI", configUri, 1);
+
+    printf("ddsbench: %s domain, services:%s%s%s", config.shm ? "shared memory" : "single process",
+        config.ddsi2 ? " ddsi2" : "", config.durability ? " durability" : "",
+        config.ddsi2 || config.durability ? "" : " none");
+    if (config.shm) {
+        printf(", database %lu MB", config.databaseMb);
+    }
+    printf("\n");
+    if (config.ddsi2) {
+        printf("ddsbench: ddsi2 WhcHigh %s, MaxMessageSize %s, FragmentSize %s, multicast loopback %s\n",
+            config.whcHigh, config.maxMessageSize, config.fragmentSize, config.multicastLoopback);
+    }
+
+    /** Applications attach to a shared memory domain that runs already, with
+     *  the configuration it was started with */
+    if (config.shm) {
+        printf("ddsbench: the shared memory domain must be running, start it with\n"
+               "  ospl start %s\n"
+               "and stop it with ospl stop once no benchmark uses it\n", configUri);
+    }
+    return 0;
+}
+
+void ddsbench_osplConfigFini(void)
+{
+    char path[PATH_MAX + 16];
+
+    if (configDir[0]) {
+        snprintf(path, sizeof(path), "%s/ospl.xml", configDir);
+        unlink(path);
+        rmdir(configDir);
+        configDir[0] = '\0';
+    }
+}
@@ -43,6 +43,8 @@ ExampleTimeStats exampleInitTimeStats()
 {
     ExampleTimeStats stats;
     stats.values = (unsigned long*)malloc(TIME_STATS_SIZE_INCREMENT * sizeof(unsigned long));
+    /* Touch the values, so that adding to the stats does not fault while measuring */
+    memset(stats.values, 0, TIME_STATS_SIZE_INCREMENT * sizeof(unsigned long));
     stats.valuesSize = 0;
     stats.valuesMax = TIME_STATS_SIZE_INCREMENT;
     stats.average = 0;
@@ -0,0 +1,571 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ddsbench.h>
+#include <../idl/ddsbench.h>
+#include <example_utilities.h>
+#include <example_error_sac.h>
+#include <ospl.h>
+
+/**
+ * An endpoint of the engine, with the topic of its own that it was created on.
+ * Readers take with a loan that takeDone returns.
+ */
+typedef struct osplEndpoint {
+    ddsbench_threadArg *arg;
+    ddsbench_endpointKind kind;
+    DDS_Topic topic;
+    /** The Topic used when a filter is specified */
+    DDS_ContentFilteredTopic filter;
+    /** The Publisher or Subscriber of the endpoint */
+    DDS_Entity container;
+    DDS_Entity entity;
+
+    /** Readers only */
+    DDS_WaitSet waitSet;
+    DDS_StatusCondition dataAvailable;
+    DDS_ConditionSeq *conditions;
+    void *samples;
+    DDS_SampleInfoSeq *info;
+    int taken;                      /* Samples are loaned until takeDone */
+    int gone;                       /* An instance lost its writers, or was disposed */
+} osplEndpoint;
+
+/**
+ * Copy the QoS of the benchmark into the QoS of a topic, which the writer
+ * or reader copies from
+ */
+static DDS_TopicQos* endpointQos(const ddsbench_qos *settings)
+{
+    DDS_TopicQos *qos = DDS_TopicQos__alloc();
+    DDS_ReturnCode_t status;
+
+    CHECK_HANDLE_MACRO(qos);
+    status = DDS_DomainParticipant_get_default_topic_qos(ddsbench_dp, qos);
+    CHECK_STATUS_MACRO(status);
+
+    switch (settings->durability) {
+    case DDSBENCH_VOLATILE:
+        qos->durability.kind = DDS_VOLATILE_DURABILITY_QOS;
+        break;
+    case DDSBENCH_TRANSIENT_LOCAL:
+        qos->durability.kind = DDS_TRANSIENT_LOCAL_DURABILITY_QOS;
+        break;
+    case DDSBENCH_TRANSIENT:
+        qos->durability.kind = DDS_TRANSIENT_DURABILITY_QOS;
+        break;
+    case DDSBENCH_PERSISTENT:
+        qos->durability.kind = DDS_PERSISTENT_DURABILITY_QOS;
+        break;
+    }
+    qos->reliability.kind = settings->reliable ? DDS_RELIABLE_RELIABILITY_QOS : DDS_BEST_EFFORT_RELIABILITY_QOS;
+    qos->reliability.max_blocking_time.sec = (DDS_long)(settings->maxBlockingNs / 1000000000ULL);
+    qos->reliability.max_blocking_time.nanosec = (DDS_unsigned_long)(settings->maxBlockingNs % 1000000000ULL);
+    qos->history.kind = DDS_KEEP_ALL_HISTORY_QOS;
+    qos->resource_limits.max_samples = settings->maxSamples < 0 ? DDS_LENGTH_UNLIMITED : settings->maxSamples;
+
+    /** The durability service keeps as much history as the endpoints */
+    if (settings->depth) {
+        qos->history.kind = DDS_KEEP_LAST_HISTORY_QOS;
+        qos->history.depth = settings->depth;
+        qos->durability_service.history_kind = DDS_KEEP_LAST_HISTORY_QOS;
+        qos->durability_service.history_depth = settings->depth;
+        qos->durability_service.max_samples = DDS_LENGTH_UNLIMITED;
+        qos->durability_service.max_instances = DDS_LENGTH_UNLIMITED;
+        qos->durability_service.max_samples_per_instance = DDS_LENGTH_UNLIMITED;
+    }
+    return qos;
+}
+
+/**
+ * Fill in the partition of a publisher or subscriber QoS
+ */
+static void setPartition(DDS_StringSeq *name, const char *partition)
+{
+    name->_length = 1;
+    name->_maximum = 1;
+    name->_release = TRUE;
+    name->_buffer = DDS_StringSeq_allocbuf(1);
+    name->_buffer[0] = DDS_string_dup(partition);
+}
+
+static osplEndpoint* endpointNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const ddsbench_qos *settings)
+{
+    osplEndpoint *endpoint = calloc(1, sizeof(*endpoint));
+    DDS_TopicQos *topicQos = NULL;
+    DDS_string typeName;
+    DDS_ReturnCode_t status;
+
+    CHECK_ALLOC_MACRO(endpoint);
+    endpoint->arg = arg;
+    endpoint->kind = kind;
+
+    /** The sample type is registered and a topic created for it */
+    if (kind == DDSBENCH_LATENCY) {
+        ddsbench_LatencyTypeSupport typeSupport = ddsbench_LatencyTypeSupport__alloc();
+        CHECK_HANDLE_MACRO(typeSupport);
+        typeName = ddsbench_LatencyTypeSupport_get_type_name(typeSupport);
+        status = ddsbench_LatencyTypeSupport_register_type(typeSupport, ddsbench_dp, typeName);
+        DDS_free(typeSupport);
+    } else {
+        ddsbench_ThroughputTypeSupport typeSupport = ddsbench_ThroughputTypeSupport__alloc();
+        CHECK_HANDLE_MACRO(typeSupport);
+        typeName = ddsbench_ThroughputTypeSupport_get_type_name(typeSupport);
+        status = ddsbench_ThroughputTypeSupport_register_type(typeSupport, ddsbench_dp, typeName);
+        DDS_free(typeSupport);
+    }
+    CHECK_STATUS_MACRO(status);
+
+    /** The durability service stores history according to the topic QoS, so
+     *  the topic of history for late joiners has the QoS of its endpoints */
+    if (settings->depth) {
+        topicQos = endpointQos(settings);
+    }
+    endpoint->topic = DDS_DomainParticipant_create_topic(
+        ddsbench_dp, arg->topicName, typeName, topicQos ? topicQos : DDS_TOPIC_QOS_DEFAULT, NULL, DDS_STATUS_MASK_NONE);
+    CHECK_HANDLE_MACRO(endpoint->topic);
+    DDS_free(typeName);
+    if (topicQos) {
+        DDS_free(topicQos);
+    }
+    return endpoint;
+}
+
+static void* opsWriterNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *settings)
+{
+    osplEndpoint *writer = endpointNew(arg, kind, settings);
+    DDS_PublisherQos *pubQos;
+    DDS_DataWriterQos *dwQos;
+    DDS_TopicQos *topicQos;
+    DDS_ReturnCode_t status;
+
+    /** A DDS_Publisher is created on the domain participant. */
+    pubQos = DDS_PublisherQos__alloc();
+    CHECK_HANDLE_MACRO(pubQos);
+    status = DDS_DomainParticipant_get_default_publisher_qos(ddsbench_dp, pubQos);
+    CHECK_STATUS_MACRO(status);
+    setPartition(&pubQos->partition.name, partition);
+    writer->container = DDS_DomainParticipant_create_publisher(ddsbench_dp, pubQos, NULL, DDS_STATUS_MASK_NONE);
+    CHECK_HANDLE_MACRO(writer->container);
+    DDS_free(pubQos);
+
+    /** A DDS_DataWriter is created on the Publisher & Topic with the QoS of the benchmark. */
+    dwQos = DDS_DataWriterQos__alloc();
+    CHECK_HANDLE_MACRO(dwQos);
+    status = DDS_Publisher_get_default_datawriter_qos(writer->container, dwQos);
+    CHECK_STATUS_MACRO(status);
+    topicQos = endpointQos(settings);
+    status = DDS_Publisher_copy_from_topic_qos(writer->container, dwQos, topicQos);
+    CHECK_STATUS_MACRO(status);
+    DDS_free(topicQos);
+    if (kind == DDSBENCH_LATENCY) {
+        dwQos->writer_data_lifecycle.autodispose_unregistered_instances = FALSE;
+        dwQos->transport_priority.value = 10;
+    }
+
+    /** History for late joiners outlives the writer, which must not dispose it */
+    if (settings->depth) {
+        dwQos->writer_data_lifecycle.autodispose_unregistered_instances = FALSE;
+    }
+    writer->entity = DDS_Publisher_create_datawriter(writer->container, writer->topic, dwQos, NULL, DDS_STATUS_MASK_NONE);
+    CHECK_HANDLE_MACRO(writer->entity);
+    DDS_free(dwQos);
+    return writer;
+}
+
+static void* opsReaderNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *settings, ddsbench_listenerFn listener, void *listenerArg)
+{
+    ddsbench_context *ctx = arg->ctx;
+    osplEndpoint *reader = endpointNew(arg, kind, settings);
+    DDS_SubscriberQos *subQos;
+    DDS_DataReaderQos *drQos;
+    DDS_TopicQos *topicQos;
+    DDS_ReturnCode_t status;
+
+    /** A DDS_ContentFilteredTopic is created if a filter is specified that is not applied locally,
+     *  named after the subscriber so that every subscriber can have its own. */
+    if (kind == DDSBENCH_THROUGHPUT && ctx->filter && !ctx->localfilter) {
+        DDS_StringSeq *parameterList = DDS_StringSeq__alloc();
+        char filterName[256];
+        CHECK_HANDLE_MACRO(parameterList);
+        snprintf(filterName, sizeof(filterName), "%s_%d", ctx->filtername, arg->id);
+        reader->filter = DDS_DomainParticipant_create_contentfilteredtopic(
+            ddsbench_dp, filterName, reader->topic, ctx->filter, parameterList);
+        CHECK_HANDLE_MACRO(reader->filter);
+        DDS_free(parameterList);
+    }
+
+    /** A DDS_Subscriber is created on the domain participant. */
+    subQos = DDS_SubscriberQos__alloc();
+    CHECK_HANDLE_MACRO(subQos);
+    status = DDS_DomainParticipant_get_default_subscriber_qos(ddsbench_dp, subQos);
+    CHECK_STATUS_MACRO(status);
+    setPartition(&subQos->partition.name, partition);
+    reader->container = DDS_DomainParticipant_create_subscriber(ddsbench_dp, subQos, NULL, DDS_STATUS_MASK_NONE);
+    CHECK_HANDLE_MACRO(reader->container);
+    DDS_free(subQos);
+
+    /** A DDS_DataReader is created on the Subscriber & Topic with the QoS of the benchmark. */
+    drQos = DDS_DataReaderQos__alloc();
+    CHECK_HANDLE_MACRO(drQos);
+    status = DDS_Subscriber_get_default_datareader_qos(reader->container, drQos);
+    CHECK_STATUS_MACRO(status);
+    topicQos = endpointQos(settings);
+    status = DDS_Subscriber_copy_from_topic_qos(reader->container, drQos, topicQos);
+    CHECK_STATUS_MACRO(status);
+    DDS_free(topicQos);
+    reader->entity = DDS_Subscriber_create_datareader(reader->container,
+        reader->filter ? reader->filter : reader->topic, drQos, NULL, DDS_STATUS_MASK_NONE);
+    CHECK_HANDLE_MACRO(reader->entity);
+    DDS_free(drQos);
+
+    /** A DDS_StatusCondition is created which is triggered when data is available to read */
+    reader->dataAvailable = DDS_DataReader_get_statuscondition(reader->entity);
+    CHECK_HANDLE_MACRO(reader->dataAvailable);
+    status = DDS_StatusCondition_set_enabled_statuses(reader->dataAvailable, DDS_DATA_AVAILABLE_STATUS);
+    CHECK_STATUS_MACRO(status);
+
+    /** A DDS_WaitSet is created and the data available status condition is attached */
+    reader->waitSet = DDS_WaitSet__alloc();
+    CHECK_HANDLE_MACRO(reader->waitSet);
+    status = DDS_WaitSet_attach_condition(reader->waitSet, reader->dataAvailable);
+    CHECK_STATUS_MACRO(status);
+    status = DDS_WaitSet_attach_condition(reader->waitSet, terminated);
+    CHECK_STATUS_MACRO(status);
+
+    reader->conditions = DDS_ConditionSeq__alloc();
+    CHECK_HANDLE_MACRO(reader->conditions);
+    if (kind == DDSBENCH_LATENCY) {
+        reader->samples = DDS_sequence_ddsbench_Latency__alloc();
+    } else {
+        reader->samples = DDS_sequence_ddsbench_Throughput__alloc();
+    }
+    CHECK_HANDLE_MACRO(reader->samples);
+    reader->info = DDS_SampleInfoSeq__alloc();
+    CHECK_HANDLE_MACRO(reader->info);
+    return reader;
+}
+
+static void endpointFree(osplEndpoint *endpoint)
+{
+    DDS_ReturnCode_t status;
+
+    if (endpoint->filter) {
+        status = DDS_DomainParticipant_delete_contentfilteredtopic(ddsbench_dp, endpoint->filter);
+        CHECK_STATUS_MACRO(status);
+    }
+    status = DDS_DomainParticipant_delete_topic(ddsbench_dp, endpoint->topic);
+    CHECK_STATUS_MACRO(status);
+    free(endpoint);
+}
+
+static void opsWriterFree(void *ptr)
+{
+    osplEndpoint *writer = ptr;
+    DDS_ReturnCode_t status;
+
+    status = DDS_Publisher_delete_contained_entities(writer->container);
+    CHECK_STATUS_MACRO(status);
+    status = DDS_DomainParticipant_delete_publisher(ddsbench_dp, writer->container);
+    CHECK_STATUS_MACRO(status);
+    endpointFree(writer);
+}
+
+static void opsReaderFree(void *ptr)
+{
+    osplEndpoint *reader = ptr;
+    DDS_ReturnCode_t status;
+
+    status = DDS_WaitSet_detach_condition(reader->waitSet, reader->dataAvailable);
+    CHECK_STATUS_MACRO(status);
+    status = DDS_WaitSet_detach_condition(reader->waitSet, terminated);
+    CHECK_STATUS_MACRO(status);
+    DDS_free(reader->waitSet);
+    DDS_free(reader->conditions);
+    DDS_free(reader->samples);
+    DDS_free(reader->info);
+    status = DDS_Subscriber_delete_contained_entities(reader->container);
+    CHECK_STATUS_MACRO(status);
+    status = DDS_DomainParticipant_delete_subscriber(ddsbench_dp, reader->container);
+    CHECK_STATUS_MACRO(status);
+    endpointFree(reader);
+}
+
+static void opsWaitMatched(ddsbench_threadArg *arg, void *writer, void *reader)
+{
+    ddsbench_waitMatched(arg, writer ? ((osplEndpoint *)writer)->entity : NULL,
+        reader ? ((osplEndpoint *)reader)->entity : NULL);
+}
+
+/**
+ * The payload is written from where the engine has it, the writer does not free it
+ */
+static int opsWrite(void *ptr, const ddsbench_sample *sample)
+{
+    osplEndpoint *writer = ptr;
+    DDS_ReturnCode_t status;
+
+    if (writer->kind == DDSBENCH_LATENCY) {
+        ddsbench_Latency data;
+        data.filter = sample->filter;
+        data.payload._buffer = sample->payload;
+        data.payload._length = data.payload._maximum = sample->length;
+        data.payload._release = FALSE;
+        status = ddsbench_LatencyDataWriter_write(writer->entity, &data, DDS_HANDLE_NIL);
+    } else {
+        ddsbench_Throughput data;
+        data.id = sample->id;
+        data.filter = sample->filter;
+        data.count = sample->count;
+        data.payload._buffer = sample->payload;
+        data.payload._length = data.payload._maximum = sample->length;
+        data.payload._release = FALSE;
+        status = ddsbench_ThroughputDataWriter_write(writer->entity, &data, DDS_HANDLE_NIL);
+    }
+
+    if (status == DDS_RETCODE_TIMEOUT) {
+        return DDSBENCH_WRITE_TIMEOUT;
+    } else if (status != DDS_RETCODE_OK) {
+        printf("%s %d: write failed: %s\n", writer->arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub",
+            writer->arg->id, ReturnCodeName[status]);
+        return DDSBENCH_WRITE_ERROR;
+    }
+    return DDSBENCH_WRITE_OK;
+}
+
+/**
+ * Writes are not batched, there is nothing to flush
+ */
+static void opsFlush(void *writer)
+{
+}
+
+static void opsTakeDone(void *ptr)
+{
+    osplEndpoint *reader = ptr;
+    DDS_ReturnCode_t status;
+
+    if (!reader->taken) {
+        return;
+    }
+    if (reader->kind == DDSBENCH_LATENCY) {
+        status = ddsbench_LatencyDataReader_return_loan(reader->entity, reader->samples, reader->info);
+    } else {
+        status = ddsbench_ThroughputDataReader_return_loan(reader->entity, reader->samples, reader->info);
+    }
+    CHECK_STATUS_MACRO(status);
+    reader->taken = 0;
+}
+
+/**
+ * Take samples with a loan and return the ones with data, an instance that
+ * lost its writers is remembered for opsWritersGone
+ */
+static int opsTake(void *ptr, ddsbench_sample *samples, int max)
+{
+    osplEndpoint *reader = ptr;
+    DDS_SampleInfo *info;
+    DDS_unsigned_long i, n;
+    DDS_ReturnCode_t status;
+    int valid = 0;
+
+    if (reader->kind == DDSBENCH_LATENCY) {
+        status = ddsbench_LatencyDataReader_take(reader->entity, reader->samples, reader->info, max,
+            DDS_ANY_SAMPLE_STATE, DDS_ANY_VIEW_STATE, DDS_ANY_INSTANCE_STATE);
+        n = ((DDS_sequence_ddsbench_Latency *)reader->samples)->_length;
+    } else {
+        status = ddsbench_ThroughputDataReader_take(reader->entity, reader->samples, reader->info, max,
+            DDS_ANY_SAMPLE_STATE, DDS_ANY_VIEW_STATE, DDS_ANY_INSTANCE_STATE);
+        n = ((DDS_sequence_ddsbench_Throughput *)reader->samples)->_length;
+    }
+    CHECK_STATUS_MACRO(status);
+    if (status == DDS_RETCODE_NO_DATA) {
+        return 0;
+    }
+
+    for (i = 0; i < n; i++) {
+        info = &reader->info->_buffer[i];
+        if (!info->valid_data) {
+            if (info->instance_state != DDS_ALIVE_INSTANCE_STATE) {
+                reader->gone = 1;
+            }
+            continue;
+        }
+        if (reader->kind == DDSBENCH_LATENCY) {
+            ddsbench_Latency *sample = &((DDS_sequence_ddsbench_Latency *)reader->samples)->_buffer[i];
+            samples[valid].id = 0;
+            samples[valid].filter = sample->filter;
+            samples[valid].count = DDSBENCH_NO_COUNT;
+            samples[valid].payload = sample->payload._buffer;
+            samples[valid].length = sample->payload._length;
+        } else {
+            ddsbench_Throughput *sample = &((DDS_sequence_ddsbench_Throughput *)reader->samples)->_buffer[i];
+            samples[valid].id = sample->id;
+            samples[valid].filter = sample->filter;
+            samples[valid].count = sample->count;
+            samples[valid].payload = sample->payload._buffer;
+            samples[valid].length = sample->payload._length;
+        }
+
+        /** Samples are written on this host, the source timestamp is on its clock */
+        samples[valid++].timestamp = ddsbench_timeFromWall(
+            (long long)info->source_timestamp.sec * 1000000000LL + info->source_timestamp.nanosec);
+    }
+
+    /** Without data there is no takeDone to return the loan */
+    reader->taken = 1;
+    if (!valid) {
+        opsTakeDone(reader);
+    }
+    return valid;
+}
+
+static void opsWait(void *ptr, unsigned long long timeoutNs)
+{
+    osplEndpoint *reader = ptr;
+    DDS_Duration_t timeout;
+    DDS_ReturnCode_t status;
+
+    timeout.sec = (DDS_long)(timeoutNs / 1000000000ULL);
+    timeout.nanosec = (DDS_unsigned_long)(timeoutNs % 1000000000ULL);
+    status = DDS_WaitSet_wait(reader->waitSet, reader->conditions, &timeout);
+    if (status != DDS_RETCODE_TIMEOUT) {
+        CHECK_STATUS_MACRO(status);
+    }
+}
+
+static int opsWritersGone(void *ptr)
+{
+    osplEndpoint *reader = ptr;
+    DDS_SubscriptionMatchedStatus sms = { 0 };
+    DDS_ReturnCode_t status;
+
+    if (reader->gone) {
+        return TRUE;
+    }
+    status = DDS_DataReader_get_subscription_matched_status(reader->entity, &sms);
+    CHECK_STATUS_MACRO(status);
+    return sms.total_count > 0 && sms.current_count == 0;
+}
+
+static int opsTerminated(void)
+{
+    return DDS_GuardCondition_get_trigger_value(terminated);
+}
+
+/**
+ * A waitset over the readers of a pool worker
+ */
+typedef struct osplWaitSet {
+    DDS_WaitSet waitSet;
+    DDS_ConditionSeq *conditions;
+    osplEndpoint **readers;
+    int count;
+} osplWaitSet;
+
+static void* opsWaitSetNew(void **readers, int count)
+{
+    osplWaitSet *ws = calloc(1, sizeof(*ws));
+    DDS_ReturnCode_t status;
+    int i;
+
+    CHECK_ALLOC_MACRO(ws);
+    ws->readers = (osplEndpoint **)readers;
+    ws->count = count;
+    ws->waitSet = DDS_WaitSet__alloc();
+    CHECK_HANDLE_MACRO(ws->waitSet);
+    ws->conditions = DDS_ConditionSeq__alloc();
+    CHECK_HANDLE_MACRO(ws->conditions);
+
+    /** The data available condition of every reader is attached, like to its own waitset */
+    for (i = 0; i < count; i++) {
+        status = DDS_WaitSet_attach_condition(ws->waitSet, ws->readers[i]->dataAvailable);
+        CHECK_STATUS_MACRO(status);
+    }
+    status = DDS_WaitSet_attach_condition(ws->waitSet, terminated);
+    CHECK_STATUS_MACRO(status);
+    return ws;
+}
+
+static void opsWaitAny(void *ptr, unsigned long long timeoutNs)
+{
+    osplWaitSet *ws = ptr;
+    DDS_Duration_t timeout;
+    DDS_ReturnCode_t status;
+
+    timeout.sec = (DDS_long)(timeoutNs / 1000000000ULL);
+    timeout.nanosec = (DDS_unsigned_long)(timeoutNs % 1000000000ULL);
+    status = DDS_WaitSet_wait(ws->waitSet, ws->conditions, &timeout);
+    if (status != DDS_RETCODE_TIMEOUT) {
+        CHECK_STATUS_MACRO(status);
+    }
+}
+
+static void opsWaitSetFree(void *ptr)
+{
+    osplWaitSet *ws = ptr;
+    DDS_ReturnCode_t status;
+    int i;
+
+    for (i = 0; i < ws->count; i++) {
+        status = DDS_WaitSet_detach_condition(ws->waitSet, ws->readers[i]->dataAvailable);
+        CHECK_STATUS_MACRO(status);
+    }
+    status = DDS_WaitSet_detach_condition(ws->waitSet, terminated);
+    CHECK_STATUS_MACRO(status);
+    DDS_free(ws->waitSet);
+    DDS_free(ws->conditions);
+    free(ws);
+}
+
+static void opsWaitAcked(void *ptr, unsigned long long timeoutNs)
+{
+    osplEndpoint *writer = ptr;
+    DDS_Duration_t timeout;
+    DDS_ReturnCode_t status;
+
+    timeout.sec = (DDS_long)(timeoutNs / 1000000000ULL);
+    timeout.nanosec = (DDS_unsigned_long)(timeoutNs % 1000000000ULL);
+    status = DDS_DataWriter_wait_for_acknowledgments(writer->entity, &timeout);
+    if (status != DDS_RETCODE_TIMEOUT) {
+        CHECK_STATUS_MACRO(status);
+    }
+}
+
+static void opsWaitHistory(void *ptr, unsigned long long timeoutNs)
+{
+    osplEndpoint *reader = ptr;
+    DDS_Duration_t timeout;
+    DDS_ReturnCode_t status;
+
+    timeout.sec = (DDS_long)(timeoutNs / 1000000000ULL);
+    timeout.nanosec = (DDS_unsigned_long)(timeoutNs % 1000000000ULL);
+    status = DDS_DataReader_wait_for_historical_data(reader->entity, &timeout);
+    if (status != DDS_RETCODE_TIMEOUT) {
+        CHECK_STATUS_MACRO(status);
+    }
+}
+
+const ddsbench_ops ospl_ops = {
+    .writerNew = opsWriterNew,
+    .readerNew = opsReaderNew,
+    .writerFree = opsWriterFree,
+    .readerFree = opsReaderFree,
+    .waitMatched = opsWaitMatched,
+    .write = opsWrite,
+    .flush = opsFlush,
+    .take = opsTake,
+    .takeDone = opsTakeDone,
+    .wait = opsWait,
+    .writersGone = opsWritersGone,
+    .terminated = opsTerminated,
+    .waitSetNew = opsWaitSetNew,
+    .waitAny = opsWaitAny,
+    .waitSetFree = opsWaitSetFree,
+    .waitAcked = opsWaitAcked,
+    .waitHistory = opsWaitHistory
+};
@@ -36,6 +36,11 @@ int init(ddsbench_context *config)
 {
     DDS_ReturnCode_t status;
 
+    /** A generated configuration overrides OSPL_URI, see --ospl-mode */
+    if (ddsbench_osplConfigInit()) {
+        return -1;
+    }
+
     /* Register handler for Ctrl-C */
 #ifdef _WIN32
     SetConsoleCtrlHandler((PHANDLER_ROUTINE)CtrlHandler, TRUE);
@@ -48,10 +53,11 @@ int init(ddsbench_context *config)
 #endif
     terminated = DDS_GuardCondition__alloc();
 
-    char uri[1024], cwd[1024];
-    getcwd(cwd, sizeof(cwd));
-    sprintf(uri, "file://%s/ospl.xml", cwd);
-    //setenv("OSPL_URI", uri, 1); temporarily disable overriding environment
+    /** Readers always take with a loan, that is returned after use */
+    if (config->take == DDSBENCH_TAKE_COPY) {
+        printf("ddsbench: --take copy is not supported by OpenSplice, samples are loaned\n");
+    }
+    config->take = DDSBENCH_TAKE_LOAN;
 
     printf("\n");
     printf("ddsbench: create participant\n");
@@ -67,6 +73,7 @@ int init(ddsbench_context *config)
 
     return 0;
 error:
+    ddsbench_osplConfigFini();
     return -1;
 }
 
@@ -82,31 +89,52 @@ void fini()
     CHECK_STATUS_MACRO(status);
     status = DDS_DomainParticipantFactory_delete_participant(ddsbench_factory, ddsbench_dp);
     CHECK_STATUS_MACRO(status);
+    ddsbench_osplConfigFini();
 }
 
-DDS_TopicQos* ddsbench_getQos(char *qos) {
-    DDS_TopicQos *result = DDS_TopicQos__alloc();
-    DDS_DomainParticipant_get_default_topic_qos(ddsbench_dp, result);
-
-    char *ptr, ch;
-    for (ptr = qos; (ch = *ptr); ptr++) {
-        if (ch == 'v') {
-            result->durability.kind = DDS_VOLATILE_DURABILITY_QOS;
-        } else if (ch == 't') {
-            result->durability.kind = DDS_TRANSIENT_DURABILITY_QOS;
-        } else if (ch == 'p') {
-            result->durability.kind = DDS_PERSISTENT_DURABILITY_QOS;
-        } else if (ch == 'b') {
-            result->reliability.kind = DDS_BEST_EFFORT_RELIABILITY_QOS;
-        } else if (ch == 'r') {
-            result->reliability.kind = DDS_RELIABLE_RELIABILITY_QOS;
-            result->reliability.max_blocking_time.sec = 10;
-            result->reliability.max_blocking_time.nanosec = 0;
+/** The plugin descriptor, through which ddsbench finds the functions above
+ *  and the endpoints the engine runs on, and learns what OpenSplice supports.
+ *  Readers always loan, subscribers and pool workers wait in a waitset and
+ *  writes are not batched. The durability service aligns transient and
+ *  persistent history. */
+const ddsbench_plugin ddsbench_pluginDescriptor = {
+    .version = DDSBENCH_PLUGIN_VERSION,
+    .name = "ospl",
+    .description = "Vortex OpenSplice",
+    .capabilities = DDSBENCH_CAP_LOANS | DDSBENCH_CAP_FILTERS | DDSBENCH_CAP_DURABILITY | DDSBENCH_CAP_DDSI,
+    .init = init,
+    .fini = fini,
+    .ops = &ospl_ops
+};
+
+void ddsbench_waitMatched(ddsbench_threadArg *arg, DDS_DataWriter writer, DDS_DataReader reader) {
+    DDS_PublicationMatchedStatus pms = { 0 };
+    DDS_SubscriptionMatchedStatus sms = { 0 };
+    unsigned long long deadline = ddsbench_time() + DDSBENCH_MATCH_TIMEOUT_NS;
+    DDS_ReturnCode_t status;
+
+    for (;;) {
+        if (writer) {
+            status = DDS_DataWriter_get_publication_matched_status(writer, &pms);
+            CHECK_STATUS_MACRO(status);
+        }
+        if (reader) {
+            status = DDS_DataReader_get_subscription_matched_status(reader, &sms);
+            CHECK_STATUS_MACRO(status);
+        }
+        if ((!writer || pms.current_count >= (DDS_long)arg->ctx->readers) &&
+            (!reader || sms.current_count >= (DDS_long)arg->ctx->writers)) {
+            break;
         }
+        if (DDS_GuardCondition_get_trigger_value(terminated) || ddsbench_time() > deadline) {
+            printf("%s %d: matched %d of %u readers and %d of %u writers, starting anyway\n",
+                arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id,
+                writer ? pms.current_count : 0, writer ? arg->ctx->readers : 0,
+                reader ? sms.current_count : 0, reader ? arg->ctx->writers : 0);
+            break;
+        }
+        exampleSleepMilliseconds(1);
     }
 
-    result->history.kind = DDS_KEEP_ALL_HISTORY_QOS;
-    result->resource_limits.max_samples = 100;
-
-    return result;
+    arg->result.readyNs = ddsbench_time() - arg->startNs;
 }
@@ -0,0 +1,2 @@
+set -x
+gcc src/*.c -g -I../include -Iinclude -pthread -pipe -Wall -fno-strict-aliasing -O3 -std=c99 -D_GNU_SOURCE -fPIC -shared -lrt -o libshm.so
@@ -0,0 +1,182 @@
+
+#ifndef SHM_H
+#define SHM_H
+
+#include <ddsbench.h>
+
+#ifdef __cplusplus
+extern "c" {
+#endif
+
+/* Set when the benchmark is interrupted (SIGINT) */
+extern volatile int shm_terminated;
+
+/* Time waits are cut into, so that termination and deadlines are noticed */
+#define SHM_WAIT_NS 100000000ULL
+
+/* Time a reliable writer waits for space in a full ring, like max_blocking_time */
+#define SHM_BLOCKING_NS 10000000000ULL
+
+/* Layout of a segment, processes only share a segment of the same version */
+#define SHM_MAGIC 0x64647362656e6368ULL
+#define SHM_VERSION 1
+
+/* Endpoints that can be attached to a segment at the same time */
+#define SHM_MAX_READERS 64
+#define SHM_MAX_WRITERS 64
+
+/* A sample as it is stored in a slot of the ring. The header takes one
+ * cache line, the payload follows it. */
+typedef struct shm_sample {
+    unsigned long long seq;         /* Position the slot was published at, plus one */
+    unsigned long long count;
+    unsigned long long timestamp;   /* ddsbench_time of the write, the clock is shared by the host */
+    int id;
+    int filter;
+    unsigned int length;            /* Bytes of payload */
+    unsigned int flags;
+    char pad[24];
+} shm_sample;
+
+#define SHM_PAYLOAD(sample) ((unsigned char *)(sample) + sizeof(shm_sample))
+
+/* States of an endpoint entry in a segment */
+#define SHM_FREE 0
+#define SHM_JOINING 1
+#define SHM_ACTIVE 2
+
+/* A reader of the ring. Every reader has a cursor of its own, the slot of a
+ * position is reused once all readers have passed it. */
+typedef struct shm_cursor {
+    unsigned long long head __attribute__((aligned(64)));  /* Next position to read, the ones before are released */
+    unsigned int state;
+    int pid;
+} shm_cursor;
+
+typedef struct shm_writerEntry {
+    unsigned int state;
+    int pid;
+} shm_writerEntry;
+
+/* The start of a segment, shared by every process that has it mapped. The
+ * ring of samples follows it on the next page. Writers claim positions with
+ * compare-and-swap and publish a slot by setting its sequence, so that all
+ * readers read the sample from the same slot. Readers and writers that find
+ * the ring empty or full block on a futex, which is only woken when somebody
+ * waits on it. */
+typedef struct shm_header {
+    unsigned long long magic;
+    unsigned int version;
+    unsigned int ready;             /* Set by the creator once the segment is initialised */
+    unsigned int capacity;          /* Slots, a power of two */
+    unsigned long slotSize;
+    unsigned long size;             /* Bytes of the segment */
+    int numReaders;                 /* Active entries in readers and writers */
+    int numWriters;
+
+    /* Producer side */
+    unsigned long long claim __attribute__((aligned(64)));  /* Next position to write */
+    unsigned int spaceSeq;          /* Futex of writers waiting for space */
+    unsigned int spaceWaiters;
+
+    /* Consumer side */
+    unsigned int dataSeq __attribute__((aligned(64)));      /* Futex of readers waiting for data */
+    unsigned int dataWaiters;
+
+    shm_writerEntry writers[SHM_MAX_WRITERS];
+    shm_cursor readers[SHM_MAX_READERS];
+} shm_header;
+
+/* A segment mapped by an endpoint, one per topic and partition */
+typedef struct shm_segment {
+    char name[256];
+    shm_header *header;
+    unsigned char *slots;
+    unsigned long mapped;
+} shm_segment;
+
+/* Map the segment of topic in partition, creating it when this is the first
+ * endpoint, with capacity slots of payload bytes. An existing segment must
+ * have slots that hold payload bytes, unless it has no live endpoints, in
+ * which case it is replaced. Closing the last endpoint of all processes
+ * removes the segment, entries of processes that died are freed when found. */
+int shm_segmentOpen(shm_segment *segment, const char *topicName, const char *partition, unsigned int capacity, unsigned long payload);
+void shm_segmentClose(shm_segment *segment);
+
+/* Free the entries of processes that are gone, returns the live entries */
+int shm_segmentPrune(shm_segment *segment);
+
+/* Slot of a position, and futex waits and wakes across processes */
+shm_sample* shm_slot(shm_segment *segment, unsigned long long pos);
+void shm_futexWait(unsigned int *word, unsigned int value, unsigned long long timeoutNs);
+void shm_futexWake(unsigned int *word);
+
+/* Endpoints */
+typedef struct shm_writer {
+    shm_segment segment;
+    int entry;                      /* Index in header->writers */
+    unsigned long long minHead;     /* Lowest reader head seen, a lower bound of the real one */
+    int reliable;
+    int batch;                      /* Wake readers once per burst */
+    int pending;                    /* Samples published since the last wake */
+} shm_writer;
+
+typedef struct shm_reader {
+    shm_segment segment;
+    int entry;                      /* Index in header->readers */
+    unsigned long long next;        /* Next position to peek, ahead of head with loans */
+    int matched;                    /* Saw a writer once, see shm_writersGone */
+} shm_reader;
+
+shm_writer* shm_writerNew(ddsbench_threadArg *arg, const char *partition, unsigned int capacity, int reliable);
+void shm_writerFree(shm_writer *writer);
+shm_reader* shm_readerNew(ddsbench_threadArg *arg, const char *partition, unsigned int capacity);
+void shm_readerFree(shm_reader *reader);
+
+/* Loan the slot of the next position and publish it once it is filled. A
+ * full ring makes a reliable writer wait up to SHM_BLOCKING_NS, after which
+ * shm_writerLoan returns NULL with *timedOut set. A best effort writer, or
+ * a writer without readers, gets NULL right away and the sample is dropped.
+ * Without flush a batching writer leaves waking readers to the next flushed
+ * commit or shm_writerFlush. */
+shm_sample* shm_writerLoan(shm_writer *writer, unsigned long long *pos, int *timedOut);
+void shm_writerCommit(shm_writer *writer, shm_sample *sample, unsigned long long pos, int flush);
+void shm_writerFlush(shm_writer *writer);
+
+/* Write a copy of a payload, the loan, fill and commit of a sample. Returns
+ * nonzero if the writer timed out. */
+int shm_write(shm_writer *writer, int id, unsigned long long count, const void *payload, unsigned int length, int flush);
+
+/* Readers loan the samples in the ring in order, and release them when done,
+ * which releases the samples loaned before as well. Peek returns NULL when
+ * the ring is empty. */
+shm_sample* shm_readerPeek(shm_reader *reader, unsigned long long *pos);
+void shm_readerRelease(shm_reader *reader, unsigned long long pos);
+int shm_readerEmpty(shm_reader *reader);
+
+/* Block until the ring has data, or timeoutNs passed */
+void shm_readerWait(shm_reader *reader, unsigned long long timeoutNs);
+
+/* Matched counts, over all processes */
+int shm_matchedReaders(shm_writer *writer);
+int shm_matchedWriters(shm_reader *reader);
+
+/* Whether the writers a reader was matched with are all gone */
+int shm_writersGone(shm_reader *reader);
+
+/* Wait until writer and reader (either may be NULL) are matched with the
+ * number of readers and writers the benchmark expects, and set readyNs */
+void shm_waitMatched(ddsbench_threadArg *arg, shm_writer *writer, shm_reader *reader);
+
+/* Endpoints the harness runs the latency and throughput threads on */
+extern const ddsbench_ops shm_ops;
+
+/* Functions of the plugin, exported through its descriptor in shm.c */
+int init(ddsbench_context *ctx);
+void fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
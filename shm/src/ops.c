@@ -0,0 +1,177 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <shm.h>
+
+/* Samples in the ring of a latency topic, a roundtrip has one in flight */
+#define ROUNDTRIP_RING_SAMPLES 16
+
+/* Samples in the ring of a throughput topic when --maxsamples is unlimited,
+ * and the most memory a ring maps */
+#define THROUGHPUT_RING_SAMPLES 4096
+#define THROUGHPUT_RING_BYTES (256UL * 1024 * 1024)
+
+/* The most memory a copying reader takes samples into */
+#define COPY_BYTES (16UL * 1024 * 1024)
+
+/* A reader of the engine, which takes samples in place or copies them out */
+typedef struct opsReader {
+    shm_reader *reader;
+    unsigned char *copies;          /* Copies of the samples taken, NULL when loaned */
+    unsigned long slotSize;
+    int maxTake;
+    unsigned long long pos;         /* Position of the last sample taken */
+    int taken;                      /* Samples taken and not yet released */
+} opsReader;
+
+/* Slots of the ring of a topic, whichever of its endpoints creates it */
+static unsigned int ringCapacity(ddsbench_context *ctx, ddsbench_endpointKind kind)
+{
+    unsigned long slotSize = sizeof(shm_sample) + ctx->payload;
+    unsigned int capacity;
+
+    if (kind == DDSBENCH_LATENCY) {
+        return ROUNDTRIP_RING_SAMPLES;
+    }
+    capacity = ctx->maxsamples > 0 ? (unsigned int)ctx->maxsamples : THROUGHPUT_RING_SAMPLES;
+    if (capacity > THROUGHPUT_RING_BYTES / slotSize) {
+        capacity = THROUGHPUT_RING_BYTES / slotSize;
+    }
+    return capacity;
+}
+
+static void* opsWriterNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos)
+{
+    return shm_writerNew(arg, partition, ringCapacity(arg->ctx, kind), qos->reliable);
+}
+
+static void* opsReaderNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos, ddsbench_listenerFn listener, void *listenerArg)
+{
+    ddsbench_context *ctx = arg->ctx;
+    opsReader *reader;
+
+    if (!(reader = calloc(1, sizeof(opsReader)))) {
+        printf("sub %d: out of memory\n", arg->id);
+        return NULL;
+    }
+    reader->slotSize = sizeof(shm_sample) + ctx->payload;
+    reader->maxTake = COPY_BYTES / reader->slotSize ? COPY_BYTES / reader->slotSize : 1;
+
+    /* Bound the memory of the copies a reader takes */
+    if (ctx->take == DDSBENCH_TAKE_COPY && !(reader->copies = malloc(reader->maxTake * reader->slotSize))) {
+        printf("sub %d: out of memory\n", arg->id);
+        free(reader);
+        return NULL;
+    }
+    if (!(reader->reader = shm_readerNew(arg, partition, ringCapacity(ctx, kind)))) {
+        free(reader->copies);
+        free(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+static void opsWriterFree(void *writer)
+{
+    shm_writerFree(writer);
+}
+
+static void opsReaderFree(void *ptr)
+{
+    opsReader *reader = ptr;
+
+    shm_readerFree(reader->reader);
+    free(reader->copies);
+    free(reader);
+}
+
+static void opsWaitMatched(ddsbench_threadArg *arg, void *writer, void *reader)
+{
+    shm_waitMatched(arg, writer, reader ? ((opsReader *)reader)->reader : NULL);
+}
+
+static int opsWrite(void *writer, const ddsbench_sample *sample)
+{
+    return shm_write(writer, sample->id, sample->count, sample->payload, sample->length, 0) ?
+        DDSBENCH_WRITE_TIMEOUT : DDSBENCH_WRITE_OK;
+}
+
+static void opsFlush(void *writer)
+{
+    shm_writerFlush(writer);
+}
+
+/* Take the samples in the ring, copied out or in place */
+static int opsTake(void *ptr, ddsbench_sample *samples, int max)
+{
+    opsReader *reader = ptr;
+    shm_sample *sample;
+    int n;
+
+    if (reader->copies && max > reader->maxTake) {
+        max = reader->maxTake;
+    }
+    for (n = 0; n < max && (sample = shm_readerPeek(reader->reader, &reader->pos)); n++) {
+        if (reader->copies) {
+            sample = memcpy(reader->copies + n * reader->slotSize, sample, sizeof(shm_sample) + sample->length);
+        }
+        samples[n].id = sample->id;
+        samples[n].filter = sample->filter;
+        samples[n].count = sample->count;
+        samples[n].timestamp = sample->timestamp;
+        samples[n].payload = SHM_PAYLOAD(sample);
+        samples[n].length = sample->length;
+    }
+    if (n && reader->copies) {
+        shm_readerRelease(reader->reader, reader->pos);
+    } else {
+        reader->taken = n;
+    }
+    return n;
+}
+
+static void opsTakeDone(void *ptr)
+{
+    opsReader *reader = ptr;
+
+    if (reader->taken) {
+        shm_readerRelease(reader->reader, reader->pos);
+        reader->taken = 0;
+    }
+}
+
+static void opsWait(void *reader, unsigned long long timeoutNs)
+{
+    shm_readerWait(((opsReader *)reader)->reader, timeoutNs);
+}
+
+static int opsWritersGone(void *ptr)
+{
+    shm_reader *reader = ((opsReader *)ptr)->reader;
+
+    return shm_writersGone(reader) && shm_readerEmpty(reader);
+}
+
+static int opsTerminated(void)
+{
+    return shm_terminated;
+}
+
+const ddsbench_ops shm_ops = {
+    .writerNew = opsWriterNew,
+    .readerNew = opsReaderNew,
+    .writerFree = opsWriterFree,
+    .readerFree = opsReaderFree,
+    .waitMatched = opsWaitMatched,
+    .write = opsWrite,
+    .flush = opsFlush,
+    .take = opsTake,
+    .takeDone = opsTakeDone,
+    .wait = opsWait,
+    .writersGone = opsWritersGone,
+    .terminated = opsTerminated
+};
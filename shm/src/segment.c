@@ -0,0 +1,238 @@
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include <shm.h>
+
+#define LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define STORE(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+
+/* Time an endpoint waits for the creator of a segment to initialise it */
+#define SHM_CREATE_NS 1000000000ULL
+
+#define HEADER_SIZE ((sizeof(shm_header) + 4095) & ~4095UL)
+
+/* Futexes are shared with other processes, so they are not private */
+void shm_futexWait(unsigned int *word, unsigned int value, unsigned long long timeoutNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = timeoutNs / 1000000000ULL;
+    ts.tv_nsec = timeoutNs % 1000000000ULL;
+    syscall(SYS_futex, word, FUTEX_WAIT, value, &ts, NULL, 0);
+}
+
+void shm_futexWake(unsigned int *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+shm_sample* shm_slot(shm_segment *segment, unsigned long long pos)
+{
+    shm_header *header = segment->header;
+    return (shm_sample *)(segment->slots + (pos & (header->capacity - 1)) * header->slotSize);
+}
+
+static int pidAlive(int pid)
+{
+    return pid == getpid() || kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/* Free an entry whose process is gone, an entry that is joining has no pid yet */
+static int pruneEntry(unsigned int *state, int *pid, int *count)
+{
+    unsigned int s = LOAD(state);
+    int p = LOAD(pid);
+
+    if (s == SHM_FREE || !p) {
+        return s != SHM_FREE;
+    }
+    if (pidAlive(p)) {
+        return 1;
+    }
+    if (__atomic_compare_exchange_n(state, &s, SHM_FREE, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        STORE(pid, 0);
+        if (s == SHM_ACTIVE) {
+            __atomic_sub_fetch(count, 1, __ATOMIC_ACQ_REL);
+        }
+    }
+    return 0;
+}
+
+int shm_segmentPrune(shm_segment *segment)
+{
+    shm_header *header = segment->header;
+    int i, live = 0;
+
+    for (i = 0; i < SHM_MAX_WRITERS; i++) {
+        live += pruneEntry(&header->writers[i].state, &header->writers[i].pid, &header->numWriters);
+    }
+    for (i = 0; i < SHM_MAX_READERS; i++) {
+        live += pruneEntry(&header->readers[i].state, &header->readers[i].pid, &header->numReaders);
+    }
+    return live;
+}
+
+/* Map an existing segment, once its creator initialised it */
+static int segmentAttach(shm_segment *segment, int fd)
+{
+    unsigned long long deadline = ddsbench_time() + SHM_CREATE_NS;
+    struct timespec delay = { 0, 1000000 };
+    struct stat st;
+    shm_header *header;
+
+    for (;;) {
+        if (fstat(fd, &st)) {
+            return -1;
+        }
+        if ((unsigned long)st.st_size >= HEADER_SIZE) {
+            break;
+        }
+        if (ddsbench_time() > deadline) {
+            printf("error: shared memory segment %s is not initialised\n", segment->name);
+            return -1;
+        }
+        nanosleep(&delay, NULL);
+    }
+
+    header = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (header == MAP_FAILED) {
+        printf("error: failed to map shared memory segment %s: %s\n", segment->name, strerror(errno));
+        return -1;
+    }
+    while (!LOAD(&header->ready) && ddsbench_time() < deadline) {
+        nanosleep(&delay, NULL);
+    }
+    segment->header = header;
+    segment->slots = (unsigned char *)header + HEADER_SIZE;
+    segment->mapped = st.st_size;
+    return 0;
+}
+
+/* Whether a mapped segment can hold slots of slotSize, optionally saying why not */
+static int segmentCompatible(shm_segment *segment, unsigned long slotSize, int report)
+{
+    shm_header *header = segment->header;
+
+    if (!LOAD(&header->ready) || header->magic != SHM_MAGIC || header->version != SHM_VERSION ||
+        header->size != segment->mapped)
+    {
+        if (report) {
+            printf("error: shared memory segment %s is not a ddsbench segment of version %d\n", segment->name, SHM_VERSION);
+        }
+        return 0;
+    }
+    if (header->slotSize < slotSize) {
+        if (report) {
+            printf("error: shared memory segment %s holds payloads up to %lu bytes\n",
+                segment->name, header->slotSize - sizeof(shm_sample));
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/* Create and initialise a segment, fd is new and empty */
+static int segmentCreate(shm_segment *segment, int fd, unsigned int capacity, unsigned long slotSize)
+{
+    unsigned long size = HEADER_SIZE + capacity * slotSize;
+    shm_header *header;
+
+    if (ftruncate(fd, size)) {
+        printf("error: failed to size shared memory segment %s: %s\n", segment->name, strerror(errno));
+        return -1;
+    }
+
+    /* Slots are touched now, so that writing them does not fault later */
+    header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (header == MAP_FAILED) {
+        printf("error: failed to map shared memory segment %s: %s\n", segment->name, strerror(errno));
+        return -1;
+    }
+    header->magic = SHM_MAGIC;
+    header->version = SHM_VERSION;
+    header->capacity = capacity;
+    header->slotSize = slotSize;
+    header->size = size;
+    STORE(&header->ready, 1);
+
+    segment->header = header;
+    segment->slots = (unsigned char *)header + HEADER_SIZE;
+    segment->mapped = size;
+    return 0;
+}
+
+int shm_segmentOpen(shm_segment *segment, const char *topicName, const char *partition, unsigned int capacity, unsigned long payload)
+{
+    unsigned long slotSize = (sizeof(shm_sample) + payload + 63) & ~63UL;
+    unsigned int slots = 2;
+    int fd, status, retry = 1;
+
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    memset(segment, 0, sizeof(shm_segment));
+    snprintf(segment->name, sizeof(segment->name), "/ddsbench.%s.%s", partition, topicName);
+
+    for (;;) {
+        if ((fd = shm_open(segment->name, O_RDWR | O_CREAT | O_EXCL, 0600)) >= 0) {
+            status = segmentCreate(segment, fd, slots, slotSize);
+            close(fd);
+            if (status) {
+                shm_unlink(segment->name);
+            }
+            break;
+        }
+        if (errno != EEXIST || (fd = shm_open(segment->name, O_RDWR, 0)) < 0) {
+            printf("error: failed to open shared memory segment %s: %s\n", segment->name, strerror(errno));
+            return -1;
+        }
+        status = segmentAttach(segment, fd);
+        close(fd);
+        if (status || segmentCompatible(segment, slotSize, 0)) {
+            break;
+        }
+
+        /* A segment left behind by processes that are gone is replaced */
+        if (retry-- && !shm_segmentPrune(segment)) {
+            munmap(segment->header, segment->mapped);
+            segment->header = NULL;
+            shm_unlink(segment->name);
+            continue;
+        }
+        segmentCompatible(segment, slotSize, 1);
+        printf("error: remove %s from /dev/shm once the processes that use it are done\n", segment->name);
+        status = -1;
+        break;
+    }
+
+    if (status && segment->header) {
+        munmap(segment->header, segment->mapped);
+        segment->header = NULL;
+    }
+    return status ? -1 : 0;
+}
+
+void shm_segmentClose(shm_segment *segment)
+{
+    if (!segment->header) {
+        return;
+    }
+
+    /* The last endpoint of all processes removes the segment */
+    if (!shm_segmentPrune(segment)) {
+        shm_unlink(segment->name);
+    }
+    munmap(segment->header, segment->mapped);
+    segment->header = NULL;
+}
@@ -0,0 +1,401 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <shm.h>
+
+#define LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define STORE(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+
+volatile int shm_terminated;
+
+static struct sigaction oldAction;
+
+static void CtrlHandler(int fdwCtrlType)
+{
+    shm_terminated = 1;
+}
+
+int init(ddsbench_context *ctx)
+{
+    struct sigaction sat;
+
+    sat.sa_handler = CtrlHandler;
+    sigemptyset(&sat.sa_mask);
+    sat.sa_flags = 0;
+    sigaction(SIGINT, &sat, &oldAction);
+    shm_terminated = 0;
+
+    /* Readers process samples in the shared slots unless copies are requested */
+    if (ctx->take == DDSBENCH_TAKE_DEFAULT) {
+        ctx->take = DDSBENCH_TAKE_LOAN;
+    }
+
+    return 0;
+}
+
+void fini(void)
+{
+    sigaction(SIGINT, &oldAction, 0);
+}
+
+/* The plugin descriptor. Processes on a host exchange samples through a ring
+ * in a shared memory segment per topic and partition, which readers loan
+ * samples from. Readers share the slots, so they filter after take. */
+const ddsbench_plugin ddsbench_pluginDescriptor = {
+    .version = DDSBENCH_PLUGIN_VERSION,
+    .name = "shm",
+    .description = "shared memory rings between processes, no middleware",
+    .capabilities = DDSBENCH_CAP_LOANS | DDSBENCH_CAP_BATCHING,
+    .init = init,
+    .fini = fini,
+    .ops = &shm_ops
+};
+
+/* Take a free entry, which is joining until the caller activates it */
+static int entryJoin(unsigned int *state, int *pid)
+{
+    unsigned int s = SHM_FREE;
+
+    if (!__atomic_compare_exchange_n(state, &s, SHM_JOINING, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return -1;
+    }
+    STORE(pid, getpid());
+    return 0;
+}
+
+static void entryLeave(unsigned int *state, int *pid, int *count)
+{
+    __atomic_sub_fetch(count, 1, __ATOMIC_ACQ_REL);
+    STORE(pid, 0);
+    STORE(state, SHM_FREE);
+}
+
+shm_writer* shm_writerNew(ddsbench_threadArg *arg, const char *partition, unsigned int capacity, int reliable)
+{
+    shm_writer *writer;
+    shm_header *header;
+    int i;
+
+    if (!(writer = calloc(1, sizeof(shm_writer)))) {
+        return NULL;
+    }
+    if (shm_segmentOpen(&writer->segment, arg->topicName, partition, capacity, arg->ctx->payload)) {
+        free(writer);
+        return NULL;
+    }
+    header = writer->segment.header;
+
+    for (i = 0; i < SHM_MAX_WRITERS && entryJoin(&header->writers[i].state, &header->writers[i].pid); i++);
+    if (i == SHM_MAX_WRITERS) {
+        printf("pub %d: %s has %d writers already\n", arg->id, writer->segment.name, SHM_MAX_WRITERS);
+        shm_segmentClose(&writer->segment);
+        free(writer);
+        return NULL;
+    }
+    writer->entry = i;
+    writer->reliable = reliable;
+    writer->batch = arg->ctx->batch;
+    __atomic_add_fetch(&header->numWriters, 1, __ATOMIC_ACQ_REL);
+    STORE(&header->writers[i].state, SHM_ACTIVE);
+
+    return writer;
+}
+
+void shm_writerFree(shm_writer *writer)
+{
+    shm_header *header;
+
+    if (!writer) {
+        return;
+    }
+    header = writer->segment.header;
+
+    /* Readers wake up to the last samples, and notice that the writer is gone */
+    entryLeave(&header->writers[writer->entry].state, &header->writers[writer->entry].pid, &header->numWriters);
+    writer->pending = 1;
+    shm_writerFlush(writer);
+
+    shm_segmentClose(&writer->segment);
+    free(writer);
+}
+
+shm_reader* shm_readerNew(ddsbench_threadArg *arg, const char *partition, unsigned int capacity)
+{
+    shm_reader *reader;
+    shm_header *header;
+    shm_cursor *cursor;
+    int i;
+
+    if (!(reader = calloc(1, sizeof(shm_reader)))) {
+        return NULL;
+    }
+    if (shm_segmentOpen(&reader->segment, arg->topicName, partition, capacity, arg->ctx->payload)) {
+        free(reader);
+        return NULL;
+    }
+    header = reader->segment.header;
+
+    for (i = 0; i < SHM_MAX_READERS && entryJoin(&header->readers[i].state, &header->readers[i].pid); i++);
+    if (i == SHM_MAX_READERS) {
+        printf("sub %d: %s has %d readers already\n", arg->id, reader->segment.name, SHM_MAX_READERS);
+        shm_segmentClose(&reader->segment);
+        free(reader);
+        return NULL;
+    }
+
+    /* A reader starts at the next position a writer claims. Writers do not
+     * pass the lowest head they saw while a reader is joining, and no head
+     * is past the claim, so its first slot is not overwritten. */
+    cursor = &header->readers[i];
+    reader->entry = i;
+    reader->next = __atomic_load_n(&header->claim, __ATOMIC_SEQ_CST);
+    STORE(&cursor->head, reader->next);
+    __atomic_add_fetch(&header->numReaders, 1, __ATOMIC_ACQ_REL);
+    STORE(&cursor->state, SHM_ACTIVE);
+
+    return reader;
+}
+
+void shm_readerFree(shm_reader *reader)
+{
+    shm_header *header;
+
+    if (!reader) {
+        return;
+    }
+    header = reader->segment.header;
+
+    /* Writers that wait for this reader can go on */
+    entryLeave(&header->readers[reader->entry].state, &header->readers[reader->entry].pid, &header->numReaders);
+    __atomic_add_fetch(&header->spaceSeq, 1, __ATOMIC_SEQ_CST);
+    shm_futexWake(&header->spaceSeq);
+
+    shm_segmentClose(&reader->segment);
+    free(reader);
+}
+
+/* The lowest head of the readers, or the claim when there are none. The
+ * claim, the states and the claims of readers that join are sequentially
+ * consistent, so a reader that joins sees a claim no later than this one,
+ * or is seen joining. */
+static unsigned long long minHead(shm_writer *writer)
+{
+    shm_header *header = writer->segment.header;
+    unsigned long long min = __atomic_load_n(&header->claim, __ATOMIC_SEQ_CST);
+    int i;
+
+    for (i = 0; i < SHM_MAX_READERS; i++) {
+        unsigned int state = __atomic_load_n(&header->readers[i].state, __ATOMIC_SEQ_CST);
+        if (state == SHM_ACTIVE) {
+            unsigned long long head = LOAD(&header->readers[i].head);
+            if ((long long)(head - min) < 0) {
+                min = head;
+            }
+        } else if (state == SHM_JOINING) {
+            return writer->minHead;
+        }
+    }
+    return min;
+}
+
+/* Whether position p is free for writing, refreshing the lowest head if it seems not */
+static int hasSpace(shm_writer *writer, unsigned long long p)
+{
+    unsigned int capacity = writer->segment.header->capacity;
+
+    if ((long long)(p - writer->minHead) < capacity) {
+        return 1;
+    }
+    writer->minHead = minHead(writer);
+    return (long long)(p - writer->minHead) < capacity;
+}
+
+/* Wait until a reader released a slot, pruning readers of processes that died */
+static void waitSpace(shm_writer *writer, unsigned long long timeoutNs)
+{
+    shm_header *header = writer->segment.header;
+    unsigned int seq;
+
+    __atomic_add_fetch(&header->spaceWaiters, 1, __ATOMIC_SEQ_CST);
+    seq = __atomic_load_n(&header->spaceSeq, __ATOMIC_SEQ_CST);
+    if (!hasSpace(writer, LOAD(&header->claim))) {
+        shm_futexWait(&header->spaceSeq, seq, timeoutNs);
+    }
+    __atomic_sub_fetch(&header->spaceWaiters, 1, __ATOMIC_SEQ_CST);
+    if (!hasSpace(writer, LOAD(&header->claim))) {
+        shm_segmentPrune(&writer->segment);
+    }
+}
+
+shm_sample* shm_writerLoan(shm_writer *writer, unsigned long long *pos, int *timedOut)
+{
+    shm_header *header = writer->segment.header;
+    unsigned long long p, deadline = 0;
+
+    *timedOut = 0;
+    if (!LOAD(&header->numReaders)) {
+        return NULL;
+    }
+
+    p = __atomic_load_n(&header->claim, __ATOMIC_RELAXED);
+    for (;;) {
+        if (!hasSpace(writer, p)) {
+            unsigned long long now = ddsbench_time();
+
+            if (!writer->reliable || !LOAD(&header->numReaders)) {
+                return NULL;
+            }
+            if (!deadline) {
+                deadline = now + SHM_BLOCKING_NS;
+                shm_writerFlush(writer);
+            } else if (shm_terminated || now >= deadline) {
+                *timedOut = !shm_terminated;
+                return NULL;
+            }
+            waitSpace(writer, deadline - now < SHM_WAIT_NS ? deadline - now : SHM_WAIT_NS);
+            p = __atomic_load_n(&header->claim, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&header->claim, &p, p + 1, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            *pos = p;
+            return shm_slot(&writer->segment, p);
+        }
+    }
+}
+
+void shm_writerCommit(shm_writer *writer, shm_sample *sample, unsigned long long pos, int flush)
+{
+    STORE(&sample->seq, pos + 1);
+    writer->pending = 1;
+    if (flush || !writer->batch) {
+        shm_writerFlush(writer);
+    }
+}
+
+/* The waiter announces itself before it checks the ring, the waker checks
+ * for waiters after it changed the ring, so that one of them sees the other */
+void shm_writerFlush(shm_writer *writer)
+{
+    shm_header *header = writer->segment.header;
+
+    if (!writer->pending) {
+        return;
+    }
+    writer->pending = 0;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->dataWaiters, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&header->dataSeq, 1, __ATOMIC_SEQ_CST);
+        shm_futexWake(&header->dataSeq);
+    }
+}
+
+int shm_write(shm_writer *writer, int id, unsigned long long count, const void *payload, unsigned int length, int flush)
+{
+    shm_sample *sample;
+    unsigned long long pos;
+    int timedOut;
+
+    if (!(sample = shm_writerLoan(writer, &pos, &timedOut))) {
+        return timedOut;
+    }
+    sample->count = count;
+    sample->timestamp = ddsbench_time();
+    sample->id = id;
+    sample->filter = count % 10;
+    sample->length = length;
+    sample->flags = 0;
+    memcpy(SHM_PAYLOAD(sample), payload, length);
+    shm_writerCommit(writer, sample, pos, flush);
+
+    return 0;
+}
+
+shm_sample* shm_readerPeek(shm_reader *reader, unsigned long long *pos)
+{
+    shm_sample *sample = shm_slot(&reader->segment, reader->next);
+
+    /* A slot holds the sample of position p when its sequence is p + 1 */
+    if (LOAD(&sample->seq) != reader->next + 1) {
+        return NULL;
+    }
+    *pos = reader->next++;
+    return sample;
+}
+
+void shm_readerRelease(shm_reader *reader, unsigned long long pos)
+{
+    shm_header *header = reader->segment.header;
+
+    STORE(&header->readers[reader->entry].head, pos + 1);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->spaceWaiters, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&header->spaceSeq, 1, __ATOMIC_SEQ_CST);
+        shm_futexWake(&header->spaceSeq);
+    }
+}
+
+int shm_readerEmpty(shm_reader *reader)
+{
+    return LOAD(&shm_slot(&reader->segment, reader->next)->seq) != reader->next + 1;
+}
+
+void shm_readerWait(shm_reader *reader, unsigned long long timeoutNs)
+{
+    shm_header *header = reader->segment.header;
+    unsigned int seq;
+
+    __atomic_add_fetch(&header->dataWaiters, 1, __ATOMIC_SEQ_CST);
+    seq = __atomic_load_n(&header->dataSeq, __ATOMIC_SEQ_CST);
+    if (shm_readerEmpty(reader)) {
+        shm_futexWait(&header->dataSeq, seq, timeoutNs);
+    }
+    __atomic_sub_fetch(&header->dataWaiters, 1, __ATOMIC_SEQ_CST);
+}
+
+int shm_matchedReaders(shm_writer *writer)
+{
+    return LOAD(&writer->segment.header->numReaders);
+}
+
+int shm_matchedWriters(shm_reader *reader)
+{
+    int count = LOAD(&reader->segment.header->numWriters);
+
+    if (count) {
+        reader->matched = 1;
+    }
+    return count;
+}
+
+int shm_writersGone(shm_reader *reader)
+{
+    return !shm_matchedWriters(reader) && reader->matched;
+}
+
+void shm_waitMatched(ddsbench_threadArg *arg, shm_writer *writer, shm_reader *reader)
+{
+    unsigned long long deadline = ddsbench_time() + DDSBENCH_MATCH_TIMEOUT_NS;
+    struct timespec delay = { 0, 1000000 };
+
+    for (;;) {
+        if ((!writer || shm_matchedReaders(writer) >= (int)arg->ctx->readers) &&
+            (!reader || shm_matchedWriters(reader) >= (int)arg->ctx->writers)) {
+            break;
+        }
+        if (shm_terminated || ddsbench_time() > deadline) {
+            printf("%s %d: matched %d of %u readers and %d of %u writers, starting anyway\n",
+                arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id,
+                writer ? shm_matchedReaders(writer) : 0, writer ? arg->ctx->readers : 0,
+                reader ? shm_matchedWriters(reader) : 0, reader ? arg->ctx->writers : 0);
+            break;
+        }
+        nanosleep(&delay, NULL);
+    }
+
+    arg->result.readyNs = ddsbench_time() - arg->startNs;
+}
@@ -0,0 +1,225 @@
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "core.h"
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+typedef enum ddsbench_affinityPolicy {
+    AFFINITY_NONE,
+    AFFINITY_LIST,      /* Threads are pinned round-robin to a list of cpus */
+    AFFINITY_COMPACT,   /* Threads fill up cores and nodes before using the next */
+    AFFINITY_SCATTER,   /* Threads are spread over nodes and cores */
+    AFFINITY_NUMA       /* Threads of a topic share the cpus of one node */
+} ddsbench_affinityPolicy;
+
+typedef struct ddsbench_cpu {
+    int cpu;
+    int node;
+    int package;
+    int core;
+    int sibling;    /* Index of the cpu among the hardware threads of its core */
+    int coreRank;   /* Index of the core among the cores of its node */
+} ddsbench_cpu;
+
+static ddsbench_affinityPolicy policy = AFFINITY_NONE;
+static ddsbench_cpu *cpus = NULL;
+static int numCpus = 0;
+static int numNodes = 0;
+static int nodes[CPU_SETSIZE];
+
+static int readInt(const char *fmt, int cpu)
+{
+    char path[256];
+    FILE *f;
+    int value = 0;
+
+    sprintf(path, fmt, cpu);
+    if ((f = fopen(path, "r"))) {
+        if (fscanf(f, "%d", &value) != 1) {
+            value = 0;
+        }
+        fclose(f);
+    }
+    return value;
+}
+
+static int readNode(int cpu)
+{
+    char path[256];
+    struct dirent *entry;
+    DIR *dir;
+    int node = 0;
+
+    sprintf(path, "/sys/devices/system/cpu/cpu%d", cpu);
+    if ((dir = opendir(path))) {
+        while ((entry = readdir(dir))) {
+            if (!strncmp(entry->d_name, "node", 4) && sscanf(entry->d_name + 4, "%d", &node) == 1) {
+                break;
+            }
+        }
+        closedir(dir);
+    }
+    return node;
+}
+
+static int compareCompact(const void *p1, const void *p2)
+{
+    const ddsbench_cpu *c1 = p1, *c2 = p2;
+    if (c1->node != c2->node) return c1->node - c2->node;
+    if (c1->package != c2->package) return c1->package - c2->package;
+    if (c1->core != c2->core) return c1->core - c2->core;
+    return c1->cpu - c2->cpu;
+}
+
+static int compareScatter(const void *p1, const void *p2)
+{
+    const ddsbench_cpu *c1 = p1, *c2 = p2;
+    if (c1->sibling != c2->sibling) return c1->sibling - c2->sibling;
+    if (c1->coreRank != c2->coreRank) return c1->coreRank - c2->coreRank;
+    if (c1->node != c2->node) return c1->node - c2->node;
+    return c1->cpu - c2->cpu;
+}
+
+/* Read the topology of the cpus this process may run on */
+static int readTopology(void)
+{
+    cpu_set_t available;
+    int i, j, cpu;
+
+    if (sched_getaffinity(0, sizeof(available), &available)) throw("failed to get process affinity\n");
+    if (!(cpus = calloc(CPU_COUNT(&available), sizeof(ddsbench_cpu)))) throw("out of memory\n");
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &available)) {
+            ddsbench_cpu *c = &cpus[numCpus++];
+            c->cpu = cpu;
+            c->node = readNode(cpu);
+            c->package = readInt("/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+            c->core = readInt("/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        }
+    }
+
+    /* Cpus are ordered compactly, which makes the ranks easy to derive */
+    qsort(cpus, numCpus, sizeof(ddsbench_cpu), compareCompact);
+    for (i = 0; i < numCpus; i++) {
+        ddsbench_cpu *c = &cpus[i], *prev = i ? &cpus[i - 1] : NULL;
+        if (!prev || prev->node != c->node) {
+            nodes[numNodes++] = c->node;
+            c->coreRank = 0;
+        } else if (prev->package != c->package || prev->core != c->core) {
+            c->coreRank = prev->coreRank + 1;
+        } else {
+            c->coreRank = prev->coreRank;
+        }
+        for (j = i - 1; j >= 0 && cpus[j].node == c->node && cpus[j].package == c->package && cpus[j].core == c->core; j--) {
+            c->sibling++;
+        }
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+int ddsbench_affinityInit(const char *option)
+{
+    int list[DDSBENCH_MAX_SWEEP], count, i, j;
+
+    if (!option) {
+        return 0;
+    }
+
+    if (readTopology()) goto error;
+
+    if (!strcmp(option, "compact")) {
+        policy = AFFINITY_COMPACT;
+    } else if (!strcmp(option, "scatter")) {
+        policy = AFFINITY_SCATTER;
+        qsort(cpus, numCpus, sizeof(ddsbench_cpu), compareScatter);
+    } else if (!strcmp(option, "numa")) {
+        policy = AFFINITY_NUMA;
+    } else {
+        /* Replace the available cpus with the listed ones, in list order */
+        ddsbench_cpu *listed;
+        if ((count = ddsbench_parseList(option, list, DDSBENCH_MAX_SWEEP)) <= 0) throw("invalid value for --cpus: %s\n", option);
+        if (!(listed = calloc(count, sizeof(ddsbench_cpu)))) throw("out of memory\n");
+        for (i = 0; i < count; i++) {
+            for (j = 0; j < numCpus && cpus[j].cpu != list[i]; j++);
+            if (j == numCpus) {
+                free(listed);
+                throw("cpu %d is not available to this process\n", list[i]);
+            }
+            listed[i] = cpus[j];
+        }
+        free(cpus);
+        cpus = listed;
+        numCpus = count;
+        policy = AFFINITY_LIST;
+    }
+
+    printf("ddsbench: %d cpus on %d numa nodes available for pinning\n", numCpus, numNodes);
+
+    return 0;
+error:
+    return -1;
+}
+
+void ddsbench_affinityFini(void)
+{
+    free(cpus);
+    cpus = NULL;
+    numCpus = numNodes = 0;
+    policy = AFFINITY_NONE;
+}
+
+int ddsbench_affinityApply(pthread_attr_t *attr, int thread, int topic, const char *name, int *cpu, int *node)
+{
+    cpu_set_t set;
+    char placement[256];
+    int i;
+
+    *cpu = -1;
+    *node = -1;
+    if (policy == AFFINITY_NONE) {
+        return 0;
+    }
+
+    CPU_ZERO(&set);
+    if (policy == AFFINITY_NUMA) {
+        char *ptr = placement;
+        *node = nodes[topic % numNodes];
+        ptr += sprintf(ptr, "node %d (cpus", *node);
+        for (i = 0; i < numCpus; i++) {
+            if (cpus[i].node == *node) {
+                CPU_SET(cpus[i].cpu, &set);
+                if (ptr - placement < (int)sizeof(placement) - 16) {
+                    ptr += sprintf(ptr, " %d", cpus[i].cpu);
+                }
+            }
+        }
+        sprintf(ptr, ")");
+    } else {
+        ddsbench_cpu *c = &cpus[thread % numCpus];
+        CPU_SET(c->cpu, &set);
+        sprintf(placement, "cpu %d (node %d, package %d, core %d)", c->cpu, c->node, c->package, c->core);
+        *cpu = c->cpu;
+        *node = c->node;
+    }
+
+    if (pthread_attr_setaffinity_np(attr, sizeof(set), &set)) {
+        printf("error: failed to set affinity of %s to %s\n", name, placement);
+        return -1;
+    }
+
+    printf("ddsbench: %s on %s\n", name, placement);
+
+    return 0;
+}
@@ -0,0 +1,300 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "core.h"
+
+int ddsbench_allocs = 0;
+
+/* The allocator of glibc, that the functions below forward to */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+/* A benchmark thread that is registered for interval reports */
+typedef struct allocThread {
+    ddsbench_threadArg *arg;
+    unsigned long long prevAllocs;
+    unsigned long long prevSamples;
+    struct allocThread *next;
+} allocThread;
+
+static pthread_mutex_t allocLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t allocCond = PTHREAD_COND_INITIALIZER;
+static allocThread *threads = NULL;
+static int reporting = 0;
+static pthread_t reporter;
+
+/* Allocations of other threads are counted from the first thread that
+ * crosses the start barrier until the first thread that finishes */
+static volatile int window = 0;
+static ddsbench_allocStats middleware;
+
+static __thread ddsbench_allocStats *threadStats = NULL;   /* Set once the thread crossed the barrier */
+static __thread allocThread *threadEntry = NULL;
+static __thread int ignore = 0;                            /* Thread of ddsbench that is never counted */
+
+static int bucket(size_t size)
+{
+    int b = size <= 1 ? 0 : 64 - __builtin_clzll(size - 1);
+    return b < DDSBENCH_ALLOC_BUCKETS ? b : DDSBENCH_ALLOC_BUCKETS - 1;
+}
+
+static void countAlloc(size_t size)
+{
+    ddsbench_allocStats *stats = threadStats;
+
+    if (stats) {
+        stats->allocs++;
+        stats->bytes += size;
+        stats->sizes[bucket(size)]++;
+    } else if (window && !threadEntry && !ignore) {
+        __sync_fetch_and_add(&middleware.allocs, 1);
+        __sync_fetch_and_add(&middleware.bytes, size);
+        __sync_fetch_and_add(&middleware.sizes[bucket(size)], 1);
+    }
+}
+
+static void countFree(void)
+{
+    if (threadStats) {
+        threadStats->frees++;
+    } else if (window && !threadEntry && !ignore) {
+        __sync_fetch_and_add(&middleware.frees, 1);
+    }
+}
+
+/* Defined by the executable, so they take the place of the functions of libc
+ * for every library that is loaded, the benchmark libraries included */
+void *malloc(size_t size)
+{
+    if (__builtin_expect(ddsbench_allocs, 0)) {
+        countAlloc(size);
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    if (__builtin_expect(ddsbench_allocs, 0)) {
+        countAlloc(count * size);
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (__builtin_expect(ddsbench_allocs, 0)) {
+        if (size) {
+            countAlloc(size);
+        }
+        if (ptr && !size) {
+            countFree();
+        }
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    if (__builtin_expect(ddsbench_allocs, 0) && ptr) {
+        countFree();
+    }
+    __libc_free(ptr);
+}
+
+void ddsbench_allocIgnore(void)
+{
+    ignore = 1;
+}
+
+void ddsbench_allocOpen(ddsbench_threadArg *arg)
+{
+    allocThread *entry;
+
+    if (!ddsbench_allocs || !(entry = calloc(1, sizeof(allocThread)))) {
+        return;
+    }
+    entry->arg = arg;
+    threadEntry = entry;
+    pthread_mutex_lock(&allocLock);
+    entry->next = threads;
+    threads = entry;
+    pthread_mutex_unlock(&allocLock);
+}
+
+void ddsbench_allocEnable(void)
+{
+    if (threadEntry) {
+        memset(&threadEntry->arg->result.allocs, 0, sizeof(ddsbench_allocStats));
+        threadStats = &threadEntry->arg->result.allocs;
+        window = 1;
+    }
+}
+
+void ddsbench_allocClose(ddsbench_threadArg *arg)
+{
+    allocThread *entry = threadEntry, **ptr;
+
+    (void)arg;
+    if (!entry) {
+        return;
+    }
+    threadStats = NULL;
+    window = 0;
+
+    /* Unregister before the arg goes away, the reporter reads it */
+    pthread_mutex_lock(&allocLock);
+    for (ptr = &threads; *ptr != entry; ptr = &(*ptr)->next);
+    *ptr = entry->next;
+    pthread_mutex_unlock(&allocLock);
+    threadEntry = NULL;
+    free(entry);
+}
+
+static void* reportMain(void *ptr)
+{
+    struct timespec deadline;
+    unsigned long long prevMiddleware = 0;
+    allocThread *entry;
+
+    (void)ptr;
+    ignore = 1;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    pthread_mutex_lock(&allocLock);
+    while (reporting) {
+        unsigned long long allocs[2] = {0, 0}, samples[2] = {0, 0}, current;
+        deadline.tv_sec++;
+        if (!pthread_cond_timedwait(&allocCond, &allocLock, &deadline) || !reporting) {
+            continue;
+        }
+
+        /* Counters are read while threads update them, which is good enough for an interval */
+        for (entry = threads; entry; entry = entry->next) {
+            ddsbench_role role = entry->arg->role;
+            current = entry->arg->result.allocs.allocs;
+            allocs[role] += current - entry->prevAllocs;
+            entry->prevAllocs = current;
+            current = entry->arg->result.samples;
+            samples[role] += current - entry->prevSamples;
+            entry->prevSamples = current;
+        }
+        if (!samples[DDSBENCH_PUBLISHER] && !samples[DDSBENCH_SUBSCRIBER]) {
+            continue;
+        }
+        current = middleware.allocs;
+        printf("allocs: pub %llu (%.2f/sample), sub %llu (%.2f/sample), middleware %llu\n",
+            allocs[DDSBENCH_PUBLISHER],
+            samples[DDSBENCH_PUBLISHER] ? (double)allocs[DDSBENCH_PUBLISHER] / samples[DDSBENCH_PUBLISHER] : 0,
+            allocs[DDSBENCH_SUBSCRIBER],
+            samples[DDSBENCH_SUBSCRIBER] ? (double)allocs[DDSBENCH_SUBSCRIBER] / samples[DDSBENCH_SUBSCRIBER] : 0,
+            current - prevMiddleware);
+        prevMiddleware = current;
+    }
+    pthread_mutex_unlock(&allocLock);
+    return NULL;
+}
+
+void ddsbench_allocReportStart(void)
+{
+    if (!ddsbench_allocs) {
+        return;
+    }
+    memset(&middleware, 0, sizeof(middleware));
+    reporting = 1;
+    if (pthread_create(&reporter, NULL, reportMain, NULL)) {
+        printf("allocs: failed to start interval reporter: %s\n", strerror(errno));
+        reporting = 0;
+    }
+}
+
+void ddsbench_allocReportStop(void)
+{
+    pthread_mutex_lock(&allocLock);
+    window = 0;
+    if (!reporting) {
+        pthread_mutex_unlock(&allocLock);
+        return;
+    }
+    reporting = 0;
+    pthread_cond_broadcast(&allocCond);
+    pthread_mutex_unlock(&allocLock);
+    pthread_join(reporter, NULL);
+}
+
+static void printRow(const char *name, const ddsbench_allocStats *stats, unsigned long long samples)
+{
+    printf("ddsbench: %-10s %11llu %11llu %11llu %10.2f %12.3f %12.1f\n",
+        name, samples, stats->allocs, stats->frees, stats->bytes / 1048576.0,
+        samples ? (double)stats->allocs / samples : 0,
+        samples ? (double)stats->bytes / samples : 0);
+}
+
+static void printSize(int b)
+{
+    char size[16];
+
+    if (b == DDSBENCH_ALLOC_BUCKETS - 1) {
+        sprintf(size, "> %lluK", (1ULL << (b - 1)) / 1024);
+    } else if (b > 10) {
+        sprintf(size, "<= %lluK", (1ULL << b) / 1024);
+    } else {
+        sprintf(size, "<= %llu", 1ULL << b);
+    }
+    printf("ddsbench: %-10s", size);
+}
+
+void ddsbench_printAllocs(ddsbench_threadArg *args, int count)
+{
+    ddsbench_allocStats roles[2];
+    unsigned long long samples[2] = {0, 0}, delivered;
+    int i, b;
+
+    if (!ddsbench_allocs) {
+        return;
+    }
+    memset(roles, 0, sizeof(roles));
+
+    printf("\n");
+    printf("Allocations (from the start barrier, middleware until the first thread finished)\n");
+    printf("ddsbench: %-10s %11s %11s %11s %10s %12s %12s\n",
+        "thread", "samples", "allocs", "frees", "MB", "allocs/sample", "bytes/sample");
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        ddsbench_role role = args[i].role;
+        char thread[16];
+        sprintf(thread, "%s %d", role == DDSBENCH_PUBLISHER ? "pub" : "sub", args[i].id);
+        printRow(thread, &r->allocs, r->samples);
+        samples[role] += r->samples;
+        roles[role].allocs += r->allocs.allocs;
+        roles[role].frees += r->allocs.frees;
+        roles[role].bytes += r->allocs.bytes;
+        for (b = 0; b < DDSBENCH_ALLOC_BUCKETS; b++) {
+            roles[role].sizes[b] += r->allocs.sizes[b];
+        }
+    }
+
+    /* Like CPU cost, middleware allocations are per sample received, or written if nothing is received here */
+    delivered = samples[DDSBENCH_SUBSCRIBER] ? samples[DDSBENCH_SUBSCRIBER] : samples[DDSBENCH_PUBLISHER];
+    printRow("middleware", &middleware, delivered);
+
+    printf("\n");
+    printf("Allocation sizes\n");
+    printf("ddsbench: %-10s %11s %11s %11s\n", "bytes", "writers", "readers", "middleware");
+    for (b = 0; b < DDSBENCH_ALLOC_BUCKETS; b++) {
+        if (!roles[DDSBENCH_PUBLISHER].sizes[b] && !roles[DDSBENCH_SUBSCRIBER].sizes[b] && !middleware.sizes[b]) {
+            continue;
+        }
+        printSize(b);
+        printf(" %11llu %11llu %11llu\n",
+            roles[DDSBENCH_PUBLISHER].sizes[b], roles[DDSBENCH_SUBSCRIBER].sizes[b], middleware.sizes[b]);
+    }
+    if (!roles[DDSBENCH_PUBLISHER].allocs && !roles[DDSBENCH_SUBSCRIBER].allocs && !middleware.allocs) {
+        printf("ddsbench: no allocations\n");
+    }
+}
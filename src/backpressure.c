@@ -0,0 +1,100 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+
+/* Aggregated results of a single back-pressure trial */
+typedef struct ddsbench_backpressureTrial {
+    int maxsamples;
+    unsigned long long written;
+    unsigned long long received;
+    unsigned long long blocked;
+    unsigned long long timeouts;
+    ddsbench_histogram writeNs;
+} ddsbench_backpressureTrial;
+
+static void collectTrial(ddsbench_sweep *sweep, ddsbench_threadArg *args, int count, void *trial)
+{
+    ddsbench_backpressureTrial *t = trial;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        if (args[i].role == DDSBENCH_PUBLISHER) {
+            t->written += r->samples;
+            t->blocked += r->blocked;
+            t->timeouts += r->timeouts;
+            ddsbench_histogramMerge(&t->writeNs, &r->writeNs);
+        } else {
+            t->received += r->samples;
+        }
+    }
+}
+
+static double toUs(unsigned long long ns)
+{
+    return (double)ns / 1000.0;
+}
+
+static void printTrial(ddsbench_sweep *sweep, void *trial)
+{
+    ddsbench_backpressureTrial *t = trial;
+    unsigned int duration = sweep->ctx->duration;
+    char maxsamples[16];
+    ddsbench_histogram *h = &t->writeNs;
+
+    if (t->maxsamples < 0) strcpy(maxsamples, "unlimited"); else sprintf(maxsamples, "%d", t->maxsamples);
+
+    printf("backpressure: %10s %11llu %11.0f %9llu %8llu %8.1f %8.1f %8.1f %8.1f %10.1f\n",
+        maxsamples, t->written, duration ? (double)t->written / duration : 0,
+        t->blocked, t->timeouts,
+        h->count ? toUs(h->totalNs / h->count) : 0,
+        toUs(ddsbench_histogramQuantile(h, 0.5)),
+        toUs(ddsbench_histogramQuantile(h, 0.99)),
+        toUs(ddsbench_histogramQuantile(h, 0.999)),
+        toUs(h->maxNs));
+}
+
+static void printHeader(ddsbench_sweep *sweep)
+{
+    printf("\n");
+    printf("Writer blocking time (us per write call, blocked when > %llu us)\n", DDSBENCH_BLOCKED_NS / 1000);
+    printf("backpressure: %10s %11s %11s %9s %8s %8s %8s %8s %8s %10s\n",
+        "maxsamples", "written", "samples/s", "blocked", "timeouts", "avg", "p50", "p99", "p99.9", "max");
+}
+
+static const ddsbench_sweepMode backpressureSweep = {
+    sizeof(ddsbench_backpressureTrial), NULL, NULL, collectTrial, printHeader, printTrial
+};
+
+int ddsbench_runBackpressure(ddsbench_libraryInterface *interface, ddsbench_context *ctx)
+{
+    int maxsamples[DDSBENCH_MAX_SWEEP];
+    int numMaxsamples, m;
+    int maxsamplesDefault = ctx->maxsamples;
+    ddsbench_sweep sweep = {0};
+
+    if ((numMaxsamples = ddsbench_parseList(ddsbench_maxsamples, maxsamples, DDSBENCH_MAX_SWEEP)) < 0) goto error;
+    if (ddsbench_sweepInit(&sweep, &backpressureSweep, interface, ctx, numMaxsamples)) goto error;
+
+    for (m = 0; m < numMaxsamples; m++) {
+        ddsbench_backpressureTrial *t = ddsbench_sweepTrial(&sweep, m);
+        ctx->maxsamples = maxsamples[m];
+        t->maxsamples = maxsamples[m];
+        if (ddsbench_sweepRun(&sweep)) goto error;
+    }
+
+    if (ddsbench_numpub) {
+        ddsbench_sweepPrint(&sweep);
+    }
+
+    ctx->maxsamples = maxsamplesDefault;
+    ddsbench_sweepFini(&sweep);
+    return 0;
+error:
+    ctx->maxsamples = maxsamplesDefault;
+    ddsbench_sweepFini(&sweep);
+    return -1;
+}
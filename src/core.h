@@ -0,0 +1,258 @@
+
+#ifndef CORE_H
+#define CORE_H
+
+#include <pthread.h>
+#include <ddsbench.h>
+
+#ifdef __cplusplus
+extern "c" {
+#endif
+
+#define DDSBENCH_MAX_SWEEP 64
+
+/* Maximum number of processes ddsbench launch starts */
+#define DDSBENCH_MAX_PROCS 256
+
+/** ddsbench configuration options, see main.c */
+extern char *ddsbench_mode;
+extern char *ddsbench_lib;
+extern unsigned int ddsbench_numsub;
+extern unsigned int ddsbench_numpub;
+extern unsigned int ddsbench_numtopic;
+extern char ddsbench_topicname[256];
+extern char *ddsbench_selectivity;
+extern char *ddsbench_complexity;
+extern char *ddsbench_history;
+extern char *ddsbench_payloads;
+extern char *ddsbench_maxsamples;
+extern int ddsbench_fragmentsize;
+extern char *ddsbench_cpus;
+extern int ddsbench_rt;
+extern int ddsbench_workers;
+extern int ddsbench_launch;
+extern int ddsbench_pubprocs;
+extern int ddsbench_subprocs;
+extern char *ddsbench_proccpus;
+extern int ddsbench_compare;
+extern int ddsbench_tune;
+extern int ddsbench_rounds;
+extern int ddsbench_repeats;
+#define DDSBENCH_TUNE_MAX_REPEATS 15
+extern int ddsbench_perf;
+extern int ddsbench_allocs;
+extern char *ddsbench_libpath;
+extern char *ddsbench_publib;
+extern char *ddsbench_sublib;
+
+/* Find a plugin by name on the search path (--libpath, DDSBENCH_PLUGIN_PATH,
+ * the working directory, the directory of ddsbench and its ../lib/ddsbench)
+ * and resolve its descriptor. Check verifies that the plugin supports the
+ * options of the run, before its init is called. Open does all three and
+ * prints the plugin. */
+int ddsbench_pluginLoad(const char *name, ddsbench_libraryInterface *interface);
+int ddsbench_pluginCheck(ddsbench_libraryInterface *interface, ddsbench_context *ctx);
+int ddsbench_pluginOpen(const char *name, ddsbench_context *ctx, ddsbench_libraryInterface *interface);
+void ddsbench_pluginClose(ddsbench_libraryInterface *interface);
+
+/* Print every plugin on the search path with its capabilities (ddsbench plugins) */
+int ddsbench_pluginList(void);
+
+/* Comma separated names of the capabilities in a ddsbench_capability mask */
+void ddsbench_pluginCapabilities(unsigned int capabilities, char *buf, size_t size);
+
+/* Latency, throughput, durability and worker pool threads of plugins with
+ * ddsbench_ops, which they run on arg->plugin->ops */
+int ddsbench_engineLpub(ddsbench_threadArg *arg);
+int ddsbench_engineLsub(ddsbench_threadArg *arg);
+int ddsbench_engineTpub(ddsbench_threadArg *arg);
+int ddsbench_engineTsub(ddsbench_threadArg *arg);
+int ddsbench_engineDpub(ddsbench_threadArg *arg);
+int ddsbench_engineDsub(ddsbench_threadArg *arg);
+int ddsbench_engineTworker(ddsbench_worker *worker);
+
+/* Start threads for all topics on topicname, wait for them to finish and
+ * return their arguments (with results). Publishers run on pubInterface and
+ * subscribers on subInterface, which is the same plugin unless --pub-lib and
+ * --sub-lib differ. Returns NULL on error. */
+ddsbench_threadArg* ddsbench_runThreads(
+    ddsbench_libraryInterface *pubInterface,
+    ddsbench_libraryInterface *subInterface,
+    ddsbench_context *ctx,
+    const char *topicname,
+    int *count);
+
+/* Print what --perf, --allocs and --verify measured in the threads of a run,
+ * after its results. Sweeps call it for every trial. */
+void ddsbench_printReports(ddsbench_context *ctx, ddsbench_threadArg *args, int count);
+
+/* A sweep runs a trial of threads for every point of the parameter loop of
+ * a mode, each on topics of its own. The mode describes its trials: start
+ * and stop (optional) prepare the context for the threads of a trial and
+ * release it after, collect adds the results of the threads to the trial.
+ * Run runs the next trial, prints the reports of its threads and then the
+ * trial, Print prints the table of all trials at the end. */
+typedef struct ddsbench_sweep ddsbench_sweep;
+
+typedef struct ddsbench_sweepMode {
+    size_t trialSize;
+    int (*start)(ddsbench_sweep *sweep, const char *topicname, void *trial);
+    void (*stop)(ddsbench_sweep *sweep, void *trial);
+    void (*collect)(ddsbench_sweep *sweep, ddsbench_threadArg *args, int count, void *trial);
+    void (*printHeader)(ddsbench_sweep *sweep);
+    void (*printTrial)(ddsbench_sweep *sweep, void *trial);
+} ddsbench_sweepMode;
+
+struct ddsbench_sweep {
+    const ddsbench_sweepMode *mode;
+    ddsbench_libraryInterface *interface;
+    ddsbench_context *ctx;
+    char *trials;
+    int count;                      /* Trials run, the next one is trials[count] */
+};
+
+int ddsbench_sweepInit(
+    ddsbench_sweep *sweep,
+    const ddsbench_sweepMode *mode,
+    ddsbench_libraryInterface *interface,
+    ddsbench_context *ctx,
+    int max);
+void ddsbench_sweepFini(ddsbench_sweep *sweep);
+void* ddsbench_sweepTrial(ddsbench_sweep *sweep, int index);
+int ddsbench_sweepRun(ddsbench_sweep *sweep);
+void ddsbench_sweepPrint(ddsbench_sweep *sweep);
+
+/* Pin threads according to --cpus (a list of cpus, compact, scatter or numa).
+ * Apply sets the affinity for a thread in attr and records it in arg. */
+int ddsbench_affinityInit(const char *option);
+void ddsbench_affinityFini(void);
+int ddsbench_affinityApply(pthread_attr_t *attr, int thread, int topic, const char *name, int *cpu, int *node);
+
+/* Real-time profile (--rt): mlockall and SCHED_FIFO for the calling process
+ * and threads. Thread start/stop also report page faults taken in between. */
+int ddsbench_rtInit(void);
+void ddsbench_rtThreadStart(ddsbench_threadArg *arg, long *faults);
+void ddsbench_rtThreadStop(ddsbench_threadArg *arg, long faults);
+
+/* Sample the CPU time, kernel time and context switches of the calling
+ * thread into the result of arg. Stop leaves the difference with start. */
+void ddsbench_usageStart(ddsbench_threadArg *arg);
+void ddsbench_usageStop(ddsbench_threadArg *arg);
+
+/* CPU time of every thread of the process, from /proc/self/task */
+typedef struct ddsbench_task {
+    int tid;
+    char name[16];
+    unsigned long long cpuNs;
+} ddsbench_task;
+
+typedef struct ddsbench_tasks {
+    ddsbench_task *tasks;
+    int count;
+    int size;
+} ddsbench_tasks;
+
+int ddsbench_tasksSample(ddsbench_tasks *tasks);
+void ddsbench_tasksFree(ddsbench_tasks *tasks);
+
+/* Report CPU per sample and per MB of the writers, readers and the middleware
+ * threads (all other threads, sampled before and after the run) */
+void ddsbench_printCost(
+    ddsbench_threadArg *args,
+    int count,
+    const ddsbench_tasks *before,
+    const ddsbench_tasks *after,
+    unsigned long long processNs);
+
+/* Hardware counters (--perf): a group per benchmark thread that is opened
+ * when the thread starts, enabled at the start barrier and read when the
+ * thread finishes. While threads run, the counters of each role are reported
+ * every second. Init switches --perf off when no counter can be opened. */
+int ddsbench_perfInit(void);
+void ddsbench_perfOpen(ddsbench_threadArg *arg);
+void ddsbench_perfEnable(void);
+void ddsbench_perfClose(ddsbench_threadArg *arg);
+void ddsbench_perfReportStart(void);
+void ddsbench_perfReportStop(void);
+void ddsbench_printPerf(ddsbench_threadArg *args, int count);
+
+/* Allocation counting (--allocs): ddsbench defines malloc, calloc, realloc
+ * and free itself, so the calls of the benchmark libraries and middleware
+ * are counted without preloading anything. A benchmark thread counts its
+ * own calls from the start barrier until it finishes, other threads are
+ * counted together while the benchmark threads run. Threads of ddsbench
+ * that are not benchmark threads call ddsbench_allocIgnore. */
+void ddsbench_allocIgnore(void);
+void ddsbench_allocOpen(ddsbench_threadArg *arg);
+void ddsbench_allocEnable(void);
+void ddsbench_allocClose(ddsbench_threadArg *arg);
+void ddsbench_allocReportStart(void);
+void ddsbench_allocReportStop(void);
+void ddsbench_printAllocs(ddsbench_threadArg *args, int count);
+
+/* Report corrupt payloads and the cost of verifying them, see --verify */
+void ddsbench_printVerify(ddsbench_threadArg *args, int count);
+
+/* Parse a comma separated list of numbers, returns number of elements or -1 */
+int ddsbench_parseList(const char *list, int *values, int max);
+
+/* Create a latch that opens after count arrivals */
+ddsbench_latch* ddsbench_latchNew(int count);
+void ddsbench_latchFree(ddsbench_latch *latch);
+
+/* Create a start barrier for count threads */
+ddsbench_barrier* ddsbench_barrierNew(int count);
+void ddsbench_barrierFree(ddsbench_barrier *barrier);
+
+/* Benchmark modes that run a sweep of trials */
+int ddsbench_runFilter(ddsbench_libraryInterface *interface, ddsbench_context *ctx);
+int ddsbench_runDurability(ddsbench_libraryInterface *interface, ddsbench_context *ctx);
+int ddsbench_runBackpressure(ddsbench_libraryInterface *interface, ddsbench_context *ctx);
+int ddsbench_runLarge(ddsbench_libraryInterface *interface, ddsbench_context *ctx);
+
+/* Latency or throughput of every pair of --pub-lib and --sub-lib plugins,
+ * which it loads itself */
+int ddsbench_runCross(ddsbench_context *ctx);
+
+/* Run endpoints on a pool of --workers threads instead of a thread each */
+int ddsbench_runPool(ddsbench_libraryInterface *interface, ddsbench_context *ctx, ddsbench_threadArg *args, int count);
+
+/* Fork processes for the publishers and subscribers of a run (ddsbench
+ * launch) and report their results together. argv are the options of the
+ * launcher, which are passed on except for the ones set per process. */
+int ddsbench_runLaunch(ddsbench_context *ctx, int argc, char *argv[]);
+
+/* Run the publishers and subscribers in processes of their own, like
+ * ddsbench launch, with env ("NAME=value" strings, NULL terminated) added to
+ * their environment. Returns -1 when the run failed. Interrupted is nonzero
+ * once the launcher was interrupted. */
+typedef struct ddsbench_launchResult {
+    double rate;                    /* Samples received per second, summed over the subscribers */
+    double mbits;                   /* Mbit received per second, summed over the subscribers */
+    unsigned long long received;    /* Samples received, for runs too short to report a rate */
+    ddsbench_histogram roundTripNs; /* Round trips of ping */
+} ddsbench_launchResult;
+
+int ddsbench_launchTrial(ddsbench_context *ctx, int argc, char *argv[], char **env, ddsbench_launchResult *result);
+int ddsbench_launchInterrupted(void);
+
+/* Search the DDSI2 settings of the ospl plugin for the best latency or
+ * throughput of the workload (ddsbench tune), with a trial like ddsbench
+ * launch for every configuration */
+int ddsbench_runTune(ddsbench_context *ctx, int argc, char *argv[]);
+
+/* A process started by the launcher streams its progress every second and
+ * the results of its threads when done. Child returns nonzero when this
+ * process was launched, the other calls do nothing when it was not. Threads
+ * that run on a copy of their arg move their live slot to it and back. */
+int ddsbench_launchChild(void);
+void ddsbench_launchReportStart(ddsbench_threadArg **live, int count);
+void ddsbench_launchReportStop(void);
+void ddsbench_launchMove(ddsbench_threadArg **slot, ddsbench_threadArg *arg);
+void ddsbench_launchResults(ddsbench_threadArg *args, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,225 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+/* Plugins a list of --pub-lib or --sub-lib holds at most */
+#define DDSBENCH_MAX_CROSS 16
+
+typedef enum ddsbench_crossStatus {
+    DDSBENCH_CROSS_PENDING,         /* Not run, the sweep was interrupted */
+    DDSBENCH_CROSS_MEASURED,
+    DDSBENCH_CROSS_FAILED,          /* A plugin did not load or a thread failed */
+    DDSBENCH_CROSS_SKIPPED          /* The plugins do not interoperate */
+} ddsbench_crossStatus;
+
+/* Values a matrix reports of every pair */
+typedef enum ddsbench_crossMetric {
+    DDSBENCH_CROSS_P50,
+    DDSBENCH_CROSS_P99,
+    DDSBENCH_CROSS_RATE,
+    DDSBENCH_CROSS_MBITS
+} ddsbench_crossMetric;
+
+/* Aggregated results of the trial of one publisher and subscriber plugin */
+typedef struct ddsbench_crossCell {
+    ddsbench_crossStatus status;
+    unsigned long long written;
+    unsigned long long received;
+    unsigned long long bytes;
+    ddsbench_histogram roundTripNs;
+} ddsbench_crossCell;
+
+/* Split a comma separated list of plugins in buf, returns the number of
+ * names or -1 */
+static int parseNames(const char *list, char *buf, size_t size, char **names)
+{
+    char *name, *save = NULL;
+    int count = 0;
+
+    if (strlen(list) >= size) {
+        throw("list of plugins too long: %s\n", list);
+    }
+    strcpy(buf, list);
+    for (name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        if (count == DDSBENCH_MAX_CROSS) {
+            throw("more than %d plugins in %s\n", DDSBENCH_MAX_CROSS, list);
+        }
+        names[count++] = name;
+    }
+    if (!count) {
+        throw("no plugins in %s\n", list);
+    }
+    return count;
+error:
+    return -1;
+}
+
+/* Run the trial of a pair in cell. Plugins of different products only meet
+ * over DDSI, a pair of which one does not speak it is skipped. Returns
+ * nonzero when the trial was interrupted. */
+static int runCell(
+    ddsbench_context *ctx,
+    const char *pubName,
+    const char *subName,
+    int index,
+    ddsbench_crossCell *cell)
+{
+    ddsbench_libraryInterface pubInterface, subInterface;
+    ddsbench_libraryInterface *sub = &pubInterface;
+    ddsbench_threadArg *args;
+    char topicname[sizeof(ddsbench_topicname) + 16];
+    int i, count, interrupted = 0;
+
+    memset(&subInterface, 0, sizeof(subInterface));
+    cell->status = DDSBENCH_CROSS_FAILED;
+
+    printf("\nddsbench: publishers on %s, subscribers on %s\n", pubName, subName);
+    if (ddsbench_pluginOpen(pubName, ctx, &pubInterface)) {
+        goto done;
+    }
+    if (strcmp(pubName, subName)) {
+        if (ddsbench_pluginOpen(subName, ctx, &subInterface)) {
+            goto done;
+        }
+        sub = &subInterface;
+        if (!(pubInterface.plugin->capabilities & sub->plugin->capabilities & DDSBENCH_CAP_DDSI)) {
+            printf("ddsbench: %s and %s do not interoperate, skipped\n", pubName, subName);
+            cell->status = DDSBENCH_CROSS_SKIPPED;
+            goto done;
+        }
+    }
+
+    snprintf(topicname, sizeof(topicname), "%s_%d", ddsbench_topicname, index);
+    if (!(args = ddsbench_runThreads(&pubInterface, sub, ctx, topicname, &count))) {
+        goto done;
+    }
+    cell->status = DDSBENCH_CROSS_MEASURED;
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        if (args[i].role == DDSBENCH_PUBLISHER) {
+            cell->written += r->samples;
+        } else {
+            cell->received += r->samples;
+            cell->bytes += r->bytes;
+            ddsbench_histogramMerge(&cell->roundTripNs, &r->roundTripNs);
+        }
+        if (args[i].status) {
+            cell->status = DDSBENCH_CROSS_FAILED;
+        }
+    }
+    ddsbench_printReports(ctx, args, count);
+    ddsbench_launchResults(args, count);
+    free(args);
+
+    /* The plugin initialized last handles the interrupt */
+    interrupted = sub->plugin->ops && sub->plugin->ops->terminated();
+
+done:
+    ddsbench_pluginClose(&subInterface);
+    ddsbench_pluginClose(&pubInterface);
+    return interrupted;
+}
+
+static void printMatrix(
+    const char *title,
+    ddsbench_crossMetric metric,
+    char **pubs,
+    int numPub,
+    char **subs,
+    int numSub,
+    const ddsbench_crossCell *cells,
+    unsigned int duration)
+{
+    int p, s;
+
+    printf("\n%s\n", title);
+    printf("cross: %-12s", "pub \\ sub");
+    for (s = 0; s < numSub; s++) {
+        printf(" %12.12s", subs[s]);
+    }
+    printf("\n");
+
+    for (p = 0; p < numPub; p++) {
+        printf("cross: %-12.12s", pubs[p]);
+        for (s = 0; s < numSub; s++) {
+            const ddsbench_crossCell *cell = &cells[p * numSub + s];
+            const ddsbench_histogram *h = &cell->roundTripNs;
+
+            if (cell->status == DDSBENCH_CROSS_PENDING) {
+                printf(" %12s", "-");
+            } else if (cell->status == DDSBENCH_CROSS_SKIPPED) {
+                printf(" %12s", "n/a");
+            } else if (cell->status == DDSBENCH_CROSS_FAILED) {
+                printf(" %12s", "failed");
+            } else if (metric == DDSBENCH_CROSS_P50 || metric == DDSBENCH_CROSS_P99) {
+                if (h->count) {
+                    printf(" %12.2f", ddsbench_histogramQuantile(h, metric == DDSBENCH_CROSS_P50 ? 0.5 : 0.99) / 1000.0);
+                } else {
+                    printf(" %12s", "none");
+                }
+            } else if (metric == DDSBENCH_CROSS_RATE) {
+                printf(" %12.2f", (double)cell->received / duration / 1000.0);
+            } else {
+                printf(" %12.2f", cell->bytes * 8.0 / duration / 1000000.0);
+            }
+        }
+        printf("\n");
+    }
+}
+
+int ddsbench_runCross(ddsbench_context *ctx)
+{
+    char pubList[1024], subList[1024];
+    char *pubs[DDSBENCH_MAX_CROSS], *subs[DDSBENCH_MAX_CROSS];
+    int numPub, numSub, p, s, measured = 0;
+    ddsbench_context base = *ctx;
+    ddsbench_crossCell *cells = NULL;
+
+    if ((numPub = parseNames(ddsbench_publib, pubList, sizeof(pubList), pubs)) < 0 ||
+        (numSub = parseNames(ddsbench_sublib, subList, sizeof(subList), subs)) < 0)
+    {
+        goto error;
+    }
+    if (!(cells = calloc(numPub * numSub, sizeof(ddsbench_crossCell)))) {
+        throw("out of memory\n");
+    }
+
+    /* Every pair starts from the options as given, whatever the plugins of
+     * the pair before changed in init */
+    for (p = 0; p < numPub; p++) {
+        for (s = 0; s < numSub; s++) {
+            *ctx = base;
+            measured++;
+            if (runCell(ctx, pubs[p], subs[s], p * numSub + s, &cells[p * numSub + s])) {
+                printf("ddsbench: interrupted, %d of %d pairs measured\n", measured, numPub * numSub);
+                goto report;
+            }
+        }
+    }
+
+report:
+    *ctx = base;
+    if (!strcmp(ddsbench_mode, "latency")) {
+        printMatrix("Cross-product latency, median round trip [us] (pong publishers per row, ping subscribers per column)",
+            DDSBENCH_CROSS_P50, pubs, numPub, subs, numSub, cells, ctx->duration);
+        printMatrix("Cross-product latency, 99th percentile round trip [us]",
+            DDSBENCH_CROSS_P99, pubs, numPub, subs, numSub, cells, ctx->duration);
+    } else {
+        printMatrix("Cross-product throughput, received [K samples/s] (publishers per row, subscribers per column)",
+            DDSBENCH_CROSS_RATE, pubs, numPub, subs, numSub, cells, ctx->duration);
+        printMatrix("Cross-product throughput, received [Mbit/s]",
+            DDSBENCH_CROSS_MBITS, pubs, numPub, subs, numSub, cells, ctx->duration);
+    }
+
+    free(cells);
+    return 0;
+error:
+    free(cells);
+    return -1;
+}
@@ -0,0 +1,138 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+
+/* Aggregated results of a single durability trial */
+typedef struct ddsbench_durabilityTrial {
+    int history;
+    int payload;
+    int readers;
+    int complete;
+    unsigned long long expected;
+    unsigned long long received;
+    unsigned long long bytes;
+    unsigned long long waitNs;  /* Slowest reader */
+    unsigned long long alignNs; /* Slowest reader */
+} ddsbench_durabilityTrial;
+
+static void stopTrial(ddsbench_sweep *sweep, void *trial)
+{
+    ddsbench_context *ctx = sweep->ctx;
+
+    ddsbench_latchFree(ctx->historyWritten);
+    ddsbench_latchFree(ctx->historyAligned);
+    ctx->historyWritten = NULL;
+    ctx->historyAligned = NULL;
+}
+
+/* Readers align after the writers wrote their history */
+static int startTrial(ddsbench_sweep *sweep, const char *topicname, void *trial)
+{
+    ddsbench_context *ctx = sweep->ctx;
+
+    ctx->historyWritten = ddsbench_latchNew(ddsbench_numpub * ddsbench_numtopic);
+    ctx->historyAligned = ddsbench_latchNew(ddsbench_numsub * ddsbench_numtopic);
+    if (!ctx->historyWritten || !ctx->historyAligned) {
+        printf("error: out of memory\n");
+        stopTrial(sweep, trial);
+        return -1;
+    }
+    return 0;
+}
+
+static void collectTrial(ddsbench_sweep *sweep, ddsbench_threadArg *args, int count, void *trial)
+{
+    ddsbench_durabilityTrial *t = trial;
+    int i;
+
+    t->complete = 1;
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        if (args[i].role == DDSBENCH_SUBSCRIBER) {
+            t->readers++;
+            t->received += r->samples;
+            t->bytes += r->bytes;
+            if (r->waitNs > t->waitNs) t->waitNs = r->waitNs;
+            if (r->alignNs > t->alignNs) t->alignNs = r->alignNs;
+            if (r->samples < sweep->ctx->expected) t->complete = 0;
+        }
+    }
+}
+
+static void printTrial(ddsbench_sweep *sweep, void *trial)
+{
+    ddsbench_durabilityTrial *t = trial;
+    double seconds = (double)t->alignNs / 1000000000.0;
+    double perReader = t->readers ? (double)t->received / t->readers : 0;
+    double bytesPerReader = t->readers ? (double)t->bytes / t->readers : 0;
+
+    printf("durability: %9d %8d %7d %11llu %10.2f %10.2f %12.0f %9.2f %s\n",
+        t->history, t->payload, t->readers,
+        t->readers ? t->received / t->readers : 0,
+        (double)t->waitNs / 1000000.0,
+        (double)t->alignNs / 1000000.0,
+        seconds > 0 ? perReader / seconds : 0,
+        seconds > 0 ? bytesPerReader / seconds / 1000000.0 : 0,
+        t->complete ? "" : "(incomplete)");
+}
+
+static void printHeader(ddsbench_sweep *sweep)
+{
+    printf("\n");
+    printf("Late joiner alignment (slowest reader)\n");
+    printf("durability: %9s %8s %7s %11s %10s %10s %12s %9s\n",
+        "history", "payload", "readers", "received", "wait[ms]", "align[ms]", "samples/s", "MB/s");
+}
+
+static const ddsbench_sweepMode durabilitySweep = {
+    sizeof(ddsbench_durabilityTrial), startTrial, stopTrial, collectTrial, printHeader, printTrial
+};
+
+int ddsbench_runDurability(ddsbench_libraryInterface *interface, ddsbench_context *ctx)
+{
+    int history[DDSBENCH_MAX_SWEEP], payload[DDSBENCH_MAX_SWEEP];
+    int numHistory, numPayload = 1, h, p;
+    unsigned int payloadDefault = ctx->payload;
+    ddsbench_sweep sweep = {0};
+
+    if ((numHistory = ddsbench_parseList(ddsbench_history, history, DDSBENCH_MAX_SWEEP)) < 0) goto error;
+    if (ddsbench_payloads) {
+        if ((numPayload = ddsbench_parseList(ddsbench_payloads, payload, DDSBENCH_MAX_SWEEP)) < 0) goto error;
+    } else {
+        payload[0] = ctx->payload;
+    }
+
+    if (ddsbench_sweepInit(&sweep, &durabilitySweep, interface, ctx, numHistory * numPayload)) goto error;
+
+    for (p = 0; p < numPayload; p++) {
+        for (h = 0; h < numHistory; h++) {
+            ddsbench_durabilityTrial *t = ddsbench_sweepTrial(&sweep, sweep.count);
+
+            /* Subscribers in a process without publishers assume a single
+             * publisher in another process */
+            ctx->payload = payload[p];
+            ctx->history = history[h];
+            ctx->expected = (unsigned long long)history[h] * (ddsbench_numpub ? ddsbench_numpub : 1);
+
+            t->history = history[h];
+            t->payload = payload[p];
+            t->expected = ctx->expected;
+            if (ddsbench_sweepRun(&sweep)) goto error;
+        }
+    }
+
+    if (ddsbench_numsub) {
+        ddsbench_sweepPrint(&sweep);
+    }
+
+    ctx->payload = payloadDefault;
+    ddsbench_sweepFini(&sweep);
+    return 0;
+error:
+    ctx->payload = payloadDefault;
+    ddsbench_sweepFini(&sweep);
+    return -1;
+}
@@ -0,0 +1,1074 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "core.h"
+
+/* Time ping waits for pong before it counts a roundtrip as lost */
+#define ROUNDTRIP_TIMEOUT_NS 1000000000ULL
+
+/* Time ping runs before it measures, so that startup jitter settles */
+#define WARMUP_NS 5000000000ULL
+
+/* Time a blocking wait lasts, so that termination and deadlines are noticed */
+#define WAIT_NS 100000000ULL
+
+/* Time a reliable write waits for resources, like max_blocking_time */
+#define MAX_BLOCKING_NS 10000000000ULL
+
+/* Samples of a latency endpoint, a roundtrip has one in flight */
+#define LATENCY_SAMPLES 100
+
+/* Samples taken at once */
+#define MAX_SAMPLES 100
+
+/* Time a write of a pool worker waits for resources, a writer that blocks
+ * stalls every endpoint of the worker so it gives up quickly */
+#define WORKER_BLOCKING_NS 1000000ULL
+
+/* Time a worker without a wait set sleeps between polls of its readers */
+#define WORKER_POLL_NS 100000ULL
+
+/* Time a durability writer waits for its readers to acknowledge the history */
+#define ACK_TIMEOUT_NS 10000000000ULL
+
+#define BYTES_PER_SEC_TO_MEGABITS_PER_SEC 125000
+#define BYTES_IN_MEGABYTE 1000000
+#define NS_IN_ONE_SEC 1000000000ULL
+
+void ddsbench_qosInit(ddsbench_qos *qos, const ddsbench_context *ctx, ddsbench_endpointKind kind, int writer)
+{
+    const char *c;
+
+    qos->durability = DDSBENCH_VOLATILE;
+    qos->reliable = 1;
+    qos->maxBlockingNs = MAX_BLOCKING_NS;
+    qos->depth = 0;
+    if (kind == DDSBENCH_LATENCY) {
+        qos->maxSamples = LATENCY_SAMPLES;
+    } else {
+        qos->maxSamples = writer ? ctx->maxsamples : DDSBENCH_READER_SAMPLES;
+    }
+
+    for (c = ctx->qos; c && *c; c++) {
+        switch (*c) {
+        case 'v':
+            qos->durability = DDSBENCH_VOLATILE;
+            break;
+        case 't':
+            qos->durability = DDSBENCH_TRANSIENT;
+            break;
+        case 'p':
+            qos->durability = DDSBENCH_PERSISTENT;
+            break;
+        case 'l':
+            qos->durability = DDSBENCH_TRANSIENT_LOCAL;
+            break;
+        case 'b':
+            qos->reliable = 0;
+            break;
+        case 'r':
+            qos->reliable = 1;
+            break;
+        }
+    }
+}
+
+typedef struct timeStats {
+    ddsbench_histogram histogram;
+    unsigned long long min;
+} timeStats;
+
+static void statsAdd(timeStats *stats, unsigned long long ns)
+{
+    if (!stats->histogram.count || ns < stats->min) {
+        stats->min = ns;
+    }
+    ddsbench_histogramAdd(&stats->histogram, ns);
+}
+
+static void statsPrint(timeStats *stats)
+{
+    printf(" %9llu %8.2f %8.2f", stats->histogram.count,
+        ddsbench_histogramQuantile(&stats->histogram, 0.5) / 1000.0, stats->min / 1000.0);
+}
+
+static void sleepNs(unsigned long long ns)
+{
+    struct timespec delay;
+
+    delay.tv_sec = ns / NS_IN_ONE_SEC;
+    delay.tv_nsec = ns % NS_IN_ONE_SEC;
+    nanosleep(&delay, NULL);
+}
+
+/* Take the answer to sample expect, blocking or polling as configured. An
+ * answer to a roundtrip that was lost is skipped, when the type has a count.
+ * Returns 1, or 0 when nothing arrived within ROUNDTRIP_TIMEOUT_NS or when
+ * interrupted. The sample stays valid until takeDone. */
+static int takeNext(const ddsbench_ops *ops, void *reader, ddsbench_poll *poll, unsigned long long expect,
+    ddsbench_sample *sample)
+{
+    unsigned long long start = ddsbench_time();
+    int n;
+
+    for (;;) {
+        if (ddsbench_pollBlock(poll)) {
+            ops->wait(reader, WAIT_NS);
+        }
+        n = ops->take(reader, sample, 1);
+        if (ddsbench_pollTaken(poll, n > 0)) {
+            if (sample->count == expect || sample->count == DDSBENCH_NO_COUNT) {
+                return 1;
+            }
+            ops->takeDone(reader);
+        }
+        if (ops->terminated() || ddsbench_time() - start > ROUNDTRIP_TIMEOUT_NS) {
+            return 0;
+        }
+    }
+}
+
+/* Ping writes a sample and measures until pong sent it back */
+int ddsbench_engineLsub(ddsbench_threadArg *arg)
+{
+    const ddsbench_ops *ops = arg->plugin->ops;
+    char pingPartition[32], pongPartition[32];
+    void *writer = NULL, *reader = NULL;
+    ddsbench_sample sample, taken;
+    ddsbench_qos qos;
+    ddsbench_payloadPool payloads;
+    ddsbench_poll poll;
+    timeStats roundTrip, writeAccess, readAccess;
+    timeStats roundTripOverall, writeAccessOverall, readAccessOverall;
+    unsigned long long preWriteTime, postWriteTime, preTakeTime, postTakeTime;
+    unsigned long long startTime, measureStart;
+    unsigned long long duration = arg->ctx->duration * NS_IN_ONE_SEC;
+    unsigned int payloadSize = arg->ctx->payload;
+    int warmUp = 1, elapsed = 0, rc, result = EXIT_FAILURE;
+
+    sprintf(pingPartition, "ping_%d", arg->id);
+    sprintf(pongPartition, "pong_%d", arg->id);
+
+    memset(&roundTrip, 0, sizeof(timeStats));
+    memset(&writeAccess, 0, sizeof(timeStats));
+    memset(&readAccess, 0, sizeof(timeStats));
+    memset(&roundTripOverall, 0, sizeof(timeStats));
+    memset(&writeAccessOverall, 0, sizeof(timeStats));
+    memset(&readAccessOverall, 0, sizeof(timeStats));
+    memset(&sample, 0, sizeof(sample));
+
+    if (ddsbench_payloadAlloc(&payloads, arg->ctx, payloadSize)) {
+        printf("sub %d: failed to allocate payloads of %u bytes\n", arg->id, payloadSize);
+        return EXIT_FAILURE;
+    }
+    ddsbench_qosInit(&qos, arg->ctx, DDSBENCH_LATENCY, 1);
+    if (!(writer = ops->writerNew(arg, DDSBENCH_LATENCY, pingPartition, &qos))) {
+        goto error;
+    }
+    ddsbench_qosInit(&qos, arg->ctx, DDSBENCH_LATENCY, 0);
+    if (!(reader = ops->readerNew(arg, DDSBENCH_LATENCY, pongPartition, &qos, NULL, NULL))) {
+        goto error;
+    }
+    sample.id = arg->id;
+    sample.length = payloadSize;
+
+    /* Start when matched with pong, together with the other threads */
+    ops->waitMatched(arg, writer, reader);
+    ddsbench_startBarrier(arg->ctx);
+    ddsbench_pollInit(&poll, arg->ctx, &arg->result);
+
+    startTime = ddsbench_time();
+    printf("# Waiting for startup jitter to stabilise\n");
+    while (!ops->terminated() && ddsbench_time() - startTime < WARMUP_NS) {
+        sample.payload = ddsbench_payloadNext(&payloads);
+        sample.filter = sample.count % 10;
+        if (ops->write(writer, &sample) != DDSBENCH_WRITE_OK) {
+            printf("sub %d: pong did not take its samples\n", arg->id);
+            goto error;
+        }
+        ops->flush(writer);
+        sample.count++;
+        if (takeNext(ops, reader, &poll, sample.count - 1, &taken)) {
+            ops->takeDone(reader);
+        }
+    }
+    if (!ops->terminated()) {
+        warmUp = 0;
+        printf("# Warm up complete.\n\n");
+
+        printf("# Round trip measurements (in us)\n");
+        printf("#             Round trip time [us]         Write-access time [us]       Read-access time [us]\n");
+        printf("# Seconds     Count   median      min      Count   median      min      Count   median      min\n");
+    }
+
+    measureStart = startTime = ddsbench_time();
+    while (!ops->terminated() && (!duration || ddsbench_time() - measureStart < duration)) {
+        /* Write a sample that pong can send back */
+        sample.payload = ddsbench_payloadNext(&payloads);
+        sample.filter = sample.count % 10;
+        preWriteTime = ddsbench_time();
+        rc = ops->write(writer, &sample);
+        ops->flush(writer);
+        postWriteTime = ddsbench_time();
+        if (rc != DDSBENCH_WRITE_OK) {
+            printf("sub %d: pong did not take its samples\n", arg->id);
+            goto error;
+        }
+        sample.count++;
+
+        /* Wait for response from pong, blocking or polling as configured */
+        preTakeTime = ddsbench_time();
+        rc = takeNext(ops, reader, &poll, sample.count - 1, &taken);
+        postTakeTime = ddsbench_time();
+        if (!rc) {
+            elapsed += ROUNDTRIP_TIMEOUT_NS / NS_IN_ONE_SEC;
+            continue;
+        }
+        ddsbench_reportTake(arg, taken.length,
+            taken.timestamp && postTakeTime >= taken.timestamp ? (long long)(postTakeTime - taken.timestamp) : -1);
+        ops->takeDone(reader);
+
+        /* Update stats */
+        statsAdd(&writeAccess, postWriteTime - preWriteTime);
+        statsAdd(&writeAccessOverall, postWriteTime - preWriteTime);
+        statsAdd(&readAccess, postTakeTime - preTakeTime);
+        statsAdd(&readAccessOverall, postTakeTime - preTakeTime);
+        statsAdd(&roundTrip, postTakeTime - preWriteTime);
+        statsAdd(&roundTripOverall, postTakeTime - preWriteTime);
+        ddsbench_histogramAdd(&arg->result.roundTripNs, postTakeTime - preWriteTime);
+
+        /* Print stats each second */
+        if (postTakeTime - startTime > NS_IN_ONE_SEC) {
+            printf("%9d", ++elapsed);
+            statsPrint(&roundTrip);
+            statsPrint(&writeAccess);
+            statsPrint(&readAccess);
+            printf("\n");
+
+            memset(&roundTrip, 0, sizeof(timeStats));
+            memset(&writeAccess, 0, sizeof(timeStats));
+            memset(&readAccess, 0, sizeof(timeStats));
+            startTime = ddsbench_time();
+        }
+    }
+
+    if (!warmUp) {
+        printf("\n%9s", "# Overall");
+        statsPrint(&roundTripOverall);
+        statsPrint(&writeAccessOverall);
+        statsPrint(&readAccessOverall);
+        printf("\n");
+    }
+    result = EXIT_SUCCESS;
+
+error:
+    /* Pong stops once the ping writer is gone */
+    if (writer) {
+        ops->writerFree(writer);
+    }
+    if (reader) {
+        ops->readerFree(reader);
+    }
+    ddsbench_payloadFree(&payloads);
+
+    return result;
+}
+
+/* Pong sends every sample of ping back */
+int ddsbench_engineLpub(ddsbench_threadArg *arg)
+{
+    const ddsbench_ops *ops = arg->plugin->ops;
+    char pingPartition[32], pongPartition[32];
+    void *writer = NULL, *reader = NULL;
+    ddsbench_sample samples[MAX_SAMPLES], reply;
+    ddsbench_qos qos;
+    ddsbench_poll poll;
+    unsigned long long now;
+    int i, n, result = EXIT_FAILURE;
+
+    sprintf(pingPartition, "ping_%d", arg->id);
+    sprintf(pongPartition, "pong_%d", arg->id);
+
+    ddsbench_qosInit(&qos, arg->ctx, DDSBENCH_LATENCY, 0);
+    if (!(reader = ops->readerNew(arg, DDSBENCH_LATENCY, pingPartition, &qos, NULL, NULL))) {
+        goto error;
+    }
+    ddsbench_qosInit(&qos, arg->ctx, DDSBENCH_LATENCY, 1);
+    if (!(writer = ops->writerNew(arg, DDSBENCH_LATENCY, pongPartition, &qos))) {
+        goto error;
+    }
+
+    /* Start when matched with ping, together with the other threads */
+    ops->waitMatched(arg, writer, reader);
+    ddsbench_startBarrier(arg->ctx);
+
+    printf("Waiting for samples from ping to send back...\n");
+    fflush(stdout);
+
+    ddsbench_pollInit(&poll, arg->ctx, &arg->result);
+    while (!ops->terminated()) {
+        /* Wait for a sample from ping, unless polling */
+        if (ddsbench_pollBlock(&poll)) {
+            ops->wait(reader, WAIT_NS);
+        }
+        n = ops->take(reader, samples, MAX_SAMPLES);
+        if (!ddsbench_pollTaken(&poll, n > 0)) {
+            /* If the writer of ping is gone terminate pong */
+            if (ops->writersGone(reader)) {
+                printf("Received termination request. Terminating.\n");
+                break;
+            }
+            continue;
+        }
+        now = ddsbench_time();
+
+        /* Verify the payloads from ping before sending them back */
+        if (arg->ctx->verify) {
+            unsigned long long verifyStart = ddsbench_cpuTime(1);
+            for (i = 0; i < n; i++) {
+                ddsbench_payloadVerify(samples[i].payload, samples[i].length, &arg->result);
+            }
+            arg->result.verifyNs += ddsbench_cpuTime(1) - verifyStart;
+        }
+
+        /* Send them back to ping, a loaned sample is written from where it was taken */
+        for (i = 0; i < n; i++) {
+            ddsbench_reportTake(arg, samples[i].length,
+                samples[i].timestamp && now >= samples[i].timestamp ? (long long)(now - samples[i].timestamp) : -1);
+            reply = samples[i];
+            reply.id = arg->id;
+            ops->write(writer, &reply);
+        }
+        ops->flush(writer);
+        ops->takeDone(reader);
+    }
+    result = EXIT_SUCCESS;
+
+error:
+    if (writer) {
+        ops->writerFree(writer);
+    }
+    if (reader) {
+        ops->readerFree(reader);
+    }
+
+    return result;
+}
+
+int ddsbench_engineTpub(ddsbench_threadArg *arg)
+{
+    const ddsbench_ops *ops = arg->plugin->ops;
+    ddsbench_context *ctx = arg->ctx;
+    unsigned int payloadSize = ctx->payload;
+    unsigned int burstInterval = ctx->burstinterval;
+    unsigned int burstSize = ctx->burstsize;
+    unsigned int timeOut = ctx->duration;
+    void *writer;
+    ddsbench_sample sample;
+    ddsbench_qos qos;
+    ddsbench_payloadPool payloads;
+    unsigned long long t0, cpuStart, burstStart, writeStart, writeEnd, intervalStart;
+    unsigned long long intervalWrites = 0, intervalBlocked = 0, intervalTimeouts = 0, intervalMax = 0;
+    unsigned int burstCount = 0;
+    int rc = DDSBENCH_WRITE_OK;
+
+    printf("payloadSize: %u bytes burstInterval: %u ms burstSize: %u timeOut: %u seconds partitionName: %s\n",
+        payloadSize, burstInterval, burstSize, timeOut, "throughput");
+
+    if (ddsbench_payloadAlloc(&payloads, ctx, payloadSize)) {
+        printf("pub %d: failed to allocate payloads of %u bytes\n", arg->id, payloadSize);
+        return EXIT_FAILURE;
+    }
+    ddsbench_qosInit(&qos, ctx, DDSBENCH_THROUGHPUT, 1);
+    if (!(writer = ops->writerNew(arg, DDSBENCH_THROUGHPUT, "throughput", &qos))) {
+        ddsbench_payloadFree(&payloads);
+        return EXIT_FAILURE;
+    }
+    memset(&sample, 0, sizeof(sample));
+    sample.id = arg->id;
+    sample.length = payloadSize;
+
+    /* Start when matched with all readers, together with the other threads */
+    ops->waitMatched(arg, writer, NULL);
+    t0 = ddsbench_startBarrier(ctx);
+    burstStart = intervalStart = ddsbench_time();
+    cpuStart = ddsbench_cpuTime(0);
+
+    /* A write that timed out is retried, the interval line reports it */
+    printf("Writing samples...\n");
+    while (!ops->terminated() && rc != DDSBENCH_WRITE_ERROR) {
+        /* Write data until burst size has been reached, a batch is sent with its last sample */
+        if (burstCount < burstSize) {
+            sample.payload = ddsbench_payloadNext(&payloads);
+            sample.filter = sample.count % 10;
+            writeStart = ddsbench_time();
+            rc = ops->write(writer, &sample);
+            if (rc == DDSBENCH_WRITE_OK && burstCount + 1 == burstSize) {
+                ops->flush(writer);
+            }
+            writeEnd = ddsbench_time();
+            ddsbench_reportWrite(arg, writeStart, writeEnd, rc != DDSBENCH_WRITE_OK);
+            intervalWrites++;
+            if (writeEnd - writeStart > DDSBENCH_BLOCKED_NS) {
+                intervalBlocked++;
+            }
+            if (writeEnd - writeStart > intervalMax) {
+                intervalMax = writeEnd - writeStart;
+            }
+            if (rc == DDSBENCH_WRITE_OK) {
+                sample.count++;
+                burstCount++;
+            } else if (rc == DDSBENCH_WRITE_TIMEOUT) {
+                intervalTimeouts++;
+            } else {
+                printf("pub %d: write failed\n", arg->id);
+            }
+
+            /* Report flow control of the last interval */
+            if (writeEnd - intervalStart >= NS_IN_ONE_SEC) {
+                printf("pub %d: %llu writes, %llu blocked, %llu timeouts, max %.1f us\n",
+                    arg->id, intervalWrites, intervalBlocked, intervalTimeouts, intervalMax / 1000.0);
+                intervalStart = writeEnd;
+                intervalWrites = intervalBlocked = intervalTimeouts = intervalMax = 0;
+            }
+        } else if (burstInterval) {
+            /* Sleep until burst interval has passed */
+            unsigned long long deltaNs = ddsbench_time() - burstStart;
+            if (deltaNs < burstInterval * 1000000ULL) {
+                sleepNs(burstInterval * 1000000ULL - deltaNs);
+            }
+            burstStart = ddsbench_time();
+            burstCount = 0;
+        } else {
+            burstCount = 0;
+        }
+
+        if (timeOut && ddsbench_time() - t0 >= timeOut * NS_IN_ONE_SEC) {
+            break;
+        }
+    }
+    ops->flush(writer);
+
+    arg->result.cpuNs = ddsbench_cpuTime(0) - cpuStart;
+
+    if (ops->terminated()) {
+        printf("pub %d: Terminated, %llu samples written.\n", arg->id, sample.count);
+    } else {
+        printf("pub %d: Timed out, %llu samples written.\n", arg->id, sample.count);
+    }
+
+    ops->writerFree(writer);
+    ddsbench_payloadFree(&payloads);
+
+    return rc == DDSBENCH_WRITE_ERROR ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* Next count expected from every publisher, by publisher id */
+typedef struct pubCount {
+    int id;
+    unsigned long long next;
+    unsigned long long received;
+} pubCount;
+
+/* What a subscriber received. The receive loop or the listener of the reader
+ * counts under lock, the loop of tsub reports from it. */
+typedef struct subState {
+    ddsbench_threadArg *arg;
+    const ddsbench_predicate *predicate;    /* Applied after take, see --filterin local */
+    int gaps;                               /* Skipped counts are missing samples, not filtered ones */
+    pthread_mutex_t lock;
+    pubCount *pubs;
+    int numPubs;
+    int maxPubs;
+    unsigned long long totalSamples;
+    unsigned long long received;
+    unsigned long long outOfOrder;
+    unsigned long long missing;
+    ddsbench_sample samples[MAX_SAMPLES];
+    unsigned char accepted[MAX_SAMPLES];
+} subState;
+
+static pubCount* pubCountGet(subState *state, int id, unsigned long long count)
+{
+    int i;
+
+    for (i = 0; i < state->numPubs; i++) {
+        if (state->pubs[i].id == id) {
+            return &state->pubs[i];
+        }
+    }
+    if (state->numPubs == state->maxPubs) {
+        int max = state->maxPubs ? state->maxPubs * 2 : 8;
+        pubCount *pubs = realloc(state->pubs, max * sizeof(pubCount));
+        if (!pubs) {
+            return NULL;
+        }
+        state->pubs = pubs;
+        state->maxPubs = max;
+    }
+    state->pubs[state->numPubs].id = id;
+    state->pubs[state->numPubs].next = count;
+    state->pubs[state->numPubs].received = 0;
+    return &state->pubs[state->numPubs++];
+}
+
+/* Take the samples reader has and count them. Returns the number taken. */
+static int receive(subState *state, void *reader)
+{
+    ddsbench_threadArg *arg = state->arg;
+    ddsbench_sample *samples = state->samples;
+    unsigned long long now;
+    int i, n;
+
+    pthread_mutex_lock(&state->lock);
+    if ((n = arg->plugin->ops->take(reader, samples, MAX_SAMPLES)) <= 0) {
+        pthread_mutex_unlock(&state->lock);
+        return 0;
+    }
+
+    /* Writers are on this host, so their timestamp gives the delivery latency */
+    now = ddsbench_time();
+    for (i = 0; i < n; i++) {
+        if (samples[i].timestamp && now >= samples[i].timestamp) {
+            ddsbench_histogramAdd(&arg->result.latencyNs, now - samples[i].timestamp);
+        }
+    }
+
+    /* Verify the payloads in a separate pass as well, reading every byte */
+    if (arg->ctx->verify) {
+        unsigned long long verifyStart = ddsbench_cpuTime(1);
+        for (i = 0; i < n; i++) {
+            ddsbench_payloadVerify(samples[i].payload, samples[i].length, &arg->result);
+        }
+        arg->result.verifyNs += ddsbench_cpuTime(1) - verifyStart;
+    }
+
+    /* Apply the local predicate in a separate pass, so that only its cost is measured */
+    if (state->predicate) {
+        long long fields[DDSBENCH_FIELD_MAX];
+        unsigned long long filterStart = ddsbench_cpuTime(1);
+        for (i = 0; i < n; i++) {
+            fields[DDSBENCH_FIELD_ID] = samples[i].id;
+            fields[DDSBENCH_FIELD_FILTER] = samples[i].filter;
+            fields[DDSBENCH_FIELD_COUNT] = samples[i].count;
+            state->accepted[i] = ddsbench_predicateEval(state->predicate, fields);
+        }
+        arg->result.filterNs += ddsbench_cpuTime(1) - filterStart;
+        arg->result.evaluated += n;
+    }
+
+    for (i = 0; i < n; i++) {
+        pubCount *pub = pubCountGet(state, samples[i].id, samples[i].count);
+
+        /* Samples rejected by the local predicate are received in order */
+        if (pub && state->predicate && !state->accepted[i]) {
+            pub->next = samples[i].count + 1;
+            continue;
+        }
+
+        /* Check that the sample is the next one expected */
+        if (pub) {
+            if (samples[i].count < pub->next) {
+                state->outOfOrder++;
+            } else if (state->gaps) {
+                state->missing += samples[i].count - pub->next;
+            }
+            pub->next = samples[i].count + 1;
+            pub->received++;
+        }
+        state->totalSamples++;
+        state->received += samples[i].length + 8;
+    }
+    arg->plugin->ops->takeDone(reader);
+    pthread_mutex_unlock(&state->lock);
+
+    return n;
+}
+
+/* Listener of the reader, which takes until the reader is empty */
+static void onData(void *reader, void *arg)
+{
+    while (receive(arg, reader) == MAX_SAMPLES) {
+    }
+}
+
+int ddsbench_engineTsub(ddsbench_threadArg *arg)
+{
+    const ddsbench_ops *ops = arg->plugin->ops;
+    ddsbench_context *ctx = arg->ctx;
+    unsigned long timeOut = ctx->duration;
+    int listen = !ctx->pollingdelay && ctx->recv == DDSBENCH_RECV_BLOCK && (arg->plugin->capabilities & DDSBENCH_CAP_LISTENERS);
+    void *reader;
+    subState *state;
+    ddsbench_qos qos;
+    ddsbench_poll poll;
+    unsigned long long t0, now, startTime = 0, prevTime = 0;
+    unsigned long long totalSamples, received, missing, prevSamples = 0, prevReceived = 0;
+    double deltaTime;
+    int i, n, taken, numPubs;
+
+    if (!(state = calloc(1, sizeof(subState)))) {
+        printf("sub %d: out of memory\n", arg->id);
+        return EXIT_FAILURE;
+    }
+    state->arg = arg;
+    state->predicate = ctx->localfilter ? ctx->predicate : NULL;
+    state->gaps = !ctx->filter || ctx->localfilter;
+    pthread_mutex_init(&state->lock, NULL);
+
+    ddsbench_qosInit(&qos, ctx, DDSBENCH_THROUGHPUT, 0);
+    if (!(reader = ops->readerNew(arg, DDSBENCH_THROUGHPUT, "throughput", &qos, listen ? onData : NULL, state))) {
+        pthread_mutex_destroy(&state->lock);
+        free(state);
+        return EXIT_FAILURE;
+    }
+
+    /* Start when matched with all writers, together with the other threads */
+    ops->waitMatched(arg, NULL, reader);
+    t0 = ddsbench_startBarrier(ctx);
+
+    if ((unsigned int)arg->id == ctx->subid) {
+        printf("\n");
+        printf("Throughput measurements\n");
+        printf("          Total Received        Missing   Transfer rate              Publishers\n");
+        printf("        %9s %11s %9s %9s %16s %7s\n", "samples", "bytes", "samples", "samples", "bytes", "count");
+    }
+
+    ddsbench_pollInit(&poll, ctx, &arg->result);
+    while (!ops->terminated()) {
+        /* Stop when the configured duration has passed */
+        if (timeOut && ddsbench_time() - t0 >= timeOut * NS_IN_ONE_SEC) {
+            break;
+        }
+
+        /* The listener takes the samples, or sleep before polling again, or
+         * wait for samples. Spinning and hybrid receivers never sleep. */
+        if (listen) {
+            sleepNs(WAIT_NS);
+        } else {
+            if (ctx->pollingdelay && ctx->recv == DDSBENCH_RECV_BLOCK) {
+                sleepNs(ctx->pollingdelay * 1000000ULL);
+            } else if (ddsbench_pollBlock(&poll)) {
+                ops->wait(reader, WAIT_NS);
+            }
+
+            /* Take until the reader is empty, like the listener, so that a
+             * poll is not capped at MAX_SAMPLES. A take can return fewer
+             * while more are pending (a batch of datagrams), so only an
+             * empty take ends it. */
+            taken = n = receive(state, reader);
+            while (n > 0) {
+                taken += n = receive(state, reader);
+            }
+            ddsbench_pollTaken(&poll, taken);
+        }
+
+        /* Check that at least one second has passed since the last output */
+        now = ddsbench_time();
+        if (now > prevTime + NS_IN_ONE_SEC) {
+            pthread_mutex_lock(&state->lock);
+            totalSamples = state->totalSamples;
+            received = state->received;
+            missing = state->missing;
+            numPubs = state->numPubs;
+            pthread_mutex_unlock(&state->lock);
+
+            if (prevTime) {
+                deltaTime = (double)(now - prevTime) / NS_IN_ONE_SEC;
+                printf("sub %2d: %8.2lfK %9.2lfMB %9llu %8.2lfK %9.2lf Mbit/s %7d\n",
+                    arg->id,
+                    (double)totalSamples / 1000.0,
+                    (double)received / (double)BYTES_IN_MEGABYTE,
+                    missing,
+                    ((totalSamples - prevSamples) / deltaTime) / 1000,
+                    ((double)(received - prevReceived) / BYTES_PER_SEC_TO_MEGABITS_PER_SEC) / deltaTime,
+                    numPubs);
+                fflush(stdout);
+            } else {
+                startTime = now;
+            }
+
+            /* Publish progress, so that a launcher can report intervals */
+            arg->result.samples = totalSamples;
+            arg->result.bytes = received;
+            prevSamples = totalSamples;
+            prevReceived = received;
+            prevTime = now;
+        }
+    }
+
+    /* The window the samples were received in, from which a launcher computes the rate */
+    arg->result.measureNs = ddsbench_time() - t0;
+
+    /* The listener is done once the reader is gone */
+    ops->readerFree(reader);
+
+    /* Output totals and averages */
+    deltaTime = startTime ? (double)(ddsbench_time() - startTime) / NS_IN_ONE_SEC : 0;
+    printf("\nTotal received: %llu samples, %llu bytes\n", state->totalSamples, state->received);
+    printf("Missing: %llu samples\n", state->missing);
+    printf("Out of order: %llu samples\n", state->outOfOrder);
+    if (deltaTime > 0) {
+        printf("Average transfer rate: %.2lf samples/s, %.2lf Mbit/s\n",
+            state->totalSamples / deltaTime, ((double)state->received / BYTES_PER_SEC_TO_MEGABITS_PER_SEC) / deltaTime);
+    }
+    for (i = 0; i < state->numPubs; i++) {
+        printf("  pub %d: %llu samples\n", state->pubs[i].id, state->pubs[i].received);
+    }
+
+    arg->result.samples = state->totalSamples;
+    arg->result.bytes = state->received;
+
+    pthread_mutex_destroy(&state->lock);
+    free(state->pubs);
+    free(state);
+
+    return EXIT_SUCCESS;
+}
+
+/* QoS of the durability mode, on which writers and readers agree, so that a
+ * product can derive the QoS of the topic from it. The history of every
+ * instance is kept for late joiners. */
+static void durabilityQos(ddsbench_qos *qos, const ddsbench_context *ctx, int writer)
+{
+    ddsbench_qosInit(qos, ctx, DDSBENCH_THROUGHPUT, writer);
+    qos->reliable = 1;
+    qos->maxSamples = -1;
+    qos->depth = (ctx->history + ctx->instances - 1) / ctx->instances;
+    if (!qos->depth) {
+        qos->depth = 1;
+    }
+}
+
+/* The publisher of the durability mode writes the history round-robin over
+ * its instances. For transient and persistent QoS the writer is deleted
+ * before the late joiners start, so that the history has to come from the
+ * durability service. For transient local QoS the writer stays alive until
+ * all late joiners have received the history. */
+int ddsbench_engineDpub(ddsbench_threadArg *arg)
+{
+    const ddsbench_ops *ops = arg->plugin->ops;
+    ddsbench_context *ctx = arg->ctx;
+    void *writer;
+    ddsbench_sample sample;
+    ddsbench_qos qos;
+    ddsbench_payloadPool payloads;
+    unsigned long long i, start;
+
+    if (ddsbench_payloadAlloc(&payloads, ctx, ctx->payload)) {
+        printf("pub %d: failed to allocate payloads of %u bytes\n", arg->id, ctx->payload);
+        ddsbench_latchArrive(ctx->historyWritten);
+        return EXIT_FAILURE;
+    }
+    durabilityQos(&qos, ctx, 1);
+    if (!(writer = ops->writerNew(arg, DDSBENCH_THROUGHPUT, "durability", &qos))) {
+        ddsbench_latchArrive(ctx->historyWritten);
+        ddsbench_payloadFree(&payloads);
+        return EXIT_FAILURE;
+    }
+    memset(&sample, 0, sizeof(sample));
+    sample.length = ctx->payload;
+
+    printf("pub %d: writing %u historical samples over %u instances\n", arg->id, ctx->history, ctx->instances);
+    start = ddsbench_time();
+    for (i = 0; i < ctx->history; i++) {
+        sample.id = arg->id * ctx->instances + i % ctx->instances;
+        sample.filter = i % 10;
+        sample.count = i;
+        sample.payload = ddsbench_payloadNext(&payloads);
+        if (ops->write(writer, &sample) != DDSBENCH_WRITE_OK) {
+            printf("pub %d: wrote %llu of %u historical samples\n", arg->id, i, ctx->history);
+            break;
+        }
+    }
+    ops->flush(writer);
+    if (ops->waitAcked) {
+        ops->waitAcked(writer, ACK_TIMEOUT_NS);
+    }
+
+    arg->result.samples = i;
+    arg->result.bytes = i * ctx->payload;
+    arg->result.alignNs = ddsbench_time() - start;
+
+    /* Without a writer the history must be aligned by the durability service */
+    if (qos.durability != DDSBENCH_TRANSIENT_LOCAL) {
+        ops->writerFree(writer);
+        writer = NULL;
+    }
+
+    ddsbench_latchArrive(ctx->historyWritten);
+
+    if (writer) {
+        ddsbench_latchWait(ctx->historyAligned);
+        ops->writerFree(writer);
+    }
+    ddsbench_payloadFree(&payloads);
+
+    return i == ctx->history ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* The subscriber of the durability mode joins late and measures the time
+ * until the complete history is received */
+int ddsbench_engineDsub(ddsbench_threadArg *arg)
+{
+    const ddsbench_ops *ops = arg->plugin->ops;
+    ddsbench_context *ctx = arg->ctx;
+    void *reader;
+    ddsbench_sample samples[MAX_SAMPLES];
+    ddsbench_qos qos;
+    unsigned long long start, deadline, now;
+    int i, n;
+
+    /* Wait until the history is written before joining */
+    ddsbench_latchWait(ctx->historyWritten);
+
+    /* The clock starts when the late joiner is created */
+    durabilityQos(&qos, ctx, 0);
+    start = ddsbench_time();
+    deadline = start + ctx->duration * NS_IN_ONE_SEC;
+    if (!(reader = ops->readerNew(arg, DDSBENCH_THROUGHPUT, "durability", &qos, NULL, NULL))) {
+        ddsbench_latchArrive(ctx->historyAligned);
+        return EXIT_FAILURE;
+    }
+    if (ops->waitHistory) {
+        ops->waitHistory(reader, ctx->duration * NS_IN_ONE_SEC);
+    }
+    arg->result.waitNs = ddsbench_time() - start;
+
+    /* Take samples until the complete history has been received */
+    now = start;
+    while (!ops->terminated() && arg->result.samples < ctx->expected && now < deadline) {
+        ops->wait(reader, WAIT_NS);
+        while ((n = ops->take(reader, samples, MAX_SAMPLES)) > 0) {
+            if (ctx->verify) {
+                unsigned long long verifyStart = ddsbench_cpuTime(1);
+                for (i = 0; i < n; i++) {
+                    ddsbench_payloadVerify(samples[i].payload, samples[i].length, &arg->result);
+                }
+                arg->result.verifyNs += ddsbench_cpuTime(1) - verifyStart;
+            }
+            for (i = 0; i < n; i++) {
+                arg->result.samples++;
+                arg->result.bytes += samples[i].length;
+            }
+            ops->takeDone(reader);
+        }
+        now = ddsbench_time();
+    }
+    arg->result.alignNs = now - start;
+
+    if (arg->result.samples < ctx->expected) {
+        printf("sub %d: received %llu of %llu historical samples\n", arg->id, arg->result.samples, ctx->expected);
+    }
+
+    ddsbench_latchArrive(ctx->historyAligned);
+    ops->readerFree(reader);
+
+    return EXIT_SUCCESS;
+}
+
+/* Write a burst for a writer of a pool worker that is due. The rest of the
+ * burst is given up on when a write times out, the wheel retries next
+ * interval. Returns the result of the last write. */
+static int writeBurst(const ddsbench_ops *ops, ddsbench_threadArg *arg, void *writer, ddsbench_payloadPool *payloads)
+{
+    ddsbench_sample sample;
+    unsigned long long writeStart, writeEnd;
+    unsigned int i;
+    int rc = DDSBENCH_WRITE_OK;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.id = arg->id;
+    sample.length = arg->ctx->payload;
+    for (i = 0; i < arg->ctx->burstsize && rc == DDSBENCH_WRITE_OK; i++) {
+        sample.count = arg->result.samples;
+        sample.filter = sample.count % 10;
+        sample.payload = ddsbench_payloadNext(payloads);
+        writeStart = ddsbench_time();
+        rc = ops->write(writer, &sample);
+        writeEnd = ddsbench_time();
+        ddsbench_reportWrite(arg, writeStart, writeEnd, rc != DDSBENCH_WRITE_OK);
+    }
+    ops->flush(writer);
+    return rc;
+}
+
+/* Take the samples a reader of a pool worker has. Returns the number taken. */
+static int takeAll(const ddsbench_ops *ops, ddsbench_threadArg *arg, void *reader, ddsbench_sample *samples)
+{
+    unsigned long long now;
+    int i, n, total = 0;
+
+    do {
+        if ((n = ops->take(reader, samples, MAX_SAMPLES)) <= 0) {
+            break;
+        }
+        now = ddsbench_time();
+        if (arg->ctx->verify) {
+            unsigned long long verifyStart = ddsbench_cpuTime(1);
+            for (i = 0; i < n; i++) {
+                ddsbench_payloadVerify(samples[i].payload, samples[i].length, &arg->result);
+            }
+            arg->result.verifyNs += ddsbench_cpuTime(1) - verifyStart;
+        }
+        for (i = 0; i < n; i++) {
+            ddsbench_reportTake(arg, samples[i].length + 8,
+                samples[i].timestamp && now >= samples[i].timestamp ? (long long)(now - samples[i].timestamp) : -1);
+        }
+        ops->takeDone(reader);
+        total += n;
+    } while (n == MAX_SAMPLES);
+
+    return total;
+}
+
+/* A pool worker creates the readers and writers of many topics, waits for
+ * all of its readers at once and writes a burst for each of its writers
+ * whenever the pacing wheel says that the writer is due, until the duration
+ * has passed or the benchmark is interrupted */
+int ddsbench_engineTworker(ddsbench_worker *worker)
+{
+    const ddsbench_ops *ops = worker->args[0]->plugin->ops;
+    ddsbench_context *ctx = worker->ctx;
+    ddsbench_threadArg **writerArgs, **readerArgs;
+    void **writers, **readers, *waitSet = NULL;
+    ddsbench_sample samples[MAX_SAMPLES];
+    ddsbench_qos writerQos, readerQos;
+    ddsbench_payloadPool payloads;
+    ddsbench_wheel wheel;
+    unsigned long long start, now, deadline, waitNs, intervalStart;
+    unsigned long long writes = 0, takes = 0, wakeups = 0;
+    int numWriters = 0, numReaders = 0, taken, w, due, rc = DDSBENCH_WRITE_OK, result = EXIT_FAILURE;
+
+    memset(&wheel, 0, sizeof(wheel));
+    writerArgs = calloc(worker->count, sizeof(ddsbench_threadArg*));
+    readerArgs = calloc(worker->count, sizeof(ddsbench_threadArg*));
+    writers = calloc(worker->count, sizeof(void*));
+    readers = calloc(worker->count, sizeof(void*));
+    if (!writerArgs || !readerArgs || !writers || !readers) {
+        printf("worker %d: out of memory\n", worker->id);
+        goto error;
+    }
+
+    /* All writers of the worker share one pool of prefaulted payloads */
+    if (ddsbench_payloadAlloc(&payloads, ctx, ctx->payload)) {
+        printf("worker %d: failed to allocate payloads of %u bytes\n", worker->id, ctx->payload);
+        goto error;
+    }
+
+    ddsbench_qosInit(&writerQos, ctx, DDSBENCH_THROUGHPUT, 1);
+    writerQos.maxBlockingNs = WORKER_BLOCKING_NS;
+    ddsbench_qosInit(&readerQos, ctx, DDSBENCH_THROUGHPUT, 0);
+    for (w = 0; w < worker->count; w++) {
+        ddsbench_threadArg *arg = worker->args[w];
+        if (arg->role == DDSBENCH_PUBLISHER) {
+            if (!(writers[numWriters] = ops->writerNew(arg, DDSBENCH_THROUGHPUT, "throughput", &writerQos))) {
+                goto cleanup;
+            }
+            writerArgs[numWriters++] = arg;
+        } else {
+            if (!(readers[numReaders] = ops->readerNew(arg, DDSBENCH_THROUGHPUT, "throughput", &readerQos, NULL, NULL))) {
+                goto cleanup;
+            }
+            readerArgs[numReaders++] = arg;
+        }
+    }
+    if (numReaders && ops->waitSetNew && !(waitSet = ops->waitSetNew(readers, numReaders))) {
+        goto cleanup;
+    }
+
+    /* Start when all endpoints are matched, together with the other workers */
+    for (w = 0; w < numWriters; w++) {
+        ops->waitMatched(writerArgs[w], writers[w], NULL);
+    }
+    for (w = 0; w < numReaders; w++) {
+        ops->waitMatched(readerArgs[w], NULL, readers[w]);
+    }
+    start = intervalStart = ddsbench_startBarrier(ctx);
+    deadline = start + ctx->duration * NS_IN_ONE_SEC;
+    if (ddsbench_wheelInit(&wheel, numWriters, ctx->burstinterval * 1000000ULL, start)) {
+        printf("worker %d: out of memory\n", worker->id);
+        goto cleanup;
+    }
+
+    printf("worker %d: %d writers, %d readers\n", worker->id, numWriters, numReaders);
+
+    now = start;
+    while (!ops->terminated() && rc != DDSBENCH_WRITE_ERROR && (!ctx->duration || now < deadline)) {
+        /* Write a burst for every writer that is due, at most one each, so that
+         * writers that are always due (--burstinterval 0) do not starve the readers */
+        waitNs = NS_IN_ONE_SEC;
+        for (due = 0; due < numWriters && (w = ddsbench_wheelPop(&wheel, now, &waitNs)) >= 0; due++) {
+            if ((rc = writeBurst(ops, writerArgs[w], writers[w], &payloads)) == DDSBENCH_WRITE_ERROR) {
+                printf("pub %d: write failed\n", writerArgs[w]->id);
+                break;
+            }
+            ddsbench_wheelPush(&wheel, w, now);
+            writes++;
+        }
+        if (numWriters && due == numWriters) {
+            waitNs = 0;
+        } else if (!numWriters || waitNs > NS_IN_ONE_SEC) {
+            waitNs = NS_IN_ONE_SEC;
+        }
+
+        /* Wait for data until the next writer is due, then take what the readers have */
+        if (waitNs) {
+            if (waitSet) {
+                ops->waitAny(waitSet, waitNs);
+            } else if (numReaders == 1) {
+                ops->wait(readers[0], waitNs);
+            } else {
+                sleepNs(numReaders && waitNs > WORKER_POLL_NS ? WORKER_POLL_NS : waitNs);
+            }
+        }
+        for (taken = 0, w = 0; w < numReaders; w++) {
+            if (takeAll(ops, readerArgs[w], readers[w], samples)) {
+                taken++;
+            }
+        }
+        if (taken) {
+            wakeups++;
+            takes += taken;
+        }
+
+        now = ddsbench_time();
+        if (now - intervalStart >= NS_IN_ONE_SEC) {
+            printf("worker %d: %llu bursts, %llu wakeups, %llu takes\n", worker->id, writes, wakeups, takes);
+            intervalStart = now;
+            writes = wakeups = takes = 0;
+        }
+    }
+
+    /* The window the readers received in, from which a launcher computes the rate */
+    for (w = 0; w < worker->count; w++) {
+        worker->args[w]->result.measureNs = now - start;
+    }
+    if (rc != DDSBENCH_WRITE_ERROR) {
+        result = EXIT_SUCCESS;
+    }
+
+cleanup:
+    ddsbench_wheelFree(&wheel);
+    if (waitSet) {
+        ops->waitSetFree(waitSet);
+    }
+    for (w = 0; w < numWriters; w++) {
+        ops->writerFree(writers[w]);
+    }
+    for (w = 0; w < numReaders; w++) {
+        ops->readerFree(readers[w]);
+    }
+    ddsbench_payloadFree(&payloads);
+error:
+    free(writerArgs);
+    free(readerArgs);
+    free(writers);
+    free(readers);
+
+    return result;
+}
@@ -0,0 +1,323 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include "core.h"
+
+/* A filter expression is compiled into a flat list of terms. Terms joined by
+ * AND form a group, groups are joined by OR. Each term stores the index of the
+ * first term of the next group, so a failing term skips the rest of its group
+ * without reevaluating anything. */
+typedef enum ddsbench_operator {
+    OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE
+} ddsbench_operator;
+
+typedef struct ddsbench_term {
+    ddsbench_filterField field;
+    ddsbench_operator op;
+    long long value;
+    int last;   /* Last term of its AND group */
+    int next;   /* First term of the next OR group */
+} ddsbench_term;
+
+struct ddsbench_predicate {
+    int count;
+    ddsbench_term terms[];
+};
+
+static const char *fieldNames[DDSBENCH_FIELD_MAX] = {"id", "filter", "count"};
+
+/* Longest term of a generated expression, the redundant terms compare with
+ * at most 9 + 255 */
+#define DDSBENCH_TERM_SIZE sizeof("filter <> 264 AND ")
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+static const char* skipSpace(const char *ptr)
+{
+    while (isspace((unsigned char)*ptr)) ptr++;
+    return ptr;
+}
+
+static int matchKeyword(const char *ptr, const char *keyword)
+{
+    size_t len = strlen(keyword);
+    return !strncasecmp(ptr, keyword, len) && !isalnum((unsigned char)ptr[len]) && ptr[len] != '_';
+}
+
+ddsbench_predicate* ddsbench_predicateCompile(const char *expr)
+{
+    ddsbench_predicate *result;
+    const char *ptr = expr;
+    int i, group = 0, maxTerms = 1;
+
+    /* Terms are separated by a keyword followed by whitespace, so this bounds
+     * the number of terms */
+    for (ptr = expr; *ptr; ptr++) {
+        if (isspace((unsigned char)*ptr)) maxTerms++;
+    }
+
+    result = malloc(sizeof(ddsbench_predicate) + maxTerms * sizeof(ddsbench_term));
+    if (!result) throw("out of memory\n");
+    result->count = 0;
+
+    ptr = skipSpace(expr);
+    if (!*ptr) throw("empty filter expression\n");
+
+    while (*ptr) {
+        ddsbench_term *term = &result->terms[result->count];
+        char *end;
+        int f;
+
+        /* Field */
+        for (f = 0; f < DDSBENCH_FIELD_MAX; f++) {
+            if (matchKeyword(ptr, fieldNames[f])) break;
+        }
+        if (f == DDSBENCH_FIELD_MAX) throw("unknown field in filter at '%s'\n", ptr);
+        term->field = f;
+        ptr = skipSpace(ptr + strlen(fieldNames[f]));
+
+        /* Operator */
+        if (!strncmp(ptr, "<>", 2) || !strncmp(ptr, "!=", 2)) term->op = OP_NE, ptr += 2;
+        else if (!strncmp(ptr, "<=", 2)) term->op = OP_LE, ptr += 2;
+        else if (!strncmp(ptr, ">=", 2)) term->op = OP_GE, ptr += 2;
+        else if (*ptr == '<') term->op = OP_LT, ptr++;
+        else if (*ptr == '>') term->op = OP_GT, ptr++;
+        else if (*ptr == '=') term->op = OP_EQ, ptr++;
+        else throw("invalid operator in filter at '%s'\n", ptr);
+
+        /* Value */
+        ptr = skipSpace(ptr);
+        term->value = strtoll(ptr, &end, 10);
+        if (end == ptr) throw("expected a number in filter at '%s'\n", ptr);
+        ptr = skipSpace(end);
+
+        term->last = 0;
+        result->count++;
+
+        /* Conjunction */
+        if (matchKeyword(ptr, "and")) {
+            ptr = skipSpace(ptr + 3);
+        } else if (matchKeyword(ptr, "or")) {
+            term->last = 1;
+            ptr = skipSpace(ptr + 2);
+        } else if (*ptr) {
+            throw("expected AND or OR in filter at '%s'\n", ptr);
+        } else {
+            term->last = 1;
+            break;
+        }
+
+        if (!*ptr) throw("filter expression '%s' ends with a conjunction\n", expr);
+    }
+
+    /* Link every term to the start of the next group */
+    for (i = 0; i < result->count; i++) {
+        if (result->terms[i].last) {
+            for (; group <= i; group++) {
+                result->terms[group].next = i + 1;
+            }
+        }
+    }
+
+    return result;
+error:
+    free(result);
+    return NULL;
+}
+
+void ddsbench_predicateFree(ddsbench_predicate *predicate)
+{
+    free(predicate);
+}
+
+int ddsbench_predicateEval(const ddsbench_predicate *predicate, const long long *fields)
+{
+    const ddsbench_term *term;
+    int i = 0, match;
+
+    while (i < predicate->count) {
+        term = &predicate->terms[i];
+        long long v = fields[term->field];
+        switch (term->op) {
+        case OP_EQ: match = v == term->value; break;
+        case OP_NE: match = v != term->value; break;
+        case OP_LT: match = v < term->value; break;
+        case OP_LE: match = v <= term->value; break;
+        case OP_GT: match = v > term->value; break;
+        default: match = v >= term->value; break;
+        }
+        if (match) {
+            if (term->last) return 1;
+            i++;
+        } else {
+            i = term->next;
+        }
+    }
+
+    return 0;
+}
+
+/* Aggregated results of a single filter trial */
+typedef struct ddsbench_filterTrial {
+    int terms;
+    int selectivity;
+    const char *where;
+    unsigned long long written;
+    unsigned long long accepted;
+    unsigned long long evaluated;
+    unsigned long long filterNs;
+    unsigned long long cpuNs;
+} ddsbench_filterTrial;
+
+/* The middleware names the content filtered topic of a trial */
+static int startTrial(ddsbench_sweep *sweep, const char *topicname, void *trial)
+{
+    snprintf(sweep->ctx->filtername, sizeof(sweep->ctx->filtername), "%s_filter", topicname);
+    return 0;
+}
+
+static void collectTrial(ddsbench_sweep *sweep, ddsbench_threadArg *args, int count, void *trial)
+{
+    ddsbench_filterTrial *t = trial;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        if (args[i].role == DDSBENCH_PUBLISHER) {
+            t->written += r->samples;
+            /* Publishers measure process CPU over (nearly) the same window */
+            if (r->cpuNs > t->cpuNs) t->cpuNs = r->cpuNs;
+        } else {
+            t->accepted += r->samples;
+            t->evaluated += r->evaluated;
+            t->filterNs += r->filterNs;
+        }
+    }
+
+    /* Without a local predicate every written sample is evaluated once by the
+     * middleware for every subscriber */
+    if (!sweep->ctx->localfilter) {
+        t->evaluated = t->written * ddsbench_numsub;
+    }
+}
+
+static double perSample(unsigned long long ns, unsigned long long samples)
+{
+    return samples ? (double)ns / samples : 0;
+}
+
+/* The delta is the cost over the first trial, the baseline without filter */
+static void printTrial(ddsbench_sweep *sweep, void *trial)
+{
+    ddsbench_filterTrial *t = trial, *base = ddsbench_sweepTrial(sweep, 0);
+    double baseline = perSample(base->cpuNs, base->evaluated);
+    char terms[16], selectivity[16], eval[16];
+    double cpu = perSample(t->cpuNs, t->evaluated);
+
+    if (t->terms) sprintf(terms, "%d", t->terms); else strcpy(terms, "-");
+    if (t->selectivity >= 0) sprintf(selectivity, "%d%%", t->selectivity); else strcpy(selectivity, "-");
+    if (t->filterNs) sprintf(eval, "%.1f", perSample(t->filterNs, t->evaluated)); else strcpy(eval, "-");
+
+    printf("filter: %5s %6s %-6s %11llu %11llu %10.1f %10.1f %8s\n",
+        terms, selectivity, t->where, t->written, t->accepted, cpu,
+        t->where[0] == '-' ? 0.0 : cpu - baseline, eval);
+}
+
+static void printHeader(ddsbench_sweep *sweep)
+{
+    printf("\n");
+    printf("Filter cost (CPU ns per evaluated sample)\n");
+    printf("filter: %5s %6s %-6s %11s %11s %10s %10s %8s\n",
+        "terms", "select", "where", "written", "accepted", "cpu", "delta", "eval");
+}
+
+static const ddsbench_sweepMode filterSweep = {
+    sizeof(ddsbench_filterTrial), startTrial, NULL, collectTrial, printHeader, printTrial
+};
+
+int ddsbench_runFilter(ddsbench_libraryInterface *interface, ddsbench_context *ctx)
+{
+    int selectivity[DDSBENCH_MAX_SWEEP], complexity[DDSBENCH_MAX_SWEEP];
+    int numSelectivity = 1, numComplexity = 1, maxComplexity = 1, s, c, w;
+    ddsbench_filterTrial *t;
+    ddsbench_sweep sweep = {0};
+    char *custom = ctx->filter;
+    char *expr = NULL;
+    size_t size;
+
+    /* A user provided filter replaces the generated sweep */
+    if (!custom) {
+        if ((numSelectivity = ddsbench_parseList(ddsbench_selectivity, selectivity, DDSBENCH_MAX_SWEEP)) < 0) goto error;
+        if ((numComplexity = ddsbench_parseList(ddsbench_complexity, complexity, DDSBENCH_MAX_SWEEP)) < 0) goto error;
+        for (c = 0; c < numComplexity; c++) {
+            if (complexity[c] < 1 || complexity[c] > 256) throw("complexity must be between 1 and 256\n");
+            if (complexity[c] > maxComplexity) maxComplexity = complexity[c];
+        }
+    }
+
+    size = custom ? strlen(custom) + 1 : maxComplexity * DDSBENCH_TERM_SIZE;
+    if (!(expr = malloc(size))) throw("out of memory\n");
+    if (ddsbench_sweepInit(&sweep, &filterSweep, interface, ctx, 1 + numSelectivity * numComplexity * 2)) goto error;
+
+    /* Baseline without any filtering */
+    ctx->filter = NULL;
+    ctx->predicate = NULL;
+    ctx->localfilter = 0;
+    t = ddsbench_sweepTrial(&sweep, 0);
+    t->terms = 0;
+    t->selectivity = -1;
+    t->where = "-";
+    if (ddsbench_sweepRun(&sweep)) goto error;
+
+    for (c = 0; c < numComplexity; c++) {
+        for (s = 0; s < numSelectivity; s++) {
+            if (custom) {
+                memcpy(expr, custom, size);
+            } else {
+                /* The filter field cycles through 0..9, so selectivity has a
+                 * granularity of 10%. Redundant terms that never fail precede
+                 * the selecting term so that every term gets evaluated. */
+                int threshold = (selectivity[s] + 5) / 10, term;
+                size_t length = 0;
+                for (term = 1; term < complexity[c]; term++) {
+                    length += snprintf(expr + length, size - length, "filter <> %d AND ", 9 + term);
+                }
+                snprintf(expr + length, size - length, "filter < %d", threshold);
+            }
+
+            if (!(ctx->predicate = ddsbench_predicateCompile(expr))) goto error;
+            ctx->filter = expr;
+
+            /* Products without content filters are measured filtering locally only */
+            w = interface->plugin->capabilities & DDSBENCH_CAP_FILTERS ? 0 : 1;
+            for (; w < 2; w++) {
+                t = ddsbench_sweepTrial(&sweep, sweep.count);
+                t->terms = custom ? 0 : complexity[c];
+                t->selectivity = custom ? -1 : ((selectivity[s] + 5) / 10) * 10;
+                t->where = w ? "local" : "dds";
+                ctx->localfilter = w;
+                if (ddsbench_sweepRun(&sweep)) goto error;
+            }
+
+            ddsbench_predicateFree(ctx->predicate);
+            ctx->predicate = NULL;
+        }
+    }
+
+    ddsbench_sweepPrint(&sweep);
+
+    ctx->filter = custom;
+    free(expr);
+    ddsbench_sweepFini(&sweep);
+    return 0;
+error:
+    ctx->filter = custom;
+    free(expr);
+    ddsbench_sweepFini(&sweep);
+    return -1;
+}
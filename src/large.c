@@ -0,0 +1,124 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+/* Serialized size of a throughput sample without payload: CDR encapsulation
+ * header, id, filter, count and the sequence length */
+#define DDSBENCH_SAMPLE_OVERHEAD 24
+
+/* Largest payload of the generated sweep */
+#define DDSBENCH_LARGE_MAX (64 * 1024 * 1024)
+
+/* Aggregated results of a single large payload trial */
+typedef struct ddsbench_largeTrial {
+    int payload;
+    int fragments;
+    unsigned long long written;
+    unsigned long long received;
+    unsigned long long bytes;
+    ddsbench_histogram latencyNs;
+} ddsbench_largeTrial;
+
+/* Number of DDSI fragments a sample with this payload is sent in */
+static int fragments(int payload)
+{
+    long long size = (long long)payload + DDSBENCH_SAMPLE_OVERHEAD;
+    if (size <= ddsbench_fragmentsize) {
+        return 1;
+    }
+    return (size + ddsbench_fragmentsize - 1) / ddsbench_fragmentsize;
+}
+
+static void collectTrial(ddsbench_sweep *sweep, ddsbench_threadArg *args, int count, void *trial)
+{
+    ddsbench_largeTrial *t = trial;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        if (args[i].role == DDSBENCH_PUBLISHER) {
+            t->written += r->samples;
+        } else {
+            t->received += r->samples;
+            t->bytes += r->bytes;
+            ddsbench_histogramMerge(&t->latencyNs, &r->latencyNs);
+        }
+    }
+}
+
+static void printTrial(ddsbench_sweep *sweep, void *trial)
+{
+    ddsbench_largeTrial *t = trial;
+    unsigned int duration = sweep->ctx->duration;
+    ddsbench_histogram *h = &t->latencyNs;
+
+    printf("large: %9d %9d %9llu %9llu %10.1f %9.1f %10.1f %10.1f %10.1f\n",
+        t->payload, t->fragments, t->written, t->received,
+        duration ? (double)t->received / duration : 0,
+        duration ? (double)t->bytes / duration / 1000000.0 : 0,
+        ddsbench_histogramQuantile(h, 0.5) / 1000.0,
+        ddsbench_histogramQuantile(h, 0.99) / 1000.0,
+        h->maxNs / 1000.0);
+}
+
+static void printHeader(ddsbench_sweep *sweep)
+{
+    printf("\n");
+    printf("Large payloads (fragment size %d bytes, latency from source timestamp in us)\n", ddsbench_fragmentsize);
+    printf("large: %9s %9s %9s %9s %10s %9s %10s %10s %10s\n",
+        "payload", "fragments", "written", "received", "samples/s", "MB/s", "p50", "p99", "max");
+}
+
+static const ddsbench_sweepMode largeSweep = {
+    sizeof(ddsbench_largeTrial), NULL, NULL, collectTrial, printHeader, printTrial
+};
+
+int ddsbench_runLarge(ddsbench_libraryInterface *interface, ddsbench_context *ctx)
+{
+    int payload[DDSBENCH_MAX_SWEEP];
+    int numPayload = 0, p;
+    unsigned int payloadDefault = ctx->payload;
+    ddsbench_sweep sweep = {0};
+
+    if (ddsbench_payloads) {
+        if ((numPayload = ddsbench_parseList(ddsbench_payloads, payload, DDSBENCH_MAX_SWEEP)) < 0) goto error;
+    } else {
+        /* Payloads that exactly fill a multiple of the fragment size, and one
+         * byte more, which requires an extra fragment */
+        long long k;
+        if (ddsbench_fragmentsize <= DDSBENCH_SAMPLE_OVERHEAD) throw("fragment size is too small\n");
+        for (k = 1; k * ddsbench_fragmentsize <= DDSBENCH_LARGE_MAX && numPayload + 2 <= DDSBENCH_MAX_SWEEP; k *= 2) {
+            payload[numPayload++] = k * ddsbench_fragmentsize - DDSBENCH_SAMPLE_OVERHEAD;
+            payload[numPayload++] = k * ddsbench_fragmentsize - DDSBENCH_SAMPLE_OVERHEAD + 1;
+        }
+    }
+
+    if (ddsbench_sweepInit(&sweep, &largeSweep, interface, ctx, numPayload)) goto error;
+
+    for (p = 0; p < numPayload; p++) {
+        ddsbench_largeTrial *t = ddsbench_sweepTrial(&sweep, p);
+        if (payload[p] <= 0) throw("invalid payload size %d\n", payload[p]);
+        ctx->payload = payload[p];
+        t->payload = payload[p];
+        t->fragments = fragments(payload[p]);
+        if (ddsbench_sweepRun(&sweep)) goto error;
+    }
+
+    if (ddsbench_numsub) {
+        ddsbench_sweepPrint(&sweep);
+    }
+
+    ctx->payload = payloadDefault;
+    ddsbench_sweepFini(&sweep);
+    return 0;
+error:
+    ctx->payload = payloadDefault;
+    ddsbench_sweepFini(&sweep);
+    return -1;
+}
@@ -0,0 +1,743 @@
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "core.h"
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+/* Environment variable that tells a launched process where to send results */
+#define DDSBENCH_LAUNCH_ENV "DDSBENCH_LAUNCH_FD"
+
+int ddsbench_launch = 0;
+int ddsbench_pubprocs = -1;
+int ddsbench_subprocs = -1;
+char *ddsbench_proccpus = NULL;
+int ddsbench_compare = 0;
+
+/* Records a launched process writes to its result pipe */
+typedef enum ddsbench_launchType {
+    DDSBENCH_LAUNCH_PROGRESS,       /* Samples written and received so far, every second */
+    DDSBENCH_LAUNCH_THREAD          /* Result of a thread, followed by its ddsbench_threadResult */
+} ddsbench_launchType;
+
+typedef struct ddsbench_launchRecord {
+    ddsbench_launchType type;
+    ddsbench_role role;
+    int id;
+    unsigned long long written;
+    unsigned long long received;
+    unsigned long long bytes;
+} ddsbench_launchRecord;
+
+/* A process started by the launcher */
+typedef struct launchProc {
+    pid_t pid;
+    char label[32];
+    int out;                        /* Output of the process, -1 when closed */
+    int results;                    /* Result pipe, -1 when closed */
+    char line[1024];                /* Output that is not terminated by a newline yet */
+    int length;
+    ddsbench_launchRecord progress;
+    int threads;
+    unsigned long long written;
+    unsigned long long received;
+    unsigned long long bytes;
+    unsigned long long cpuNs;
+    int status;
+} launchProc;
+
+/* Results of one layout, all processes together */
+typedef struct launchRun {
+    const char *layout;
+    launchProc *procs;
+    int count;
+    unsigned long long written;
+    unsigned long long received;
+    unsigned long long bytes;
+    unsigned long long cpuNs;
+    double rate;                    /* Samples received per second, summed over the subscribers */
+    double mbits;                   /* Mbit received per second, summed over the subscribers */
+    ddsbench_histogram latencyNs;
+    ddsbench_histogram roundTripNs;
+    int failed;
+} launchRun;
+
+/*
+ * Launched process side. Threads publish their progress in their (local)
+ * threadArg, a reporter thread sums them every second and writes a progress
+ * record. Threads move their slot when they swap the arg they run on, under
+ * the lock so that the reporter never reads an arg that is being freed.
+ */
+
+static int reportFd = -1;
+static pthread_mutex_t liveLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t liveCond = PTHREAD_COND_INITIALIZER;
+static ddsbench_threadArg **liveArgs = NULL;
+static int liveCount = 0;
+static int reporting = 0;
+static pthread_t reporter;
+
+static int writeFull(int fd, const void *buf, size_t size)
+{
+    const char *ptr = buf;
+    ssize_t n;
+
+    while (size) {
+        if ((n = write(fd, ptr, size)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        ptr += n;
+        size -= n;
+    }
+    return 0;
+}
+
+static int readFull(int fd, void *buf, size_t size)
+{
+    char *ptr = buf;
+    ssize_t n;
+
+    while (size) {
+        if ((n = read(fd, ptr, size)) <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        ptr += n;
+        size -= n;
+    }
+    return 0;
+}
+
+int ddsbench_launchChild(void)
+{
+    const char *fd = getenv(DDSBENCH_LAUNCH_ENV);
+
+    if (fd) {
+        reportFd = atoi(fd);
+
+        /* The launcher forwards output line by line, and may exit first */
+        setvbuf(stdout, NULL, _IOLBF, 0);
+        signal(SIGPIPE, SIG_IGN);
+    }
+
+    return reportFd >= 0;
+}
+
+static void* reportMain(void *ptr)
+{
+    ddsbench_launchRecord record;
+    struct timespec deadline;
+    int i;
+
+    (void)ptr;
+    ddsbench_allocIgnore();
+    memset(&record, 0, sizeof(record));
+    record.type = DDSBENCH_LAUNCH_PROGRESS;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    pthread_mutex_lock(&liveLock);
+    while (reporting) {
+        deadline.tv_sec++;
+        pthread_cond_timedwait(&liveCond, &liveLock, &deadline);
+
+        /* Counters are read while threads update them, which is good enough for progress */
+        record.written = record.received = record.bytes = 0;
+        for (i = 0; i < liveCount; i++) {
+            ddsbench_threadResult *r = &liveArgs[i]->result;
+            if (liveArgs[i]->role == DDSBENCH_PUBLISHER) {
+                record.written += r->samples;
+            } else {
+                record.received += r->samples;
+                record.bytes += r->bytes;
+            }
+        }
+
+        pthread_mutex_unlock(&liveLock);
+        writeFull(reportFd, &record, sizeof(record));
+        pthread_mutex_lock(&liveLock);
+    }
+    pthread_mutex_unlock(&liveLock);
+
+    return NULL;
+}
+
+void ddsbench_launchReportStart(ddsbench_threadArg **live, int count)
+{
+    if (reportFd < 0) {
+        return;
+    }
+
+    liveArgs = live;
+    liveCount = count;
+    reporting = 1;
+    if (pthread_create(&reporter, NULL, reportMain, NULL)) {
+        printf("ddsbench: failed to start progress reporter: %s\n", strerror(errno));
+        reporting = 0;
+    }
+}
+
+void ddsbench_launchReportStop(void)
+{
+    pthread_mutex_lock(&liveLock);
+    if (!reporting) {
+        pthread_mutex_unlock(&liveLock);
+        return;
+    }
+    reporting = 0;
+    pthread_cond_broadcast(&liveCond);
+    pthread_mutex_unlock(&liveLock);
+
+    pthread_join(reporter, NULL);
+    liveArgs = NULL;
+    liveCount = 0;
+}
+
+void ddsbench_launchMove(ddsbench_threadArg **slot, ddsbench_threadArg *arg)
+{
+    pthread_mutex_lock(&liveLock);
+    *slot = arg;
+    pthread_mutex_unlock(&liveLock);
+}
+
+void ddsbench_launchResults(ddsbench_threadArg *args, int count)
+{
+    ddsbench_launchRecord record;
+    int i;
+
+    if (reportFd < 0) {
+        return;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.type = DDSBENCH_LAUNCH_THREAD;
+    for (i = 0; i < count; i++) {
+        record.role = args[i].role;
+        record.id = args[i].id;
+        if (writeFull(reportFd, &record, sizeof(record)) ||
+            writeFull(reportFd, &args[i].result, sizeof(ddsbench_threadResult)))
+        {
+            printf("ddsbench: failed to send results to launcher: %s\n", strerror(errno));
+            return;
+        }
+    }
+}
+
+/*
+ * Launcher side. Processes run in their own process group, so that an
+ * interrupt reaches the launcher only, which forwards it once to every
+ * process and then collects what they report.
+ */
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onInterrupt(int sig)
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+/* Copy the options of the launcher, except the ones that are set per process
+ * or only apply to the launcher */
+static int childOptions(int argc, char *argv[], char **out)
+{
+    static const char *perProcess[] = {
+        "--numpub", "--numsub", "--pubid", "--subid", "--readers", "--writers", "--cpus",
+        "--pubprocs", "--subprocs", "--proccpus", "--rounds", "--repeats", NULL
+    };
+    int i, j, count = 0;
+
+    out[count++] = "ddsbench";
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "launch") || !strcmp(argv[i], "tune") || !strcmp(argv[i], "--compare")) {
+            continue;
+        }
+        for (j = 0; perProcess[j] && strcmp(argv[i], perProcess[j]); j++);
+        if (perProcess[j]) {
+            i++;
+            continue;
+        }
+        out[count++] = argv[i];
+    }
+
+    return count;
+}
+
+static int spawn(launchProc *proc, char **args, int count, unsigned int numpub, unsigned int numsub,
+    unsigned int pubid, unsigned int subid, const ddsbench_context *ctx, const char *cpus, char **env)
+{
+    char values[6][16], fd[16];
+    int out[2] = {-1, -1}, results[2] = {-1, -1};
+
+    sprintf(values[0], "%u", numpub);
+    sprintf(values[1], "%u", numsub);
+    sprintf(values[2], "%u", pubid);
+    sprintf(values[3], "%u", subid);
+    sprintf(values[4], "%u", ctx->readers);
+    sprintf(values[5], "%u", ctx->writers);
+    args[count++] = "--numpub"; args[count++] = values[0];
+    args[count++] = "--numsub"; args[count++] = values[1];
+    args[count++] = "--pubid"; args[count++] = values[2];
+    args[count++] = "--subid"; args[count++] = values[3];
+    args[count++] = "--readers"; args[count++] = values[4];
+    args[count++] = "--writers"; args[count++] = values[5];
+    if (cpus) {
+        args[count++] = "--cpus";
+        args[count++] = (char*)cpus;
+    }
+    args[count] = NULL;
+
+    /* Pipes are not inherited by the other processes */
+    if (pipe2(out, O_CLOEXEC) || pipe2(results, O_CLOEXEC)) {
+        throw("failed to create pipe: %s\n", strerror(errno));
+    }
+
+    fflush(stdout);
+    if ((proc->pid = fork()) < 0) {
+        throw("failed to fork: %s\n", strerror(errno));
+    }
+
+    if (!proc->pid) {
+        setpgid(0, 0);
+        dup2(out[1], STDOUT_FILENO);
+        dup2(out[1], STDERR_FILENO);
+        fcntl(results[1], F_SETFD, 0);
+        sprintf(fd, "%d", results[1]);
+        setenv(DDSBENCH_LAUNCH_ENV, fd, 1);
+        for (; env && *env; env++) {
+            putenv(*env);
+        }
+        execv("/proc/self/exe", args);
+        printf("error: failed to start ddsbench: %s\n", strerror(errno));
+        _exit(127);
+    }
+
+    close(out[1]);
+    close(results[1]);
+    proc->out = out[0];
+    proc->results = results[0];
+    proc->status = -1;
+
+    printf("launch: started %s (pid %d)\n", proc->label, (int)proc->pid);
+
+    return 0;
+error:
+    if (out[0] >= 0) { close(out[0]); close(out[1]); }
+    if (results[0] >= 0) { close(results[0]); close(results[1]); }
+    return -1;
+}
+
+/* Forward complete lines of output, prefixed with the process */
+static void readOutput(launchProc *proc)
+{
+    char buf[4096];
+    ssize_t n, i;
+
+    if ((n = read(proc->out, buf, sizeof(buf))) < 0 && errno == EINTR) {
+        return;
+    }
+    if (n <= 0) {
+        if (proc->length) {
+            printf("[%s] %.*s\n", proc->label, proc->length, proc->line);
+            proc->length = 0;
+        }
+        close(proc->out);
+        proc->out = -1;
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (buf[i] != '\n') {
+            proc->line[proc->length++] = buf[i];
+        }
+        if (buf[i] == '\n' || proc->length == sizeof(proc->line)) {
+            printf("[%s] %.*s\n", proc->label, proc->length, proc->line);
+            proc->length = 0;
+        }
+    }
+}
+
+static void readResult(launchRun *run, launchProc *proc)
+{
+    ddsbench_launchRecord record;
+    ddsbench_threadResult result;
+
+    if (readFull(proc->results, &record, sizeof(record))) {
+        close(proc->results);
+        proc->results = -1;
+        return;
+    }
+
+    if (record.type == DDSBENCH_LAUNCH_PROGRESS) {
+        proc->progress = record;
+    } else if (record.type == DDSBENCH_LAUNCH_THREAD) {
+        if (readFull(proc->results, &result, sizeof(result))) {
+            close(proc->results);
+            proc->results = -1;
+            return;
+        }
+        proc->threads++;
+        proc->cpuNs += result.threadCpuNs;
+        if (record.role == DDSBENCH_PUBLISHER) {
+            proc->written += result.samples;
+        } else {
+            proc->received += result.samples;
+            proc->bytes += result.bytes;
+
+            /* Every subscriber received in its own window, from the start
+             * barrier until it stopped */
+            if (result.measureNs) {
+                run->rate += result.samples / (result.measureNs / 1000000000.0);
+                run->mbits += result.bytes * 8.0 / (result.measureNs / 1000.0);
+            }
+        }
+        ddsbench_histogramMerge(&run->latencyNs, &result.latencyNs);
+        ddsbench_histogramMerge(&run->roundTripNs, &result.roundTripNs);
+    }
+}
+
+/* Collect output and results until all processes closed their pipes, and
+ * report the progress of all processes together every second */
+static int collect(launchRun *run)
+{
+    struct pollfd *fds = malloc(2 * run->count * sizeof(struct pollfd));
+    launchProc **owners = malloc(2 * run->count * sizeof(launchProc*));
+    unsigned long long start = ddsbench_time(), tick = start + 1000000000ULL, now, prevNs = start;
+    unsigned long long prevReceived = 0, prevBytes = 0;
+    int forwarded = 0, open, i, n;
+
+    if (!fds || !owners) throw("out of memory\n");
+
+    for (;;) {
+        for (open = 0, i = 0; i < run->count; i++) {
+            if (run->procs[i].out >= 0) {
+                fds[open].fd = run->procs[i].out;
+                fds[open].events = POLLIN;
+                owners[open++] = &run->procs[i];
+            }
+            if (run->procs[i].results >= 0) {
+                fds[open].fd = run->procs[i].results;
+                fds[open].events = POLLIN;
+                owners[open++] = &run->procs[i];
+            }
+        }
+        if (!open) {
+            break;
+        }
+
+        now = ddsbench_time();
+        n = poll(fds, open, tick > now ? (tick - now) / 1000000 + 1 : 0);
+        if (n < 0 && errno != EINTR) throw("poll failed: %s\n", strerror(errno));
+
+        for (i = 0; n > 0 && i < open; i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            if (fds[i].fd == owners[i]->out) {
+                readOutput(owners[i]);
+            } else {
+                readResult(run, owners[i]);
+            }
+        }
+
+        if (interrupted && !forwarded) {
+            for (i = 0; i < run->count; i++) {
+                kill(run->procs[i].pid, SIGINT);
+            }
+            forwarded = 1;
+        }
+
+        now = ddsbench_time();
+        if (now >= tick) {
+            unsigned long long written = 0, received = 0, bytes = 0;
+            double delta = (now - prevNs) / 1000000000.0;
+
+            for (i = 0; i < run->count; i++) {
+                written += run->procs[i].progress.written;
+                received += run->procs[i].progress.received;
+                bytes += run->procs[i].progress.bytes;
+            }
+            if (written || received) {
+                printf("launch: %4llus %11llu written %11llu received %9.2fK samples/s %9.2f Mbit/s\n",
+                    (now - start) / 1000000000ULL, written, received,
+                    (received - prevReceived) / delta / 1000.0,
+                    (bytes - prevBytes) * 8.0 / delta / 1000000.0);
+            }
+
+            prevNs = now;
+            prevReceived = received;
+            prevBytes = bytes;
+            while (tick <= now) {
+                tick += 1000000000ULL;
+            }
+        }
+    }
+
+    free(fds);
+    free(owners);
+    return 0;
+error:
+    free(fds);
+    free(owners);
+    return -1;
+}
+
+static void printRun(launchRun *run)
+{
+    unsigned long long p50 = ddsbench_histogramQuantile(&run->latencyNs, 0.5);
+    unsigned long long p99 = ddsbench_histogramQuantile(&run->latencyNs, 0.99);
+    int i;
+
+    printf("\n");
+    printf("Launch results (%s, %d processes)\n", run->layout, run->count);
+    printf("launch: %-12s %7s %7s %11s %11s %10s %10s %6s\n",
+        "process", "pid", "threads", "written", "received", "MB", "cpu[ms]", "exit");
+    for (i = 0; i < run->count; i++) {
+        launchProc *proc = &run->procs[i];
+        printf("launch: %-12s %7d %7d %11llu %11llu %10.2f %10.1f %6d\n",
+            proc->label, (int)proc->pid, proc->threads, proc->written, proc->received,
+            proc->bytes / 1048576.0, proc->cpuNs / 1000000.0, proc->status);
+    }
+    printf("launch: %-12s %7s %7s %11llu %11llu %10.2f %10.1f\n",
+        "total", "", "", run->written, run->received, run->bytes / 1048576.0, run->cpuNs / 1000000.0);
+
+    if (run->rate > 0) {
+        printf("launch: received %.2fK samples/s, %.2f Mbit/s, %.2f us cpu/sample\n",
+            run->rate / 1000.0, run->mbits,
+            run->written + run->received ? (double)run->cpuNs / (run->written + run->received) / 1000.0 : 0);
+    }
+    if (run->latencyNs.count) {
+        printf("launch: latency p50 %.1f us, p99 %.1f us, max %.1f us\n",
+            p50 / 1000.0, p99 / 1000.0, run->latencyNs.maxNs / 1000.0);
+    }
+    if (run->roundTripNs.count) {
+        printf("launch: round trip p50 %.1f us, p99 %.1f us, max %.1f us\n",
+            ddsbench_histogramQuantile(&run->roundTripNs, 0.5) / 1000.0,
+            ddsbench_histogramQuantile(&run->roundTripNs, 0.99) / 1000.0, run->roundTripNs.maxNs / 1000.0);
+    }
+}
+
+/* Start the processes of a layout, collect their results and wait for them */
+static int runLayout(launchRun *run, ddsbench_context *ctx, int argc, char *argv[], int split, char **env)
+{
+    char **args = malloc((argc + 16) * sizeof(char*));
+    char *cpus[DDSBENCH_MAX_PROCS];
+    char *sets = NULL, *ptr;
+    int options, numcpus = 0, started = 0, i;
+    unsigned int id;
+
+    memset(run, 0, sizeof(*run));
+    run->layout = split ? "inter-process" : "intra-process";
+    run->count = split ? ddsbench_subprocs + ddsbench_pubprocs : 1;
+    run->procs = calloc(run->count, sizeof(launchProc));
+    if (!args || !run->procs) throw("out of memory\n");
+    options = childOptions(argc, argv, args);
+
+    /* Processes are pinned to the sets of --proccpus round-robin, or all to --cpus */
+    if (split && ddsbench_proccpus) {
+        if (!(sets = strdup(ddsbench_proccpus))) throw("out of memory\n");
+        for (ptr = strtok(sets, "/"); ptr && numcpus < DDSBENCH_MAX_PROCS; ptr = strtok(NULL, "/")) {
+            cpus[numcpus++] = ptr;
+        }
+        if (!numcpus) throw("invalid value for --proccpus: %s\n", ddsbench_proccpus);
+    } else if (ddsbench_cpus) {
+        cpus[numcpus++] = ddsbench_cpus;
+    }
+
+    printf("\n");
+    printf("launch: starting %s run\n", run->layout);
+
+    if (!split) {
+        launchProc *proc = &run->procs[0];
+        strcpy(proc->label, "intra");
+        if (spawn(proc, args, options, ddsbench_numpub, ddsbench_numsub, ctx->pubid, ctx->subid, ctx,
+                numcpus ? cpus[0] : NULL, env))
+        {
+            goto error;
+        }
+        started++;
+    } else {
+        /* Subscribers first, like the threads of a process, and spread the
+         * endpoints evenly over the processes of their role */
+        for (i = 0, id = ctx->subid; i < ddsbench_subprocs; i++) {
+            launchProc *proc = &run->procs[started];
+            unsigned int n = ddsbench_numsub / ddsbench_subprocs + (i < (int)(ddsbench_numsub % ddsbench_subprocs));
+            if (n > 1) {
+                sprintf(proc->label, "sub %u-%u", id, id + n - 1);
+            } else {
+                sprintf(proc->label, "sub %u", id);
+            }
+            if (spawn(proc, args, options, 0, n, ctx->pubid, id, ctx, numcpus ? cpus[started % numcpus] : NULL, env)) {
+                goto error;
+            }
+            started++;
+            id += n;
+        }
+        for (i = 0, id = ctx->pubid; i < ddsbench_pubprocs; i++) {
+            launchProc *proc = &run->procs[started];
+            unsigned int n = ddsbench_numpub / ddsbench_pubprocs + (i < (int)(ddsbench_numpub % ddsbench_pubprocs));
+            if (n > 1) {
+                sprintf(proc->label, "pub %u-%u", id, id + n - 1);
+            } else {
+                sprintf(proc->label, "pub %u", id);
+            }
+            if (spawn(proc, args, options, n, 0, id, ctx->subid, ctx, numcpus ? cpus[started % numcpus] : NULL, env)) {
+                goto error;
+            }
+            started++;
+            id += n;
+        }
+    }
+
+    if (collect(run)) {
+        goto error;
+    }
+
+    for (i = 0; i < run->count; i++) {
+        launchProc *proc = &run->procs[i];
+        int status;
+        if (waitpid(proc->pid, &status, 0) < 0) {
+            printf("launch: failed to wait for %s: %s\n", proc->label, strerror(errno));
+            run->failed++;
+            continue;
+        }
+        proc->status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        if (proc->status) {
+            printf("launch: %s exited with status %d\n", proc->label, proc->status);
+            run->failed++;
+        }
+        run->written += proc->written;
+        run->received += proc->received;
+        run->bytes += proc->bytes;
+        run->cpuNs += proc->cpuNs;
+    }
+
+    printRun(run);
+
+    free(sets);
+    free(args);
+    return 0;
+error:
+    run->count = started;
+    for (i = 0; i < started; i++) {
+        kill(run->procs[i].pid, SIGINT);
+        waitpid(run->procs[i].pid, NULL, 0);
+        if (run->procs[i].out >= 0) close(run->procs[i].out);
+        if (run->procs[i].results >= 0) close(run->procs[i].results);
+    }
+    free(sets);
+    free(args);
+    return -1;
+}
+
+/* Report the two layouts side by side */
+static void printCompare(launchRun *runs, int count)
+{
+    int i;
+
+    printf("\n");
+    printf("Intra-process vs inter-process\n");
+    printf("launch: %-14s %9s %12s %10s %12s %10s %10s\n",
+        "layout", "processes", "samples/s", "Mbit/s", "cpu/sample", "p50[us]", "p99[us]");
+    for (i = 0; i < count; i++) {
+        launchRun *run = &runs[i];
+        unsigned long long samples = run->written + run->received;
+        printf("launch: %-14s %9d %11.2fK %10.2f %9.2f us %10.1f %10.1f\n",
+            run->layout, run->count, run->rate / 1000.0, run->mbits,
+            samples ? (double)run->cpuNs / samples / 1000.0 : 0,
+            run->latencyNs.count ? ddsbench_histogramQuantile(&run->latencyNs, 0.5) / 1000.0 : 0,
+            run->latencyNs.count ? ddsbench_histogramQuantile(&run->latencyNs, 0.99) / 1000.0 : 0);
+    }
+}
+
+int ddsbench_runLaunch(ddsbench_context *ctx, int argc, char *argv[])
+{
+    launchRun runs[2];
+    struct sigaction action, oldInt, oldTerm;
+    int count = 0, failed = 0, i;
+
+    memset(runs, 0, sizeof(runs));
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onInterrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &oldInt);
+    sigaction(SIGTERM, &action, &oldTerm);
+
+    /* The intra-process run goes first, so that both use a fresh domain */
+    if (ddsbench_compare) {
+        if (runLayout(&runs[count++], ctx, argc, argv, 0, NULL)) {
+            failed = 1;
+        }
+    }
+    if (!failed && !interrupted) {
+        if (runLayout(&runs[count++], ctx, argc, argv, 1, NULL)) {
+            failed = 1;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        failed |= runs[i].failed != 0;
+    }
+    if (!failed && ddsbench_compare && count == 2) {
+        printCompare(runs, count);
+    }
+
+    for (i = 0; i < count; i++) {
+        free(runs[i].procs);
+    }
+
+    sigaction(SIGINT, &oldInt, NULL);
+    sigaction(SIGTERM, &oldTerm, NULL);
+
+    return failed ? -1 : 0;
+}
+
+int ddsbench_launchTrial(ddsbench_context *ctx, int argc, char *argv[], char **env, ddsbench_launchResult *result)
+{
+    launchRun run;
+    struct sigaction action, oldInt, oldTerm;
+    int failed;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onInterrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &oldInt);
+    sigaction(SIGTERM, &action, &oldTerm);
+
+    memset(result, 0, sizeof(*result));
+    failed = runLayout(&run, ctx, argc, argv, 1, env) || run.failed;
+    if (!failed) {
+        result->rate = run.rate;
+        result->mbits = run.mbits;
+        result->received = run.received;
+        result->roundTripNs = run.roundTripNs;
+    }
+    free(run.procs);
+
+    sigaction(SIGINT, &oldInt, NULL);
+    sigaction(SIGTERM, &oldTerm, NULL);
+
+    return failed ? -1 : 0;
+}
+
+int ddsbench_launchInterrupted(void)
+{
+    return interrupted;
+}
@@ -4,9 +4,10 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
-#include <dlfcn.h>
+#include <unistd.h>
+#include <pthread.h>
 
-#include <ddsbench.h>
+#include "core.h"
 
 static ddsbench_context ctx = {
   .qos = "vr",
@@ -14,17 +15,31 @@ static ddsbench_context ctx = {
   .subid = 1,
   .topicid = 0,
   .payload = 8,
+  .rotate = 1,
   .burstsize = 1,
-  .pollingdelay = 1
+  .pollingdelay = 1,
+  .duration = 0,
+  .maxsamples = 100,
+  .recv = DDSBENCH_RECV_BLOCK,
+  .spin = 50
 };
 
 /** ddsbench configuration options */
 char *ddsbench_mode = "latency";
 char *ddsbench_lib = "ospl";
+char *ddsbench_publib = NULL;
+char *ddsbench_sublib = NULL;
 unsigned int ddsbench_numsub = -1;
 unsigned int ddsbench_numpub = -1;
 unsigned int ddsbench_numtopic = 1;
 char ddsbench_topicname[256];
+char *ddsbench_selectivity = "0,10,20,30,40,50,60,70,80,90,100";
+char *ddsbench_complexity = "1,4,16";
+char *ddsbench_history = "1000,10000,100000";
+char *ddsbench_payloads = NULL;
+char *ddsbench_maxsamples = NULL;
+int ddsbench_fragmentsize = 61440;
+char *ddsbench_cpus = NULL;
 
 /** Error reporting */
 #define throw(...) { printf("error: " __VA_ARGS__); goto error; }
@@ -32,10 +47,15 @@ char ddsbench_topicname[256];
 static void printUsage(void)
 {
     printf(
-      "Usage: ddsbench [latency (default)|throughput] [options]\n\n"
+      "Usage: ddsbench [launch|tune] [latency (default)|throughput|filter|durability|backpressure|large] [options]\n"
+      "       ddsbench plugins [--libpath dirs]\n\n"
       "Options:\n"
-      "  --qos v|t|p|b|r       Specify QoS (see QoS codes)\n"
+      "  --qos v|t|p|l|b|r     Specify QoS (see QoS codes)\n"
       "  --payload bytes       Specify payload of messages\n"
+      "  --pattern const|zero|random|counter  Content of payloads (default = const)\n"
+      "  --rotate count        Payload buffers a writer rotates through (default = 1)\n"
+      "  --hugepages           Place payload buffers in huge pages\n"
+      "  --verify              Checksum payloads and verify them on receipt\n"
       "  --numsub count        Specify number of subscribers\n"
       "  --numpub count        Specify number of publishers\n"
       "  --numtopic count      Specify the number of topics to write to\n"
@@ -43,18 +63,69 @@ static void printUsage(void)
       "  --subid offset        Specify an offset for the subscriber id\n"
       "  --topicid offset      Specify an offset for the topic id\n"
       "  --filter sql          Specify filter in OMG-DDS compliant SQL\n"
-      "  --lib ospl|lite       Use Lite or OpenSplice (default)\n"
+      "  --filterin dds|local  Filter in the middleware (default) or after take\n"
+      "  --lib name|path       Plugin to use, ospl (default), lite, cyclone, inproc,\n"
+      "                        shm, udp or see ddsbench plugins\n"
+      "  --libpath dirs        Colon separated directories searched for plugins first\n"
+      "  --pub-lib list        Plugins the publishers run on (default = --lib)\n"
+      "  --sub-lib list        Plugins the subscribers run on (default = --lib)\n"
+      "  --cpus list|policy    Pin threads to a list of cpus, or compact|scatter|numa\n"
+      "  --rt                  Run with the real-time profile (see below)\n"
+      "  --perf                Count cycles, instructions and misses per thread\n"
+      "  --allocs              Count heap allocations per thread and per sample\n"
+      "  --recv block|spin|hybrid  Block, busy-poll or both when receiving (default = block)\n"
+      "  --spin us             Time a hybrid receiver spins, and then yields (default = 50)\n"
+      "  --take copy|loan      Copy samples into the application or loan them (default = product)\n"
       "  --help                Display this usage information\n"
       "\n"
       "Throughput only options:\n"
       "  --burstsize (pub)     Number of samples to send in a burst (default = 1)\n"
       "  --burstinterval (pub) Number of ms between bursts (default = 0)\n"
       "  --pollingdelay (sub)  Delay between polling in ms, 0 is event based (default = 1)\n"
+      "  --batch (pub)         Write every burst as one batch\n"
+      "  --duration secs       Stop after the specified number of seconds (default = 0)\n"
+      "  --maxsamples count    Writer resource limit, -1 is unlimited (default = 100)\n"
+      "  --workers n|auto      Run endpoints on a pool of n workers, auto is one per cpu\n"
+      "  --readers count       Readers a writer waits for before starting (default = numsub)\n"
+      "  --writers count       Writers a reader waits for before starting (default = numpub)\n"
+      "\n"
+      "Filter only options:\n"
+      "  --selectivity list    Percentages of samples that pass (default = 0,10,..,100)\n"
+      "  --complexity list     Number of terms in the filter (default = 1,4,16)\n"
+      "\n"
+      "OpenSplice only options:\n"
+      "  --ospl-mode single|shm  Generate the domain configuration of a deployment\n"
+      "  --ospl-dbsize MB      Size of the shared memory database (default = 64)\n"
+      "  --ospl-services list  Services of the domain, ddsi2, durability or none\n"
+      "                        (default = ddsi2,durability)\n"
+      "\n"
+      "Launch only options:\n"
+      "  --subprocs count      Processes the subscribers are spread over (default = numsub)\n"
+      "  --pubprocs count      Processes the publishers are spread over (default = numpub)\n"
+      "  --proccpus sets       Pin processes round-robin to --cpus values separated by '/'\n"
+      "  --compare             Run all endpoints in one process first, and compare\n"
+      "\n"
+      "Tune only options:\n"
+      "  --rounds count        Rounds of the search over the DDSI2 settings (default = 3)\n"
+      "  --repeats count       Launches of every configuration, scored by their median (default = 3)\n"
+      "\n"
+      "Durability only options:\n"
+      "  --history list        Historical samples written per publisher (default = 1000,10000,100000)\n"
+      "  --instances count     Number of instances the history is spread over (default = 100)\n"
+      "  --payloads list       Payload sizes to measure (default = --payload)\n"
+      "\n"
+      "Backpressure only options:\n"
+      "  --maxsamples list     Writer resource limits to measure (default = 1,10,100,1000,-1)\n"
+      "\n"
+      "Large only options:\n"
+      "  --payloads list       Payload sizes to measure (default = around fragment boundaries)\n"
+      "  --fragmentsize bytes  DDSI2 FragmentSize of the domain (default = 61440)\n"
       "\n"
       "Use a combination of the following letters to specify a QoS:\n"
       "  v - volatile\n"
       "  t - transient\n"
       "  p - persistent\n"
+      "  l - transient local\n"
       "  b - best effort\n"
       "  r - reliable\n"
       "  The default QoS is 'vr'.\n"
@@ -67,17 +138,236 @@ static void printUsage(void)
       " ddsbench throuhgput --numpub 1 --pubid 2 &\n"
       " ddsbench throuhgput --numpub 1 --pubid 3 &\n"
       "\n"
+      "ddsbench launch does this in a single command: it starts the subscribers\n"
+      "and publishers in --subprocs and --pubprocs processes with the right ids,\n"
+      "sets --readers and --writers to the totals, forwards their output and\n"
+      "reports their progress every second and their results together. With\n"
+      "--compare the same endpoints first run in a single process, so that the\n"
+      "cost of going inter-process is reported side by side.\n"
+      " ddsbench launch throughput --numsub 1 --numpub 3 --duration 10 --compare\n"
+      " ddsbench launch throughput --numpub 4 --pubprocs 2 --proccpus 0,1/2,3/4,5\n"
+      "\n"
       "When specifying a filter, you can use the 'filter' field, which is a member\n"
       "in both the types used for latency and throughput benchmarking. The filter\n"
-      "field will cycle through the numbers one through 10. To specify a filter that\n"
+      "field will cycle through the numbers zero through 9. To specify a filter that\n"
       "blocks 50%% of the traffic, do:\n"
       " ddsbench throughput --filter \"filter < 5\"\n"
       "\n"
+      "The filter mode measures the CPU cost of filtering. It runs a throughput\n"
+      "trial without a filter, followed by a trial for each combination of\n"
+      "selectivity and complexity, once filtering in the middleware and once\n"
+      "with a predicate compiled by ddsbench that is applied after take. Each\n"
+      "trial runs for --duration seconds (default = 2). When --filter is specified\n"
+      "only that expression is measured. Local filters support expressions of the\n"
+      "form 'field op value' joined by AND and OR, where field is one of id,\n"
+      "filter or count.\n"
+      " ddsbench filter --selectivity 0,50,100 --complexity 1,8\n"
+      "\n"
+      "The durability mode measures how fast late joining subscribers receive\n"
+      "historical data. Publishers first write the history, spread over a number\n"
+      "of instances, after which the subscribers are created. For transient and\n"
+      "persistent QoS the publishers delete their writers before the subscribers\n"
+      "start, so the history is aligned by the durability service. For transient\n"
+      "local QoS writers stay alive until all subscribers are aligned. Each trial\n"
+      "waits at most --duration seconds (default = 30) for the history. Products\n"
+      "without a durability service (lite, cyclone) align transient local only.\n"
+      " ddsbench durability --qos tr --history 1000,100000 --payloads 64,4096\n"
+      "\n"
+      "The backpressure mode measures when reliable flow control throttles a\n"
+      "publisher. It runs a throughput trial of --duration seconds (default = 5)\n"
+      "for each writer resource limit, timing every write call. Publishers report\n"
+      "blocked and timed out writes every second, and the mode reports the\n"
+      "distribution of the time spent in write. The DDSI2 WhcHigh watermark is a\n"
+      "domain setting, to measure its effect run the sweep with different\n"
+      "configurations.\n"
+      " ddsbench backpressure --maxsamples 10,1000 --payload 4096\n"
+      "\n"
+      "The large mode measures throughput and latency of large samples. Each trial\n"
+      "runs for --duration seconds (default = 2) and reports the number of DDSI\n"
+      "fragments per sample, and the latency from the source timestamp to take.\n"
+      "By default payloads are chosen that exactly fill 1, 2, 4, .. fragments up\n"
+      "to 64 MB, and one byte more. Writers use a resource limit of 10 samples\n"
+      "unless --maxsamples is specified.\n"
+      " ddsbench large --payloads 65536,1048576,67108864\n"
+      "\n"
       "When specifying a filter in latency measurements, be sure *not* to block any\n"
       "data, as this will disrupt the measurement. A safe filter that can be used to\n"
       "measure filter overhead is:\n"
       " ddsbench latency --filter \"filter < 10\"\n"
       "\n"
+      "With --cpus threads are pinned to cpus in the order they are created: for\n"
+      "each topic first the subscribers, then the publishers. A list pins them\n"
+      "round-robin to the listed cpus, compact fills the hardware threads of a\n"
+      "core and the cores of a node first, scatter spreads threads over nodes\n"
+      "and cores, and numa runs all threads of a topic on the cpus of one node.\n"
+      "Each thread allocates its buffers and statistics itself, so that they are\n"
+      "local to its node. The placement of every thread is printed.\n"
+      " ddsbench latency --cpus 2,4\n"
+      "\n"
+      "The real-time profile locks all memory with mlockall, prefaults stacks,\n"
+      "payloads and statistics, sets the timer slack of every thread to 1 ns and\n"
+      "runs threads with SCHED_FIFO: priority 90 for subscribers (ping), 89 for\n"
+      "publishers (pong) and 50 for the main thread that reports results. This\n"
+      "requires privileges (CAP_SYS_NICE, CAP_IPC_LOCK or matching rlimits), the\n"
+      "profile reports what took effect and the page faults each thread took.\n"
+      " sudo ddsbench latency --rt --cpus 2,4\n"
+      "\n"
+      "After a latency or throughput run every thread reports its CPU time, the\n"
+      "part spent in the kernel and its voluntary (vcsw) and involuntary (ivcsw)\n"
+      "context switches. The cost per message adds up the CPU per sample and per\n"
+      "MB of the writers, the readers and the threads of the middleware, by name.\n"
+      "Other is CPU of the main thread and of threads that exited during the run.\n"
+      "\n"
+      "With --perf every thread counts cycles, instructions, L1 data cache and\n"
+      "last level cache misses and branch misses from the start barrier, with\n"
+      "perf_event_open. Counters are reported per role every second and per\n"
+      "thread at the end, per sample and per byte. When perf_event_paranoid\n"
+      "does not allow kernel counting only user space is counted, and when no\n"
+      "counter can be opened the run continues without them.\n"
+      " ddsbench throughput --perf --duration 10\n"
+      "\n"
+      "Payloads are filled with 'a' by default. --pattern zero, random or counter\n"
+      "fills them with zeros, incompressible random bytes or counting 64 bit\n"
+      "words instead, so that compression or deduplication in the transport\n"
+      "gets no help. Every payload buffer starts on a page of its own, with\n"
+      "--rotate writers cycle through a number of them so consecutive samples\n"
+      "do not share cache lines, and --hugepages maps them in huge pages.\n"
+      " ddsbench throughput --payload 65536 --pattern random --rotate 16\n"
+      "\n"
+      "With --verify writers stamp every payload with a CRC32C of its content\n"
+      "in its first 8 bytes, and subscribers and pong recompute it over the full\n"
+      "payload, so the receive side pays for reading the data. Corrupt payloads\n"
+      "and the CPU time and bandwidth of verifying are reported per thread.\n"
+      " ddsbench throughput --payload 1048576 --pattern random --verify\n"
+      "\n"
+      "With --allocs every call of malloc, calloc, realloc and free is counted,\n"
+      "in the benchmark libraries and the middleware too. Benchmark threads are\n"
+      "counted from the start barrier, other threads together as middleware.\n"
+      "Allocations per role are reported every second, so a configuration that\n"
+      "does not allocate in steady state shows 0, and per thread at the end with\n"
+      "a histogram of allocation sizes.\n"
+      " ddsbench throughput --lib lite --take loan --allocs --duration 10\n"
+      "\n"
+      "With --take copy readers take samples into buffers of their own, with\n"
+      "--take loan they use the samples of the middleware and return the loan\n"
+      "after use, the Lite pong writes the loaned sample back. Lite copies by\n"
+      "default, OpenSplice always loans. Use the large mode to compare both per\n"
+      "payload size.\n"
+      " ddsbench large --lib lite --take loan\n"
+      "\n"
+      "With --recv spin receiving threads take in a loop without ever blocking.\n"
+      "With --recv hybrid they spin for --spin microseconds, then yield the cpu\n"
+      "for as long, and then block until data arrives. Each thread reports the\n"
+      "CPU time it used per sample, and how often it polled, yielded and blocked,\n"
+      "so that runs with different --recv settings can be compared. Both ignore\n"
+      "--pollingdelay.\n"
+      " ddsbench latency --recv hybrid --spin 20 --cpus 2,4\n"
+      "\n"
+      "Threads first create their entities and wait until each writer is matched\n"
+      "with --readers readers and each reader with --writers writers (at most 10\n"
+      "seconds). Measurement starts when all threads are ready, at the same time\n"
+      "for every thread. Set --readers and --writers to the totals of all processes\n"
+      "when a benchmark is split over processes with --pubid and --subid.\n"
+      " ddsbench throughput --numsub 2 --numpub 0 --writers 4\n"
+      " ddsbench throughput --numsub 0 --numpub 4 --readers 2\n"
+      "\n"
+      "By default every publisher and subscriber runs on its own thread. With\n"
+      "--workers a fixed pool of threads runs them instead: each worker waits\n"
+      "for the readers of all its topics in one waitset and writes bursts for\n"
+      "its writers from a pacing wheel, so that thousands of topics do not need\n"
+      "thousands of threads. The endpoints of a topic go to consecutive workers,\n"
+      "starting one worker further for every topic, so that every worker serves\n"
+      "publishers and subscribers and the two ends of a topic run on different\n"
+      "workers. --cpus pins the workers instead of the endpoints.\n"
+      " ddsbench throughput --numtopic 10000 --workers auto --burstinterval 100\n"
+      "\n"
+      "Products are plugins, shared libraries that export a versioned descriptor\n"
+      "with their name, their endpoints and what they support: loans, filters,\n"
+      "listeners, durability, batching and workers. The latency, throughput,\n"
+      "durability and worker pool loops run in ddsbench on those endpoints, so\n"
+      "that every product is timed, counted and configured alike. An option or\n"
+      "mode that needs one of these is refused, or measured without it, when\n"
+      "the plugin does not support it.\n"
+      "--lib finds <dir>/<name>/lib<name>.so or <dir>/lib<name>.so in the\n"
+      "directories of --libpath, DDSBENCH_PLUGIN_PATH, the working directory,\n"
+      "the directory of ddsbench and its ../lib/ddsbench.\n"
+      "ddsbench plugins lists the plugins that are found and what they support.\n"
+      " DDSBENCH_PLUGIN_PATH=/opt/ddsbench/plugins ddsbench plugins\n"
+      "\n"
+      "The inproc plugin needs no middleware. Writers copy samples into a lock\n"
+      "free ring of every reader of their topic in the same process, readers\n"
+      "that find their ring empty block on a futex. It is the baseline of what\n"
+      "the harness itself costs, and --take loan (its default) reads samples in\n"
+      "place. Best effort writers (--qos b) drop samples when a ring is full.\n"
+      " ddsbench latency --lib inproc --recv spin\n"
+      "\n"
+      "The shm plugin does the same between processes. Every topic and partition\n"
+      "is a ring in a shared memory segment (/dev/shm/ddsbench.*) that readers\n"
+      "loan samples from without a copy, so the --pubid and --subid workflows\n"
+      "run each side in a process of its own:\n"
+      " ddsbench throughput --lib shm --numpub 0 --numsub 1\n"
+      " ddsbench throughput --lib shm --numpub 1 --numsub 0 --pubid 5\n"
+      "\n"
+      "The udp plugin sends samples in datagrams over the loopback interface,\n"
+      "batched with sendmmsg and recvmmsg, which is the cost of the kernel without\n"
+      "a protocol on top. Samples are cut in fragments that fill an Ethernet frame\n"
+      "(DDSBENCH_UDP_FRAGMENT sets their size), sent with GSO unless\n"
+      "DDSBENCH_UDP_GSO=0. Nothing is retransmitted, samples that do not fit in the\n"
+      "socket buffer of a reader are lost and counted as missing. With --recv spin\n"
+      "or hybrid sockets busy poll for --spin microseconds (SO_BUSY_POLL). Topics\n"
+      "use ports from DDSBENCH_UDP_PORT (default 20000) up.\n"
+      " DDSBENCH_UDP_FRAGMENT=65000 ddsbench throughput --lib udp --payload 100000\n"
+      "\n"
+      "The cyclone plugin runs Eclipse Cyclone DDS with the QoS of the ospl plugin,\n"
+      "so that both are measured alike (t and p are transient local, as there is\n"
+      "no durability service). Threads share a participant and are delivered to\n"
+      "locally, other processes are found by unicast on the loopback interface\n"
+      "unless CYCLONEDDS_URI configures the domain. --batch packs a burst in\n"
+      "messages, and --take loan loans samples on take, and on write for types\n"
+      "that support it.\n"
+      " ddsbench latency --lib cyclone --qos vr\n"
+      "\n"
+      "The ospl plugin uses the domain of OSPL_URI, unless --ospl-mode selects a\n"
+      "deployment. Then a configuration with the settings of ospl.xml is generated\n"
+      "for a single process domain, in a temporary directory, or for a shared\n"
+      "memory database of --ospl-dbsize MB, in $TMPDIR/ddsbench-ospl-shm-<uid>.xml,\n"
+      "with the services of --ospl-services. Without ddsi2 the domain is local\n"
+      "to the host. All processes on the host share a shared memory domain, so\n"
+      "ddsbench never starts or stops it. A run writes the configuration and\n"
+      "reports it, start the domain with ospl start on it before the runs that\n"
+      "attach (a run fails without it) and stop it with ospl stop after the last\n"
+      "one. The options set DDSBENCH_OSPL_MODE, DDSBENCH_OSPL_DBSIZE and\n"
+      "DDSBENCH_OSPL_SERVICES, which the plugin reads.\n"
+      " ddsbench latency --ospl-mode single\n"
+      " ddsbench latency --ospl-mode shm --ospl-dbsize 256 --ospl-services durability\n"
+      "\n"
+      "ddsbench tune searches the DDSI2 settings of ospl.xml that matter for a\n"
+      "workload, WhcHigh, MaxMessageSize, FragmentSize and multicast loopback,\n"
+      "for the best throughput or median round trip. Every configuration runs as\n"
+      "a trial of --repeats launches of --duration seconds (default = 3) in single\n"
+      "process domains, so that the data goes through DDSI2, and is scored by the\n"
+      "median of the launches. The search varies one setting at a time, keeps the\n"
+      "best value and stops after --rounds rounds or a round without improvement.\n"
+      "The baseline of ospl.xml and the best configuration are then launched\n"
+      "again, and the improvement of those launches is reported with the\n"
+      "DDSI2Service settings of the best configuration. The ospl\n"
+      "plugin reads them from DDSBENCH_OSPL_WHCHIGH, DDSBENCH_OSPL_MAXMESSAGESIZE,\n"
+      "DDSBENCH_OSPL_FRAGMENTSIZE and DDSBENCH_OSPL_MCLOOPBACK with --ospl-mode.\n"
+      " ddsbench tune throughput --payload 8192 --numpub 2 --duration 5\n"
+      "\n"
+      "With --pub-lib and --sub-lib publishers and subscribers run on different\n"
+      "plugins, to measure the interoperability paths of mixed fleets. In one\n"
+      "process both plugins are loaded, for every pair of the comma separated\n"
+      "lists in turn, and a trial of --duration seconds (default = 5) is run.\n"
+      "The results are a matrix of the latency or throughput of every pair, with\n"
+      "the publisher plugins (pong) per row and the subscriber plugins (ping) per\n"
+      "column. Different products meet over DDSI only, pairs of which one does\n"
+      "not are skipped (n/a). A process with publishers or subscribers only loads\n"
+      "the plugin of its role, so that both sides can run in processes of their\n"
+      "own, and ddsbench launch passes both options on.\n"
+      " ddsbench latency --pub-lib ospl,lite,cyclone --sub-lib ospl,lite,cyclone\n"
+      " ddsbench launch throughput --pub-lib ospl --sub-lib cyclone --duration 10\n"
+      "\n"
       "If specifying more than one topic, the number of configured publishers and\n"
       "subscribers will be multiplied by the number of topics. For example:\n"
       " ddsbench throughput --numsub 1 --numpub 2 --numtopic 3\n"
@@ -89,15 +379,39 @@ static void printUsage(void)
 
 static int parseArguments(int argc, char *argv[])
 {
-    int i;
+    int i, qosSet = 0, readersSet = 0, writersSet = 0;
     for (i = 1; i < argc; i ++)
     {
-        if (argv[i][0] == '-')
+        if (!strcmp(argv[i], "--rt"))
+        {
+            ddsbench_rt = 1;
+        } else if (!strcmp(argv[i], "--compare"))
+        {
+            ddsbench_compare = 1;
+        } else if (!strcmp(argv[i], "--perf"))
+        {
+            ddsbench_perf = 1;
+        } else if (!strcmp(argv[i], "--hugepages"))
+        {
+            ctx.hugepages = 1;
+        } else if (!strcmp(argv[i], "--allocs"))
+        {
+            ddsbench_allocs = 1;
+        } else if (!strcmp(argv[i], "--verify"))
+        {
+            ctx.verify = 1;
+        } else if (!strcmp(argv[i], "--batch"))
+        {
+            ctx.batch = 1;
+        } else if (argv[i][0] == '-')
         {
             if ((i == (argc - 1)) || !argv[i + 1][0]) throw("missing parameter for %s\n", argv[i]);
-            if (!strcmp(argv[i], "--qos")) ctx.qos = argv[i + 1], i++;
+            if (!strcmp(argv[i], "--qos")) ctx.qos = argv[i + 1], qosSet = 1, i++;
             else if (!strcmp(argv[i], "--filter")) ctx.filter = argv[i + 1], i++;
             else if (!strcmp(argv[i], "--lib")) ddsbench_lib = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--libpath")) ddsbench_libpath = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--pub-lib")) ddsbench_publib = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--sub-lib")) ddsbench_sublib = argv[i + 1], i++;
             else if (!strcmp(argv[i], "--payload")) ctx.payload = atoi(argv[i + 1]), i++;
             else if (!strcmp(argv[i], "--burstsize")) ctx.burstsize = atoi(argv[i + 1]), i++;
             else if (!strcmp(argv[i], "--burstinterval")) ctx.burstinterval = atoi(argv[i + 1]), i++;
@@ -108,10 +422,89 @@ static int parseArguments(int argc, char *argv[])
             else if (!strcmp(argv[i], "--subid")) ctx.subid = atoi(argv[i + 1]), i++;
             else if (!strcmp(argv[i], "--pubid")) ctx.pubid = atoi(argv[i + 1]), i++;
             else if (!strcmp(argv[i], "--topicid")) ctx.topicid = atoi(argv[i + 1]), i++;
-            else throw("invalid option %s", argv[1]);
+            else if (!strcmp(argv[i], "--duration")) ctx.duration = atoi(argv[i + 1]), i++;
+            else if (!strcmp(argv[i], "--selectivity")) ddsbench_selectivity = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--complexity")) ddsbench_complexity = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--history")) ddsbench_history = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--instances")) ctx.instances = atoi(argv[i + 1]), i++;
+            else if (!strcmp(argv[i], "--payloads")) ddsbench_payloads = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--maxsamples")) ddsbench_maxsamples = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--fragmentsize")) ddsbench_fragmentsize = atoi(argv[i + 1]), i++;
+            else if (!strcmp(argv[i], "--cpus")) ddsbench_cpus = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--spin")) ctx.spin = atoi(argv[i + 1]), i++;
+            else if (!strcmp(argv[i], "--readers")) ctx.readers = atoi(argv[i + 1]), readersSet = 1, i++;
+            else if (!strcmp(argv[i], "--writers")) ctx.writers = atoi(argv[i + 1]), writersSet = 1, i++;
+            else if (!strcmp(argv[i], "--pubprocs")) ddsbench_pubprocs = atoi(argv[i + 1]), i++;
+            else if (!strcmp(argv[i], "--subprocs")) ddsbench_subprocs = atoi(argv[i + 1]), i++;
+            else if (!strcmp(argv[i], "--proccpus")) ddsbench_proccpus = argv[i + 1], i++;
+            else if (!strcmp(argv[i], "--rounds")) {
+                if ((ddsbench_rounds = atoi(argv[i + 1])) <= 0) throw("invalid value for --rounds: %s\n", argv[i + 1]);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--repeats")) {
+                ddsbench_repeats = atoi(argv[i + 1]);
+                if (ddsbench_repeats <= 0 || ddsbench_repeats > DDSBENCH_TUNE_MAX_REPEATS) throw("invalid value for --repeats: %s\n", argv[i + 1]);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--workers")) {
+                if (!strcmp(argv[i + 1], "auto")) ddsbench_workers = -1;
+                else if ((ddsbench_workers = atoi(argv[i + 1])) <= 0) throw("invalid value for --workers: %s\n", argv[i + 1]);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--recv")) {
+                if (!strcmp(argv[i + 1], "block")) ctx.recv = DDSBENCH_RECV_BLOCK;
+                else if (!strcmp(argv[i + 1], "spin")) ctx.recv = DDSBENCH_RECV_SPIN;
+                else if (!strcmp(argv[i + 1], "hybrid")) ctx.recv = DDSBENCH_RECV_HYBRID;
+                else throw("invalid value for --recv: %s\n", argv[i + 1]);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--rotate")) {
+                if (atoi(argv[i + 1]) < 1) throw("invalid value for --rotate: %s\n", argv[i + 1]);
+                ctx.rotate = atoi(argv[i + 1]);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--pattern")) {
+                if (!strcmp(argv[i + 1], "const")) ctx.pattern = DDSBENCH_PATTERN_CONST;
+                else if (!strcmp(argv[i + 1], "zero")) ctx.pattern = DDSBENCH_PATTERN_ZERO;
+                else if (!strcmp(argv[i + 1], "random")) ctx.pattern = DDSBENCH_PATTERN_RANDOM;
+                else if (!strcmp(argv[i + 1], "counter")) ctx.pattern = DDSBENCH_PATTERN_COUNTER;
+                else throw("invalid value for --pattern: %s\n", argv[i + 1]);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--take")) {
+                if (!strcmp(argv[i + 1], "copy")) ctx.take = DDSBENCH_TAKE_COPY;
+                else if (!strcmp(argv[i + 1], "loan")) ctx.take = DDSBENCH_TAKE_LOAN;
+                else throw("invalid value for --take: %s\n", argv[i + 1]);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--ospl-mode")) {
+                if (strcmp(argv[i + 1], "single") && strcmp(argv[i + 1], "shm")) {
+                    throw("invalid value for --ospl-mode: %s\n", argv[i + 1]);
+                }
+                setenv("DDSBENCH_OSPL_MODE", argv[i + 1], 1);
+                i++;
+            }
+            else if (!strcmp(argv[i], "--ospl-dbsize")) setenv("DDSBENCH_OSPL_DBSIZE", argv[i + 1], 1), i++;
+            else if (!strcmp(argv[i], "--ospl-services")) setenv("DDSBENCH_OSPL_SERVICES", argv[i + 1], 1), i++;
+            else if (!strcmp(argv[i], "--filterin")) {
+                if (!strcmp(argv[i + 1], "local")) ctx.localfilter = 1;
+                else if (strcmp(argv[i + 1], "dds")) throw("invalid value for --filterin: %s\n", argv[i + 1]);
+                i++;
+            }
+            else throw("invalid option %s\n", argv[i]);
+        } else if (!strcmp(argv[i], "launch"))
+        {
+            ddsbench_launch = 1;
+        } else if (!strcmp(argv[i], "tune"))
+        {
+            /* Every trial of the tuner is a launch */
+            ddsbench_tune = 1;
+            ddsbench_launch = 1;
         } else
         {
-            if (!strcmp(argv[i], "latency") || !strcmp(argv[i], "throughput"))
+            if (!strcmp(argv[i], "latency") || !strcmp(argv[i], "throughput") ||
+                !strcmp(argv[i], "filter") || !strcmp(argv[i], "durability") ||
+                !strcmp(argv[i], "backpressure") || !strcmp(argv[i], "large"))
             {
                 ddsbench_mode = argv[i];
             } else
@@ -145,7 +538,60 @@ static int parseArguments(int argc, char *argv[])
         }
     }
 
-    if (ctx.filter) {
+    /* Endpoints start when matched with the endpoints of their topic in this
+     * process, a latency pair only matches its own ping or pong */
+    if (!readersSet) {
+        ctx.readers = !strcmp(ddsbench_mode, "latency") ? 1 : ddsbench_numsub;
+    }
+    if (!writersSet) {
+        ctx.writers = !strcmp(ddsbench_mode, "latency") ? 1 : ddsbench_numpub;
+    }
+
+    if (!strcmp(ddsbench_mode, "backpressure")) {
+        if (!ddsbench_maxsamples) {
+            ddsbench_maxsamples = "1,10,100,1000,-1";
+        }
+    } else if (!strcmp(ddsbench_mode, "large") && !ddsbench_maxsamples) {
+        ctx.maxsamples = 10;
+    } else if (ddsbench_maxsamples) {
+        if (ddsbench_parseList(ddsbench_maxsamples, &ctx.maxsamples, 1) != 1) {
+            goto error;
+        }
+    }
+
+    if (!strcmp(ddsbench_mode, "filter")) {
+        if (!ctx.duration) {
+            ctx.duration = 2;
+        }
+    } else if (!strcmp(ddsbench_mode, "backpressure")) {
+        if (!ctx.duration) {
+            ctx.duration = 5;
+        }
+    } else if (!strcmp(ddsbench_mode, "large")) {
+        if (!ctx.duration) {
+            ctx.duration = 2;
+        }
+    } else if (!strcmp(ddsbench_mode, "durability")) {
+        if (!qosSet) {
+            ctx.qos = "tr";
+        }
+        if (!strchr(ctx.qos, 't') && !strchr(ctx.qos, 'p') && !strchr(ctx.qos, 'l')) {
+            throw("durability mode requires transient, persistent or transient local QoS\n");
+        }
+        if (!ctx.duration) {
+            ctx.duration = 30;
+        }
+        if (!ctx.instances) {
+            ctx.instances = 100;
+        }
+    } else if (ctx.filter) {
+        /* Lite and local filtering rely on the predicate compiled by ddsbench */
+        if (!(ctx.predicate = ddsbench_predicateCompile(ctx.filter))) {
+            if (ctx.localfilter) {
+                goto error;
+            }
+            printf("Note: this filter can only be evaluated by products with SQL support.\n");
+        }
         printf(
           "\n"
           "Note: when specifying a filter, throughput will appear to decrease\n"
@@ -159,6 +605,80 @@ static int parseArguments(int argc, char *argv[])
         throw("no publishers or subscribers specified.");
     }
 
+    /* Publishers and subscribers on plugins of their own. A process with one
+     * role loads the plugin of that role, a process with both runs every pair
+     * of the lists, see ddsbench_runCross. */
+    if (ddsbench_publib || ddsbench_sublib) {
+        if (strcmp(ddsbench_mode, "latency") && strcmp(ddsbench_mode, "throughput")) {
+            throw("--pub-lib and --sub-lib support latency and throughput mode only\n");
+        }
+        if (ddsbench_workers) {
+            throw("--workers is not supported with --pub-lib and --sub-lib\n");
+        }
+        if (!ddsbench_publib) {
+            ddsbench_publib = ddsbench_lib;
+        }
+        if (!ddsbench_sublib) {
+            ddsbench_sublib = ddsbench_lib;
+        }
+        if ((ddsbench_launch || !ddsbench_numpub || !ddsbench_numsub) &&
+            (strchr(ddsbench_publib, ',') || strchr(ddsbench_sublib, ',')))
+        {
+            throw("a list of plugins requires publishers and subscribers in one process\n");
+        }
+        if (!ddsbench_numsub) {
+            ddsbench_lib = ddsbench_publib;
+        } else if (!ddsbench_numpub) {
+            ddsbench_lib = ddsbench_sublib;
+        } else if (!ctx.duration) {
+            ctx.duration = 5;
+        }
+    }
+
+    /* By default every publisher and subscriber runs in a process of its own */
+    if (ddsbench_launch) {
+        if (strcmp(ddsbench_mode, "latency") && strcmp(ddsbench_mode, "throughput")) {
+            throw("launch supports latency and throughput mode only\n");
+        }
+        if (ddsbench_pubprocs < 0) {
+            ddsbench_pubprocs = ddsbench_numpub;
+        }
+        if (ddsbench_subprocs < 0) {
+            ddsbench_subprocs = ddsbench_numsub;
+        }
+        if (ddsbench_pubprocs > (int)ddsbench_numpub || (ddsbench_numpub && !ddsbench_pubprocs)) {
+            throw("invalid value for --pubprocs: %d (numpub is %u)\n", ddsbench_pubprocs, ddsbench_numpub);
+        }
+        if (ddsbench_subprocs > (int)ddsbench_numsub || (ddsbench_numsub && !ddsbench_subprocs)) {
+            throw("invalid value for --subprocs: %d (numsub is %u)\n", ddsbench_subprocs, ddsbench_numsub);
+        }
+        if (ddsbench_pubprocs + ddsbench_subprocs > DDSBENCH_MAX_PROCS) {
+            throw("launch starts at most %d processes\n", DDSBENCH_MAX_PROCS);
+        }
+        if (ddsbench_tune) {
+            if (ddsbench_compare || ddsbench_publib) {
+                throw("--compare, --pub-lib and --sub-lib are not supported with tune\n");
+            }
+            if (!ctx.duration) {
+                ctx.duration = 3;
+            }
+        }
+    } else if (ddsbench_pubprocs >= 0 || ddsbench_subprocs >= 0 || ddsbench_proccpus || ddsbench_compare) {
+        throw("--pubprocs, --subprocs, --proccpus and --compare require launch\n");
+    }
+
+    if (ctx.verify && ctx.payload < sizeof(ddsbench_payloadHeader)) {
+        throw("--verify requires a payload of at least %d bytes\n", (int)sizeof(ddsbench_payloadHeader));
+    }
+
+    if (ddsbench_perf && ddsbench_workers) {
+        throw("--perf counts per thread and is not supported with --workers\n");
+    }
+
+    if (ddsbench_allocs && ddsbench_workers) {
+        throw("--allocs counts per thread and is not supported with --workers\n");
+    }
+
     sprintf(ddsbench_topicname, "%s_%s", ddsbench_mode, ctx.qos);
     sprintf(ctx.filtername, "%s_%s_filter", ddsbench_mode, ctx.qos);
 
@@ -167,52 +687,391 @@ error:
     return -1;
 }
 
-static int loadLibrary(char *file, ddsbench_context *ctx, ddsbench_libraryInterface *interface) {
-    void *lib = dlopen(file, RTLD_NOW);
+/* Threads run on a copy of their argument, so that statistics are allocated
+ * by the (pinned) thread itself and are local to its numa node */
+typedef struct ddsbench_threadStart {
+    ddsbench_threadFn fn;
+    ddsbench_threadArg *arg;
+    ddsbench_threadArg **live;      /* Arg the thread currently runs on, see ddsbench_launchMove */
+} ddsbench_threadStart;
+
+static void* threadMain(void *ptr)
+{
+    ddsbench_threadStart *start = ptr;
+    ddsbench_threadArg *local = malloc(sizeof(ddsbench_threadArg));
+    long faults = 0;
+
+    if (!local) {
+        start->arg->status = start->fn(start->arg);
+        return NULL;
+    }
+    memcpy(local, start->arg, sizeof(ddsbench_threadArg));
+    ddsbench_launchMove(start->live, local);
+    ddsbench_rtThreadStart(local, &faults);
+    local->startNs = ddsbench_time();
+    ddsbench_allocOpen(local);
+    ddsbench_perfOpen(local);
+    ddsbench_usageStart(local);
+    local->status = start->fn(local);
+    ddsbench_allocClose(local);
+    ddsbench_usageStop(local);
+    ddsbench_perfClose(local);
+    ddsbench_rtThreadStop(local, faults);
+    memcpy(start->arg, local, sizeof(ddsbench_threadArg));
+    ddsbench_launchMove(start->live, start->arg);
+    free(local);
+
+    return NULL;
+}
+
+static int startThread(
+    pthread_t *thread,
+    ddsbench_threadStart *start,
+    ddsbench_threadFn fn,
+    ddsbench_threadArg *arg,
+    ddsbench_threadArg **live,
+    int index,
+    int topic)
+{
+    pthread_attr_t attr;
+    char name[64];
+    int result = -1;
+
+    start->fn = fn;
+    start->arg = arg;
+    start->live = live;
+
+    sprintf(name, "%s %d topic %d", arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id, topic);
+    pthread_attr_init(&attr);
+    if (ddsbench_affinityApply(&attr, index, topic, name, &arg->cpu, &arg->node)) goto error;
+    if (pthread_create(thread, &attr, threadMain, start)) {
+        throw("failed to create thread: %s", strerror(errno));
+    }
+    result = 0;
+error:
+    pthread_attr_destroy(&attr);
+    return result;
+}
 
-    if (!lib) {
-        throw("%s: %s\n", file, dlerror());
+/* Report how long it took until the entities of all threads were matched */
+static void printReady(ddsbench_threadArg *args, int count)
+{
+    ddsbench_threadArg *slowest = NULL;
+    unsigned long long fastest = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (!args[i].result.readyNs) {
+            continue;
+        }
+        if (!slowest || args[i].result.readyNs > slowest->result.readyNs) {
+            slowest = &args[i];
+        }
+        if (!fastest || args[i].result.readyNs < fastest) {
+            fastest = args[i].result.readyNs;
+        }
+    }
+
+    if (slowest) {
+        printf("ddsbench: time to ready %.1f ms (fastest %.1f ms, slowest %s %d)\n",
+            slowest->result.readyNs / 1000000.0, fastest / 1000000.0,
+            slowest->role == DDSBENCH_PUBLISHER ? "pub" : "sub", slowest->id);
+    }
+}
+
+/* Report the threads whose function returned an error */
+static void printFailed(ddsbench_threadArg *args, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (args[i].status) {
+            printf("ddsbench: %s %d failed (status %d)\n",
+                args[i].role == DDSBENCH_PUBLISHER ? "pub" : "sub", args[i].id, args[i].status);
+        }
+    }
+}
+
+ddsbench_threadArg* ddsbench_runThreads(
+    ddsbench_libraryInterface *pubInterface,
+    ddsbench_libraryInterface *subInterface,
+    ddsbench_context *ctx,
+    const char *topicname,
+    int *count)
+{
+    int total = (ddsbench_numsub + ddsbench_numpub) * ddsbench_numtopic;
+    unsigned int topic = ctx->topicid;
+    int thread = 0, sub = ctx->subid, pub = ctx->pubid;
+    const ddsbench_plugin *pubPlugin = pubInterface->plugin;
+    const ddsbench_plugin *subPlugin = subInterface->plugin;
+    ddsbench_threadFn subFn = subPlugin->tsub;
+    ddsbench_threadFn pubFn = pubPlugin->tpub;
+    int i;
+
+    if (!strcmp(ddsbench_mode, "latency")) {
+        subFn = subPlugin->lsub;
+        pubFn = pubPlugin->lpub;
+    } else if (!strcmp(ddsbench_mode, "durability")) {
+        subFn = subPlugin->dsub;
+        pubFn = pubPlugin->dpub;
+    }
+    if (!subFn || !pubFn) {
+        printf("error: product does not support %s mode\n", ddsbench_mode);
+        return NULL;
+    }
+    if (ddsbench_workers && strcmp(ddsbench_mode, "throughput")) {
+        printf("error: --workers is only supported in throughput mode\n");
+        return NULL;
+    }
+    if (ddsbench_workers && pubInterface != subInterface) {
+        printf("error: --workers runs publishers and subscribers on the same plugin\n");
+        return NULL;
+    }
+    if (ddsbench_workers && !subPlugin->tworker) {
+        printf("error: product does not support --workers\n");
+        return NULL;
+    }
+
+    /* Start publisher and subscriber threads */
+    pthread_t *threads = malloc(total * sizeof(pthread_t));
+    ddsbench_threadStart *starts = malloc(total * sizeof(ddsbench_threadStart));
+    ddsbench_threadArg *args = calloc(total, sizeof(ddsbench_threadArg));
+    ddsbench_threadArg **live = malloc(total * sizeof(ddsbench_threadArg*));
+    if (!threads || !starts || !args || !live)
+    {
+        throw("out of memory");
+    }
+    for (i = 0; i < total; i++)
+    {
+        live[i] = &args[i];
+    }
+
+    /* Threads cross the start barrier once matched, workers run their own */
+    if (!ddsbench_workers && !(ctx->start = ddsbench_barrierNew(total)))
+    {
+        throw("out of memory");
+    }
+
+    if (ddsbench_workers) {
+        printf("ddsbench: starting %d endpoints on a worker pool\n", total);
     } else {
-        if (!(interface->init = dlsym(lib, "init"))) throw("%s: %s\n", file, dlerror());
-        if (!(interface->fini = dlsym(lib, "fini"))) throw("%s: %s\n", file, dlerror());
-        if (!(interface->lpub = dlsym(lib, "lpub"))) throw("%s: %s\n", file, dlerror());
-        if (!(interface->lsub = dlsym(lib, "lsub"))) throw("%s: %s\n", file, dlerror());
-        if (!(interface->tpub = dlsym(lib, "tpub"))) throw("%s: %s\n", file, dlerror());
-        if (!(interface->tsub = dlsym(lib, "tsub"))) throw("%s: %s\n", file, dlerror());
-        if (interface->init(ctx)) {
-            goto error;
+        printf("ddsbench: starting %d threads\n", total);
+    }
+
+    /* Stream progress to the launcher, if this process was launched */
+    ddsbench_launchReportStart(live, total);
+    ddsbench_perfReportStart();
+    ddsbench_allocReportStart();
+
+    while (topic < (ddsbench_numtopic + ctx->topicid)) {
+        int last = sub + ddsbench_numsub;
+        for (; sub < last; sub++)
+        {
+            ddsbench_threadArg *arg = &args[thread];
+            arg->id = sub;
+            arg->role = DDSBENCH_SUBSCRIBER;
+            arg->ctx = ctx;
+            arg->plugin = subPlugin;
+            sprintf(arg->topicName, "%s_%u", topicname, topic);
+            if (!ddsbench_workers &&
+                startThread(&threads[thread], &starts[thread], subFn, arg, &live[thread], thread, topic - ctx->topicid))
+            {
+                goto error;
+            }
+            thread ++;
+        }
+
+        last = pub + ddsbench_numpub;
+        for (; pub < last; pub++)
+        {
+            ddsbench_threadArg *arg = &args[thread];
+            arg->id = pub;
+            arg->role = DDSBENCH_PUBLISHER;
+            arg->ctx = ctx;
+            arg->plugin = pubPlugin;
+            sprintf(arg->topicName, "%s_%u", topicname, topic);
+            if (!ddsbench_workers &&
+                startThread(&threads[thread], &starts[thread], pubFn, arg, &live[thread], thread, topic - ctx->topicid))
+            {
+                goto error;
+            }
+            thread ++;
         }
-        interface->lib = lib;
+        topic ++;
     }
 
-    return 0;
+    /* Run the endpoints on the worker pool, which returns when all workers are done */
+    if (ddsbench_workers && ddsbench_runPool(subInterface, ctx, args, thread))
+    {
+        goto error;
+    }
+
+    /* Wait for threads to finish */
+    for (i = 0; !ddsbench_workers && i < thread; i++)
+    {
+        if (pthread_join(threads[i], NULL))
+        {
+            throw("failed to join thread %d: %s", i, strerror(errno));
+        }
+    }
+
+    ddsbench_launchReportStop();
+    ddsbench_perfReportStop();
+    ddsbench_allocReportStop();
+    printReady(args, thread);
+    printFailed(args, thread);
+
+    ddsbench_barrierFree(ctx->start);
+    ctx->start = NULL;
+    free(threads);
+    free(starts);
+    free(live);
+    *count = thread;
+    return args;
 error:
-    return -1;
+    ddsbench_launchReportStop();
+    ddsbench_perfReportStop();
+    ddsbench_allocReportStop();
+    ddsbench_barrierFree(ctx->start);
+    ctx->start = NULL;
+    free(threads);
+    free(starts);
+    free(args);
+    free(live);
+    return NULL;
 }
 
-static void closeLibrary(ddsbench_libraryInterface *interface) {
-    if (interface->lib) {
-        interface->fini();
-        dlclose(interface->lib);
+void ddsbench_printReports(ddsbench_context *ctx, ddsbench_threadArg *args, int count)
+{
+    /* Counters are per thread, workers are rejected with --perf and --allocs */
+    if (!ddsbench_workers) {
+        ddsbench_printPerf(args, count);
+        ddsbench_printAllocs(args, count);
+    }
+    if (ctx->verify) {
+        ddsbench_printVerify(args, count);
     }
 }
 
-int main(int argc, char *argv[])
+int ddsbench_sweepInit(
+    ddsbench_sweep *sweep,
+    const ddsbench_sweepMode *mode,
+    ddsbench_libraryInterface *interface,
+    ddsbench_context *ctx,
+    int max)
 {
-    ddsbench_libraryInterface interface;
+    sweep->mode = mode;
+    sweep->interface = interface;
+    sweep->ctx = ctx;
+    sweep->count = 0;
+    if (!(sweep->trials = calloc(max, mode->trialSize))) {
+        printf("error: out of memory\n");
+        return -1;
+    }
+    return 0;
+}
 
-    char cwd[1024], uri[1024];
-    if (!getcwd(cwd, sizeof(cwd))) {
-        printf("could not get current working directory\n");
-        goto error;
+void ddsbench_sweepFini(ddsbench_sweep *sweep)
+{
+    free(sweep->trials);
+    sweep->trials = NULL;
+}
+
+void* ddsbench_sweepTrial(ddsbench_sweep *sweep, int index)
+{
+    return sweep->trials + index * sweep->mode->trialSize;
+}
+
+int ddsbench_sweepRun(ddsbench_sweep *sweep)
+{
+    const ddsbench_sweepMode *mode = sweep->mode;
+    void *trial = ddsbench_sweepTrial(sweep, sweep->count);
+    char topicname[sizeof(ddsbench_topicname) + 16];
+    ddsbench_threadArg *args;
+    int count;
+
+    /* Every trial runs on topics of its own, so that it does not receive
+     * samples of the one before */
+    snprintf(topicname, sizeof(topicname), "%s_%d", ddsbench_topicname, sweep->count);
+    if (mode->start && mode->start(sweep, topicname, trial)) {
+        return -1;
+    }
+    args = ddsbench_runThreads(sweep->interface, sweep->interface, sweep->ctx, topicname, &count);
+    if (args) {
+        mode->collect(sweep, args, count, trial);
+        ddsbench_printReports(sweep->ctx, args, count);
+        free(args);
+    }
+    if (mode->stop) {
+        mode->stop(sweep, trial);
+    }
+    if (!args) {
+        return -1;
     }
 
+    mode->printHeader(sweep);
+    mode->printTrial(sweep, trial);
+    sweep->count++;
+    return 0;
+}
+
+void ddsbench_sweepPrint(ddsbench_sweep *sweep)
+{
+    int i;
+
+    /* The table once more, without interleaved thread output */
+    sweep->mode->printHeader(sweep);
+    for (i = 0; i < sweep->count; i++) {
+        sweep->mode->printTrial(sweep, ddsbench_sweepTrial(sweep, i));
+    }
+}
+
+/* Print the CPU cost of every thread, and how it received data */
+static void printThreads(ddsbench_threadArg *args, int count)
+{
+    int i;
+
+    printf("\n");
+    printf("Thread CPU usage (includes warm-up)\n");
+    printf("ddsbench: %-8s %11s %10s %10s %12s %9s %9s %12s %10s %10s %10s\n",
+        "thread", "samples", "cpu[ms]", "sys[ms]", "cpu/sample", "vcsw", "ivcsw",
+        "empty takes", "yields", "blocks", "ready[ms]");
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        char thread[16];
+        sprintf(thread, "%s %d", args[i].role == DDSBENCH_PUBLISHER ? "pub" : "sub", args[i].id);
+        printf("ddsbench: %-8s %11llu %10.1f %10.1f %9.2f us %9llu %9llu %12llu %10llu %10llu %10.1f\n",
+            thread, r->samples, r->threadCpuNs / 1000000.0, r->systemNs / 1000000.0,
+            r->samples ? (double)r->threadCpuNs / r->samples / 1000.0 : 0,
+            r->voluntarySwitches, r->involuntarySwitches,
+            r->emptyTakes, r->yields, r->blocks, r->readyNs / 1000000.0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ddsbench_libraryInterface interface;
+
     if ((argc > 1) && !strcmp(argv[1], "--help"))
     {
         printUsage();
         return 0;
     }
 
+    /* List the plugins on the search path */
+    if ((argc > 1) && !strcmp(argv[1], "plugins"))
+    {
+        if (argc == 4 && !strcmp(argv[2], "--libpath")) {
+            ddsbench_libpath = argv[3];
+        } else if (argc != 2) {
+            printUsage();
+            goto error;
+        }
+        return ddsbench_pluginList() ? -1 : 0;
+    }
+
+    ddsbench_launchChild();
+
     if (parseArguments(argc, argv))
     {
         printUsage();
@@ -227,84 +1086,173 @@ int main(int argc, char *argv[])
         printf("  filter: %s\n", ctx.filter);
     }
     printf("  payload: %d bytes\n", ctx.payload);
-    if (!strcmp(ddsbench_mode, "throughput")) {
+    if (ctx.pattern != DDSBENCH_PATTERN_CONST || ctx.rotate > 1 || ctx.hugepages) {
+        static const char *patterns[] = { "const", "zero", "random", "counter" };
+        printf("  pattern: %s, %u buffers%s\n", patterns[ctx.pattern], ctx.rotate, ctx.hugepages ? " in huge pages" : "");
+    }
+    if (ctx.verify) {
+        printf("  verify: crc32c\n");
+    }
+    if (!strcmp(ddsbench_mode, "throughput") || !strcmp(ddsbench_mode, "filter") ||
+        !strcmp(ddsbench_mode, "backpressure") || !strcmp(ddsbench_mode, "large"))
+    {
         printf("  burstsize: %d\n", ctx.burstsize);
         printf("  burstinterval: %d\n", ctx.burstinterval);
         printf("  pollingdelay: %d\n", ctx.pollingdelay);
     }
+    if (!strcmp(ddsbench_mode, "filter")) {
+        printf("  selectivity: %s\n", ctx.filter ? "-" : ddsbench_selectivity);
+        printf("  complexity: %s\n", ctx.filter ? "-" : ddsbench_complexity);
+    }
+    if (!strcmp(ddsbench_mode, "backpressure")) {
+        printf("  maxsamples: %s\n", ddsbench_maxsamples);
+    } else if (!strcmp(ddsbench_mode, "throughput") || !strcmp(ddsbench_mode, "filter") ||
+               !strcmp(ddsbench_mode, "large"))
+    {
+        printf("  maxsamples: %d\n", ctx.maxsamples);
+    }
+    if (!strcmp(ddsbench_mode, "large")) {
+        printf("  fragmentsize: %d\n", ddsbench_fragmentsize);
+        printf("  payloads: %s\n", ddsbench_payloads ? ddsbench_payloads : "auto");
+    }
+    if (!strcmp(ddsbench_mode, "durability")) {
+        printf("  history: %s\n", ddsbench_history);
+        printf("  instances: %d\n", ctx.instances);
+        if (ddsbench_payloads) {
+            printf("  payloads: %s\n", ddsbench_payloads);
+        }
+    }
+    if (ctx.filter && ctx.localfilter) {
+        printf("  filter in: local\n");
+    }
+    if (ctx.duration) {
+        printf("  duration: %d sec\n", ctx.duration);
+    }
     if (ctx.subid) {
         printf("  subscriber id: %d\n", ctx.subid);
     }
     if (ctx.pubid) {
         printf("  publisher id: %d\n", ctx.pubid);
     }
+    if (ddsbench_cpus) {
+        printf("  cpus: %s\n", ddsbench_cpus);
+    }
+    if (ddsbench_rt) {
+        printf("  real-time profile: on\n");
+    }
+    if (ctx.recv != DDSBENCH_RECV_BLOCK) {
+        printf("  recv: %s\n", ctx.recv == DDSBENCH_RECV_SPIN ? "spin" : "hybrid");
+    }
+    if (ctx.recv == DDSBENCH_RECV_HYBRID) {
+        printf("  spin: %d us\n", ctx.spin);
+    }
+    if (ctx.batch) {
+        printf("  batch: on\n");
+    }
+    if (ctx.take != DDSBENCH_TAKE_DEFAULT) {
+        printf("  take: %s\n", ctx.take == DDSBENCH_TAKE_COPY ? "copy" : "loan");
+    }
+    if (strcmp(ddsbench_mode, "durability")) {
+        printf("  start when matched with: %u readers, %u writers\n", ctx.readers, ctx.writers);
+    }
+    if (ddsbench_workers < 0) {
+        printf("  workers: auto\n");
+    } else if (ddsbench_workers) {
+        printf("  workers: %d\n", ddsbench_workers);
+    }
+    if (ddsbench_publib) {
+        printf("  publisher plugins: %s\n", ddsbench_publib);
+        printf("  subscriber plugins: %s\n", ddsbench_sublib);
+    }
     printf("  # topics: %d\n", ddsbench_numtopic);
     printf("  # subscribers: %d\n", ddsbench_numsub);
     printf("  # publishers: %d\n", ddsbench_numpub);
 
-    /* Load library for product */
-    char lib[1024]; sprintf(lib, "%s/%s/lib%s.so", cwd, ddsbench_lib, ddsbench_lib);
-    if (loadLibrary(lib, &ctx, &interface)) {
-        goto error;
+    /* The launcher only starts and collects processes, they load the library */
+    if (ddsbench_launch) {
+        printf("  launch: %d subscriber processes, %d publisher processes\n", ddsbench_subprocs, ddsbench_pubprocs);
+        if (ddsbench_proccpus) {
+            printf("  process cpus: %s\n", ddsbench_proccpus);
+        }
+        if (ddsbench_compare) {
+            printf("  compare with: intra-process\n");
+        }
+        if (ddsbench_tune) {
+            printf("  tune: at most %d rounds, %d launches per configuration\n", ddsbench_rounds, ddsbench_repeats);
+            return ddsbench_runTune(&ctx, argc, argv) ? -1 : 0;
+        }
+        return ddsbench_runLaunch(&ctx, argc, argv) ? -1 : 0;
     }
 
-    /* Start publisher and subscriber threads */
-    pthread_t *threads = malloc((ddsbench_numsub + ddsbench_numpub) * sizeof(pthread_t) * ddsbench_numtopic);
-    if (!threads)
-    {
-        throw("out of memory");
+    if (ddsbench_perf) {
+        printf("  hardware counters: on\n");
+    }
+    if (ddsbench_allocs) {
+        printf("  allocations: counted\n");
     }
 
-    printf("ddsbench: starting %d threads\n", (ddsbench_numpub + ddsbench_numsub) * ddsbench_numtopic);
+    if (ddsbench_affinityInit(ddsbench_cpus) || ddsbench_rtInit() || ddsbench_perfInit()) {
+        goto error;
+    }
 
-    int topic = ctx.topicid, thread = 0, sub = ctx.subid, pub = ctx.pubid;
-    int mode = !strcmp(ddsbench_mode, "latency");
+    /* Every pair of publisher and subscriber plugins loads its own */
+    if (ddsbench_publib && ddsbench_numpub && ddsbench_numsub) {
+        int result = ddsbench_runCross(&ctx);
+        ddsbench_affinityFini();
+        return result ? -1 : 0;
+    }
 
-    while (topic < (ddsbench_numtopic + ctx.topicid)) {
-        int total = sub + ddsbench_numsub;
-        for (; sub < total; sub++)
-        {
-            ddsbench_threadArg *arg = malloc(sizeof(ddsbench_threadArg));
-            arg->id = sub;
-            arg->ctx = &ctx;
-            sprintf(arg->topicName, "%s_%d", ddsbench_topicname, topic);
-            if (pthread_create
-              (&threads[thread], NULL, mode ? interface.lsub : interface.tsub, arg))
-            {
-                throw("failed to create thread: %s", strerror(errno));
-            }
-            thread ++;
-        }
+    /* Load the plugin of the product */
+    if (ddsbench_pluginOpen(ddsbench_lib, &ctx, &interface)) {
+        goto error;
+    }
 
-        total = pub + ddsbench_numpub;
-        for (; pub < total; pub++)
-        {
-            ddsbench_threadArg *arg = malloc(sizeof(ddsbench_threadArg));
-            arg->id = pub;
-            arg->ctx = &ctx;
-            sprintf(arg->topicName, "%s_%d", ddsbench_topicname, topic);
-            if (pthread_create
-              (&threads[thread], NULL, mode ? interface.lpub : interface.tpub, arg))
-            {
-                throw("failed to create thread: %s", strerror(errno));
-            }
-            thread ++;
+    if (!strcmp(ddsbench_mode, "filter")) {
+        if (ddsbench_runFilter(&interface, &ctx)) {
+            goto error;
         }
-        topic ++;
-    }
+    } else if (!strcmp(ddsbench_mode, "durability")) {
+        if (ddsbench_runDurability(&interface, &ctx)) {
+            goto error;
+        }
+    } else if (!strcmp(ddsbench_mode, "backpressure")) {
+        if (ddsbench_runBackpressure(&interface, &ctx)) {
+            goto error;
+        }
+    } else if (!strcmp(ddsbench_mode, "large")) {
+        if (ddsbench_runLarge(&interface, &ctx)) {
+            goto error;
+        }
+    } else {
+        ddsbench_tasks before, after;
+        unsigned long long processNs;
+        int count;
 
-    /* Wait for threads to finish */
-    int i;
-    for (i = 0; i < thread; i++)
-    {
-        if (pthread_join(threads[i], NULL))
-        {
-            throw("failed to join thread %d: %s", i, strerror(errno));
+        /* Middleware threads are the ones that are not benchmark threads */
+        ddsbench_tasksSample(&before);
+        processNs = ddsbench_cpuTime(0);
+        ddsbench_threadArg *args = ddsbench_runThreads(&interface, &interface, &ctx, ddsbench_topicname, &count);
+        processNs = ddsbench_cpuTime(0) - processNs;
+        ddsbench_tasksSample(&after);
+        if (!args) {
+            ddsbench_tasksFree(&before);
+            ddsbench_tasksFree(&after);
+            goto error;
+        }
+        if (!ddsbench_workers) {
+            printThreads(args, count);
+            ddsbench_printCost(args, count, &before, &after, processNs);
         }
+        ddsbench_printReports(&ctx, args, count);
+        ddsbench_tasksFree(&before);
+        ddsbench_tasksFree(&after);
+        ddsbench_launchResults(args, count);
+        free(args);
     }
 
     /* Deinitialize benchmark library */
-    closeLibrary(&interface);
+    ddsbench_pluginClose(&interface);
+    ddsbench_affinityFini();
 
     return 0;
 error:
@@ -0,0 +1,154 @@
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "core.h"
+
+/* Size of the huge pages mapped with --hugepages */
+#define DDSBENCH_HUGEPAGE (2UL * 1024 * 1024)
+
+/* Random words are generated in independent lanes, that are held in one
+ * vector so the fill loop runs on vector registers */
+#define DDSBENCH_LANES 4
+
+typedef uint64_t ddsbench_lanes __attribute__((vector_size(DDSBENCH_LANES * sizeof(uint64_t))));
+
+static int hugepagesReported = 0;
+
+static uint64_t splitmix(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Every lane is an xorshift64 generator, seeded differently per pool */
+static void fillRandom(uint64_t *words, unsigned long count, uint64_t seed)
+{
+    ddsbench_lanes lanes;
+    unsigned long i;
+    int l;
+
+    for (l = 0; l < DDSBENCH_LANES; l++) {
+        lanes[l] = splitmix(&seed) | 1;
+    }
+    for (i = 0; i + DDSBENCH_LANES <= count; i += DDSBENCH_LANES) {
+        lanes ^= lanes << 13;
+        lanes ^= lanes >> 7;
+        lanes ^= lanes << 17;
+        memcpy(&words[i], &lanes, sizeof(lanes));
+    }
+    for (l = 0; i < count; i++, l++) {
+        words[i] = lanes[l] ^ (lanes[l] << 13);
+    }
+}
+
+static void fillCounter(uint64_t *words, unsigned long count)
+{
+    unsigned long i;
+
+    for (i = 0; i < count; i++) {
+        words[i] = i;
+    }
+}
+
+/* Map the pool in huge pages if asked to, falling back to transparent huge
+ * pages when none are reserved */
+static void* mapPool(ddsbench_payloadPool *pool, int hugepages)
+{
+    void *base;
+
+    if (hugepages) {
+        pool->mapped = (pool->mapped + DDSBENCH_HUGEPAGE - 1) & ~(DDSBENCH_HUGEPAGE - 1);
+        base = mmap(NULL, pool->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            return base;
+        }
+        if (!__sync_lock_test_and_set(&hugepagesReported, 1)) {
+            printf("ddsbench: no huge pages reserved (see /proc/sys/vm/nr_hugepages), "
+                   "using transparent huge pages\n");
+        }
+    }
+
+    base = mmap(NULL, pool->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    if (hugepages) {
+        madvise(base, pool->mapped, MADV_HUGEPAGE);
+    }
+#endif
+    return base;
+}
+
+int ddsbench_payloadAlloc(ddsbench_payloadPool *pool, ddsbench_context *ctx, unsigned long size)
+{
+    static uint64_t seed = 0;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    unsigned long words;
+
+    if (pageSize <= 0) {
+        pageSize = 4096;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->size = size;
+    pool->count = ctx->rotate ? ctx->rotate : 1;
+    pool->stride = ((size ? size : 1) + pageSize - 1) & ~(pageSize - 1);
+    pool->mapped = pool->stride * pool->count;
+    if (!(pool->base = mapPool(pool, ctx->hugepages))) {
+        return -1;
+    }
+
+    /* The pattern runs on over the padding between payloads, which is
+     * filled as well so that every page is faulted in */
+    words = pool->stride * pool->count / sizeof(uint64_t);
+    switch (ctx->pattern) {
+    case DDSBENCH_PATTERN_CONST:
+        memset(pool->base, 'a', pool->stride * pool->count);
+        break;
+    case DDSBENCH_PATTERN_ZERO:
+        memset(pool->base, 0, pool->stride * pool->count);
+        break;
+    case DDSBENCH_PATTERN_RANDOM:
+        fillRandom((uint64_t *)pool->base, words, __sync_add_and_fetch(&seed, 1) ^ ddsbench_time());
+        break;
+    case DDSBENCH_PATTERN_COUNTER:
+        fillCounter((uint64_t *)pool->base, words);
+        break;
+    }
+
+    /* Payloads do not change once written, so they are stamped only once */
+    if (ctx->verify) {
+        unsigned int i;
+        for (i = 0; i < pool->count; i++) {
+            ddsbench_payloadStamp(pool->base + i * pool->stride, size);
+        }
+    }
+
+    return 0;
+}
+
+void* ddsbench_payloadNext(ddsbench_payloadPool *pool)
+{
+    void *payload = pool->base + pool->next * pool->stride;
+
+    if (++pool->next == pool->count) {
+        pool->next = 0;
+    }
+    return payload;
+}
+
+void ddsbench_payloadFree(ddsbench_payloadPool *pool)
+{
+    if (pool->base) {
+        munmap(pool->base, pool->mapped);
+        pool->base = NULL;
+    }
+}
@@ -0,0 +1,338 @@
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "core.h"
+
+int ddsbench_perf = 0;
+
+/* Counters of a thread, opened as one group so that they count the same instructions */
+typedef struct perfGroup {
+    int fd[DDSBENCH_PERF_COUNTERS];
+    int index[DDSBENCH_PERF_COUNTERS];      /* Position of a counter in a group read */
+    int count;
+    int leader;
+    ddsbench_threadArg *arg;
+    unsigned long long prev[DDSBENCH_PERF_COUNTERS];
+    unsigned long long prevSamples;
+    struct perfGroup *next;
+} perfGroup;
+
+static const struct {
+    const char *name;
+    __u32 type;
+    __u64 config;
+} counters[DDSBENCH_PERF_COUNTERS] = {
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "L1d misses", PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { "LLC misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+};
+
+static int excludeKernel = 0;
+static unsigned int available = 0;        /* Counters that could be opened */
+static pthread_mutex_t perfLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t perfCond = PTHREAD_COND_INITIALIZER;
+static perfGroup *groups = NULL;           /* Groups of running threads, for interval reports */
+static __thread perfGroup *threadGroup = NULL;
+static int reporting = 0;
+static pthread_t reporter;
+
+static int openCounter(int counter, int group)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = counters[counter].type;
+    attr.config = counters[counter].config;
+    attr.disabled = group < 0;
+    attr.exclude_hv = 1;
+    attr.exclude_kernel = excludeKernel;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static int readParanoid(void)
+{
+    FILE *f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    int value = -1;
+
+    if (f) {
+        if (fscanf(f, "%d", &value) != 1) {
+            value = -1;
+        }
+        fclose(f);
+    }
+    return value;
+}
+
+/* Find out which counters can be opened, and whether kernel time can be
+ * counted. When none can, --perf is switched off and the run continues. */
+int ddsbench_perfInit(void)
+{
+    int paranoid = readParanoid(), i, fd;
+
+    if (!ddsbench_perf) {
+        return 0;
+    }
+
+    for (i = 0; i < DDSBENCH_PERF_COUNTERS; i++) {
+        if ((fd = openCounter(i, -1)) < 0 && (errno == EACCES || errno == EPERM) && !excludeKernel) {
+            excludeKernel = 1;
+            fd = openCounter(i, -1);
+        }
+        if (fd >= 0) {
+            available |= 1 << i;
+            close(fd);
+        } else {
+            printf("perf: %s not available: %s\n", counters[i].name, strerror(errno));
+        }
+    }
+
+    if (!available) {
+        printf("perf: no hardware counters available (perf_event_paranoid = %d), continuing without\n", paranoid);
+        ddsbench_perf = 0;
+    } else if (excludeKernel) {
+        printf("perf: counting user space only (perf_event_paranoid = %d)\n", paranoid);
+    }
+
+    return 0;
+}
+
+void ddsbench_perfOpen(ddsbench_threadArg *arg)
+{
+    perfGroup *group;
+    int i;
+
+    if (!ddsbench_perf || !(group = calloc(1, sizeof(perfGroup)))) {
+        return;
+    }
+
+    group->leader = -1;
+    group->arg = arg;
+    for (i = 0; i < DDSBENCH_PERF_COUNTERS; i++) {
+        group->fd[i] = -1;
+        if (!(available & (1 << i))) {
+            continue;
+        }
+        if ((group->fd[i] = openCounter(i, group->leader)) < 0) {
+            continue;
+        }
+        if (group->leader < 0) {
+            group->leader = group->fd[i];
+        }
+        group->index[i] = group->count++;
+    }
+    if (group->leader < 0) {
+        free(group);
+        return;
+    }
+
+    threadGroup = group;
+    pthread_mutex_lock(&perfLock);
+    group->next = groups;
+    groups = group;
+    pthread_mutex_unlock(&perfLock);
+}
+
+void ddsbench_perfEnable(void)
+{
+    if (threadGroup) {
+        ioctl(threadGroup->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(threadGroup->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        threadGroup->arg->result.perfMask = available;
+    }
+}
+
+/* Read a group, scaled up when the counters were multiplexed */
+static int readGroup(perfGroup *group, unsigned long long *values)
+{
+    unsigned long long buf[3 + DDSBENCH_PERF_COUNTERS];
+    double scale = 1;
+    int i;
+
+    if (read(group->leader, buf, sizeof(buf)) < (ssize_t)((3 + group->count) * sizeof(unsigned long long))) {
+        return -1;
+    }
+    if (buf[2] && buf[2] < buf[1]) {
+        scale = (double)buf[1] / buf[2];
+    }
+    for (i = 0; i < DDSBENCH_PERF_COUNTERS; i++) {
+        values[i] = group->fd[i] >= 0 ? buf[3 + group->index[i]] * scale : 0;
+    }
+    return 0;
+}
+
+void ddsbench_perfClose(ddsbench_threadArg *arg)
+{
+    perfGroup *group = threadGroup, **ptr;
+    int i;
+
+    if (!group) {
+        return;
+    }
+
+    ioctl(group->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (arg->result.perfMask && readGroup(group, arg->result.perf)) {
+        arg->result.perfMask = 0;
+    }
+
+    /* Unregister before the arg goes away, the reporter reads it */
+    pthread_mutex_lock(&perfLock);
+    for (ptr = &groups; *ptr != group; ptr = &(*ptr)->next);
+    *ptr = group->next;
+    pthread_mutex_unlock(&perfLock);
+
+    for (i = 0; i < DDSBENCH_PERF_COUNTERS; i++) {
+        if (group->fd[i] >= 0) {
+            close(group->fd[i]);
+        }
+    }
+    free(group);
+    threadGroup = NULL;
+}
+
+/* Per role counters of the last interval, per sample */
+static void printInterval(const char *role, unsigned long long samples, const unsigned long long *delta)
+{
+    printf("perf: %s %9.2f IPC %10.1f cycles/sample %10.1f instr/sample %8.2f L1d/sample %8.2f LLC/sample %8.2f brmiss/sample\n",
+        role, delta[DDSBENCH_PERF_CYCLES] ? (double)delta[DDSBENCH_PERF_INSTRUCTIONS] / delta[DDSBENCH_PERF_CYCLES] : 0,
+        (double)delta[DDSBENCH_PERF_CYCLES] / samples, (double)delta[DDSBENCH_PERF_INSTRUCTIONS] / samples,
+        (double)delta[DDSBENCH_PERF_L1D_MISSES] / samples, (double)delta[DDSBENCH_PERF_LLC_MISSES] / samples,
+        (double)delta[DDSBENCH_PERF_BRANCH_MISSES] / samples);
+}
+
+static void* reportMain(void *ptr)
+{
+    struct timespec deadline;
+    perfGroup *group;
+    int i;
+
+    (void)ptr;
+    ddsbench_allocIgnore();
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    pthread_mutex_lock(&perfLock);
+    while (reporting) {
+        unsigned long long delta[2][DDSBENCH_PERF_COUNTERS], samples[2] = {0, 0}, values[DDSBENCH_PERF_COUNTERS];
+
+        deadline.tv_sec++;
+        if (!pthread_cond_timedwait(&perfCond, &perfLock, &deadline) || !reporting) {
+            continue;
+        }
+
+        /* Samples are read while threads update them, which is good enough for an interval */
+        memset(delta, 0, sizeof(delta));
+        for (group = groups; group; group = group->next) {
+            ddsbench_role role = group->arg->role;
+            unsigned long long current = group->arg->result.samples;
+            if (!group->arg->result.perfMask || readGroup(group, values)) {
+                continue;
+            }
+            for (i = 0; i < DDSBENCH_PERF_COUNTERS; i++) {
+                delta[role][i] += values[i] - group->prev[i];
+                group->prev[i] = values[i];
+            }
+            samples[role] += current - group->prevSamples;
+            group->prevSamples = current;
+        }
+
+        if (samples[DDSBENCH_PUBLISHER]) {
+            printInterval("pub", samples[DDSBENCH_PUBLISHER], delta[DDSBENCH_PUBLISHER]);
+        }
+        if (samples[DDSBENCH_SUBSCRIBER]) {
+            printInterval("sub", samples[DDSBENCH_SUBSCRIBER], delta[DDSBENCH_SUBSCRIBER]);
+        }
+    }
+    pthread_mutex_unlock(&perfLock);
+
+    return NULL;
+}
+
+void ddsbench_perfReportStart(void)
+{
+    if (!ddsbench_perf) {
+        return;
+    }
+    reporting = 1;
+    if (pthread_create(&reporter, NULL, reportMain, NULL)) {
+        printf("perf: failed to start interval reporter: %s\n", strerror(errno));
+        reporting = 0;
+    }
+}
+
+void ddsbench_perfReportStop(void)
+{
+    pthread_mutex_lock(&perfLock);
+    if (!reporting) {
+        pthread_mutex_unlock(&perfLock);
+        return;
+    }
+    reporting = 0;
+    pthread_cond_broadcast(&perfCond);
+    pthread_mutex_unlock(&perfLock);
+    pthread_join(reporter, NULL);
+}
+
+static void printValue(unsigned int mask, int counter, double value, double per)
+{
+    if (!(mask & (1 << counter)) || !per) {
+        printf(" %10s", "-");
+    } else {
+        printf(" %10.2f", value / per);
+    }
+}
+
+void ddsbench_printPerf(ddsbench_threadArg *args, int count)
+{
+    int i, reported = 0;
+
+    if (!ddsbench_perf) {
+        return;
+    }
+
+    printf("\n");
+    printf("Hardware counters (from the start barrier, %s)\n", excludeKernel ? "user space only" : "user and kernel");
+    printf("ddsbench: %-8s %10s %10s %6s %10s %10s %10s %10s %10s %10s %10s\n",
+        "thread", "Mcycles", "Minstr", "IPC", "cyc/sample", "ins/sample", "L1d/sample",
+        "LLC/sample", "brm/sample", "cyc/byte", "ins/byte");
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        unsigned long long bytes = r->bytes ? r->bytes : r->samples * (args[i].ctx->payload + 8);
+        char thread[16];
+
+        if (!r->perfMask) {
+            continue;
+        }
+        sprintf(thread, "%s %d", args[i].role == DDSBENCH_PUBLISHER ? "pub" : "sub", args[i].id);
+        printf("ddsbench: %-8s %10.1f %10.1f %6.2f", thread,
+            r->perf[DDSBENCH_PERF_CYCLES] / 1000000.0, r->perf[DDSBENCH_PERF_INSTRUCTIONS] / 1000000.0,
+            r->perf[DDSBENCH_PERF_CYCLES] ? (double)r->perf[DDSBENCH_PERF_INSTRUCTIONS] / r->perf[DDSBENCH_PERF_CYCLES] : 0);
+        printValue(r->perfMask, DDSBENCH_PERF_CYCLES, r->perf[DDSBENCH_PERF_CYCLES], r->samples);
+        printValue(r->perfMask, DDSBENCH_PERF_INSTRUCTIONS, r->perf[DDSBENCH_PERF_INSTRUCTIONS], r->samples);
+        printValue(r->perfMask, DDSBENCH_PERF_L1D_MISSES, r->perf[DDSBENCH_PERF_L1D_MISSES], r->samples);
+        printValue(r->perfMask, DDSBENCH_PERF_LLC_MISSES, r->perf[DDSBENCH_PERF_LLC_MISSES], r->samples);
+        printValue(r->perfMask, DDSBENCH_PERF_BRANCH_MISSES, r->perf[DDSBENCH_PERF_BRANCH_MISSES], r->samples);
+        printValue(r->perfMask, DDSBENCH_PERF_CYCLES, r->perf[DDSBENCH_PERF_CYCLES], bytes);
+        printValue(r->perfMask, DDSBENCH_PERF_INSTRUCTIONS, r->perf[DDSBENCH_PERF_INSTRUCTIONS], bytes);
+        printf("\n");
+        reported++;
+    }
+
+    if (!reported) {
+        printf("ddsbench: no thread crossed the start barrier with counters enabled\n");
+    }
+}
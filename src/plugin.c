@@ -0,0 +1,397 @@
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "core.h"
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+/* Directories that are searched for plugins, in order */
+#define DDSBENCH_MAX_PLUGINDIRS 32
+
+char *ddsbench_libpath = NULL;
+
+static const char *capabilityNames[] = {
+    "loans", "filters", "listeners", "durability", "batching", "workers", "ddsi"
+};
+
+void ddsbench_pluginCapabilities(unsigned int capabilities, char *buf, size_t size)
+{
+    size_t length = 0;
+    int i;
+
+    buf[0] = '\0';
+    for (i = 0; i < (int)(sizeof(capabilityNames) / sizeof(capabilityNames[0])); i++) {
+        if (capabilities & (1u << i)) {
+            length += snprintf(buf + length, length < size ? size - length : 0, "%s%s",
+                length ? ", " : "", capabilityNames[i]);
+        }
+    }
+    if (!length) {
+        snprintf(buf, size, "none");
+    }
+}
+
+/* Add a directory, unless it is on the path already */
+static int addDir(char dirs[][PATH_MAX], int count, const char *dir, size_t length)
+{
+    int i;
+
+    if (!length || length >= PATH_MAX || count == DDSBENCH_MAX_PLUGINDIRS) {
+        return count;
+    }
+    for (i = 0; i < count; i++) {
+        if (strlen(dirs[i]) == length && !strncmp(dirs[i], dir, length)) {
+            return count;
+        }
+    }
+    memcpy(dirs[count], dir, length);
+    dirs[count][length] = '\0';
+    return count + 1;
+}
+
+/* Add the entries of a colon separated path */
+static int addPath(char dirs[][PATH_MAX], int count, const char *path)
+{
+    const char *ptr = path, *end;
+
+    while (ptr && *ptr) {
+        end = strchr(ptr, ':');
+        count = addDir(dirs, count, ptr, end ? (size_t)(end - ptr) : strlen(ptr));
+        ptr = end ? end + 1 : NULL;
+    }
+    return count;
+}
+
+/* The search path is --libpath, then DDSBENCH_PLUGIN_PATH, then the working
+ * directory, the directory of the executable and its ../lib/ddsbench */
+static int searchPath(char dirs[][PATH_MAX])
+{
+    char dir[PATH_MAX + 16], *slash;
+    ssize_t length;
+    int count = 0;
+
+    if (ddsbench_libpath) {
+        count = addPath(dirs, count, ddsbench_libpath);
+    }
+    if (getenv("DDSBENCH_PLUGIN_PATH")) {
+        count = addPath(dirs, count, getenv("DDSBENCH_PLUGIN_PATH"));
+    }
+    if (getcwd(dir, PATH_MAX)) {
+        count = addDir(dirs, count, dir, strlen(dir));
+    }
+    if ((length = readlink("/proc/self/exe", dir, PATH_MAX - 1)) > 0) {
+        dir[length] = '\0';
+        if ((slash = strrchr(dir, '/'))) {
+            *slash = '\0';
+            count = addDir(dirs, count, dir, strlen(dir));
+            strcat(dir, "/../lib/ddsbench");
+            count = addDir(dirs, count, dir, strlen(dir));
+        }
+    }
+    return count;
+}
+
+/* Whether a path was formatted without truncation, a candidate that does
+ * not fit is reported and skipped */
+static int pathFits(int length, const char *path, size_t size)
+{
+    if (length < 0 || (size_t)length >= size) {
+        printf("ddsbench: skipping %s..., the path is too long\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+/* A plugin is found as <dir>/<name>/lib<name>.so, the layout of the source
+ * tree, or as <dir>/lib<name>.so */
+static int findPlugin(const char *name, char *path, size_t size)
+{
+    char dirs[DDSBENCH_MAX_PLUGINDIRS][PATH_MAX];
+    int count = searchPath(dirs), i;
+
+    if (strchr(name, '/')) {
+        if (!pathFits(snprintf(path, size, "%s", name), path, size)) {
+            return -1;
+        }
+        return access(path, R_OK);
+    }
+    for (i = 0; i < count; i++) {
+        if (pathFits(snprintf(path, size, "%s/%s/lib%s.so", dirs[i], name, name), path, size) &&
+            !access(path, R_OK)) {
+            return 0;
+        }
+        if (pathFits(snprintf(path, size, "%s/lib%s.so", dirs[i], name), path, size) &&
+            !access(path, R_OK)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Plugins that predate the descriptor only export their functions. What
+ * they support is derived from the functions they have. */
+static const ddsbench_plugin* legacyPlugin(ddsbench_libraryInterface *interface, const char *name)
+{
+    ddsbench_plugin *plugin = &interface->descriptor;
+    void *lib = interface->lib;
+
+    memset(plugin, 0, sizeof(ddsbench_plugin));
+    plugin->name = name;
+    plugin->description = "legacy plugin without descriptor";
+    *(void **)&plugin->init = dlsym(lib, "init");
+    *(void **)&plugin->fini = dlsym(lib, "fini");
+    *(void **)&plugin->lpub = dlsym(lib, "lpub");
+    *(void **)&plugin->lsub = dlsym(lib, "lsub");
+    *(void **)&plugin->tpub = dlsym(lib, "tpub");
+    *(void **)&plugin->tsub = dlsym(lib, "tsub");
+    *(void **)&plugin->dpub = dlsym(lib, "dpub");
+    *(void **)&plugin->dsub = dlsym(lib, "dsub");
+    *(void **)&plugin->tworker = dlsym(lib, "tworker");
+    if (!plugin->init || !plugin->fini || !plugin->lpub || !plugin->lsub || !plugin->tpub || !plugin->tsub) {
+        return NULL;
+    }
+
+    /* Options were never checked against these, so they keep getting them */
+    plugin->version = DDSBENCH_PLUGIN_VERSION;
+    plugin->capabilities = DDSBENCH_CAP_LOANS | DDSBENCH_CAP_FILTERS | DDSBENCH_CAP_LISTENERS;
+    if (plugin->dpub && plugin->dsub) {
+        plugin->capabilities |= DDSBENCH_CAP_DURABILITY;
+    }
+    if (plugin->tworker) {
+        plugin->capabilities |= DDSBENCH_CAP_WORKERS;
+    }
+    return plugin;
+}
+
+/* Copy the descriptor of a plugin, which ends before ops in version 1, and
+ * its ops, which end before waitSetNew in version 2, and let the engine run
+ * the threads it has ops for */
+static void completeDescriptor(ddsbench_libraryInterface *interface, const ddsbench_plugin *from)
+{
+    ddsbench_plugin *to = &interface->descriptor;
+
+    memset(to, 0, sizeof(ddsbench_plugin));
+    memcpy(to, from, from->version < 2 ? offsetof(ddsbench_plugin, ops) : sizeof(ddsbench_plugin));
+    if (to->ops) {
+        memset(&interface->ops, 0, sizeof(ddsbench_ops));
+        memcpy(&interface->ops, to->ops, from->version < 3 ? offsetof(ddsbench_ops, waitSetNew) : sizeof(ddsbench_ops));
+        to->ops = &interface->ops;
+        to->lpub = to->lpub ? to->lpub : ddsbench_engineLpub;
+        to->lsub = to->lsub ? to->lsub : ddsbench_engineLsub;
+        to->tpub = to->tpub ? to->tpub : ddsbench_engineTpub;
+        to->tsub = to->tsub ? to->tsub : ddsbench_engineTsub;
+        to->tworker = to->tworker ? to->tworker : ddsbench_engineTworker;
+        to->capabilities |= DDSBENCH_CAP_WORKERS;
+        if (to->capabilities & DDSBENCH_CAP_DURABILITY) {
+            to->dpub = to->dpub ? to->dpub : ddsbench_engineDpub;
+            to->dsub = to->dsub ? to->dsub : ddsbench_engineDsub;
+        }
+    }
+}
+
+int ddsbench_pluginLoad(const char *name, ddsbench_libraryInterface *interface)
+{
+    const ddsbench_plugin *plugin;
+
+    memset(interface, 0, sizeof(ddsbench_libraryInterface));
+    if (findPlugin(name, interface->path, sizeof(interface->path))) {
+        throw("plugin %s not found, see ddsbench plugins\n", name);
+    }
+    if (!(interface->lib = dlopen(interface->path, RTLD_NOW))) {
+        throw("%s: %s\n", interface->path, dlerror());
+    }
+
+    if (!(plugin = dlsym(interface->lib, DDSBENCH_PLUGIN_SYMBOL)) &&
+        !(plugin = legacyPlugin(interface, name)))
+    {
+        throw("%s: not a ddsbench plugin\n", interface->path);
+    }
+    if (plugin->version < DDSBENCH_PLUGIN_VERSION_MIN || plugin->version > DDSBENCH_PLUGIN_VERSION) {
+        throw("%s: plugin version %u, ddsbench supports versions %d to %d\n",
+            interface->path, plugin->version, DDSBENCH_PLUGIN_VERSION_MIN, DDSBENCH_PLUGIN_VERSION);
+    }
+    if (plugin != &interface->descriptor) {
+        completeDescriptor(interface, plugin);
+        plugin = &interface->descriptor;
+    }
+    if (!plugin->init || !plugin->fini || !plugin->lpub || !plugin->lsub || !plugin->tpub || !plugin->tsub) {
+        throw("%s: incomplete plugin descriptor\n", interface->path);
+    }
+    if ((plugin->capabilities & DDSBENCH_CAP_DURABILITY) && (!plugin->dpub || !plugin->dsub)) {
+        throw("%s: durability capability without dpub and dsub\n", interface->path);
+    }
+    if ((plugin->capabilities & DDSBENCH_CAP_WORKERS) && !plugin->tworker) {
+        throw("%s: workers capability without tworker\n", interface->path);
+    }
+    interface->plugin = plugin;
+
+    return 0;
+error:
+    if (interface->lib) {
+        dlclose(interface->lib);
+        interface->lib = NULL;
+    }
+    return -1;
+}
+
+int ddsbench_pluginCheck(ddsbench_libraryInterface *interface, ddsbench_context *ctx)
+{
+    const ddsbench_plugin *plugin = interface->plugin;
+    unsigned int caps = plugin->capabilities;
+
+    if (ctx->take == DDSBENCH_TAKE_LOAN && !(caps & DDSBENCH_CAP_LOANS)) {
+        throw("%s does not support --take loan\n", plugin->name);
+    }
+    if (ctx->filter && !ctx->localfilter && !(caps & DDSBENCH_CAP_FILTERS) && strcmp(ddsbench_mode, "filter")) {
+        throw("%s does not filter in the middleware, use --filterin local\n", plugin->name);
+    }
+    if (!strcmp(ddsbench_mode, "durability") && !(caps & DDSBENCH_CAP_DURABILITY)) {
+        throw("%s does not support durability mode\n", plugin->name);
+    }
+    if (ddsbench_workers && !(caps & DDSBENCH_CAP_WORKERS)) {
+        throw("%s does not support --workers\n", plugin->name);
+    }
+    if (ctx->batch && !(caps & DDSBENCH_CAP_BATCHING)) {
+        throw("%s does not support --batch\n", plugin->name);
+    }
+    if (!ctx->pollingdelay && !(caps & DDSBENCH_CAP_LISTENERS) && strcmp(ddsbench_mode, "latency")) {
+        printf("Note: %s has no listeners, with --pollingdelay 0 subscribers block until data arrives.\n", plugin->name);
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+int ddsbench_pluginOpen(const char *name, ddsbench_context *ctx, ddsbench_libraryInterface *interface)
+{
+    char caps[256];
+
+    if (ddsbench_pluginLoad(name, interface)) {
+        goto error;
+    }
+    ddsbench_pluginCapabilities(interface->plugin->capabilities, caps, sizeof(caps));
+    printf("  plugin: %s, %s (%s)\n", interface->plugin->name, interface->plugin->description, interface->path);
+    printf("  capabilities: %s\n", caps);
+
+    /* Options the plugin does not support are refused before it initializes */
+    if (ddsbench_pluginCheck(interface, ctx) || interface->plugin->init(ctx)) {
+        dlclose(interface->lib);
+        interface->lib = NULL;
+        goto error;
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+void ddsbench_pluginClose(ddsbench_libraryInterface *interface)
+{
+    if (interface->lib) {
+        interface->plugin->fini();
+        dlclose(interface->lib);
+        interface->lib = NULL;
+    }
+}
+
+/* Print a plugin found at path, unless it was printed before. Returns
+ * nonzero if path is a plugin. */
+static int listPlugin(const char *path, char seen[][PATH_MAX], int *numSeen)
+{
+    const ddsbench_plugin *plugin;
+    char real[PATH_MAX], caps[256];
+    void *lib;
+    int i;
+
+    if (!realpath(path, real)) {
+        return 0;
+    }
+    for (i = 0; i < *numSeen; i++) {
+        if (!strcmp(seen[i], real)) {
+            return 0;
+        }
+    }
+    if (*numSeen < DDSBENCH_MAX_PLUGINDIRS * 4) {
+        strcpy(seen[(*numSeen)++], real);
+    }
+
+    if (!(lib = dlopen(real, RTLD_LAZY | RTLD_LOCAL))) {
+        printf("  %-10s %s\n             cannot be loaded: %s\n", "?", real, dlerror());
+        return 1;
+    }
+    if ((plugin = dlsym(lib, DDSBENCH_PLUGIN_SYMBOL))) {
+        /* The engine runs the worker pool of every plugin with ops, see completeDescriptor */
+        ddsbench_pluginCapabilities(plugin->capabilities |
+            (plugin->version >= 2 && plugin->ops ? DDSBENCH_CAP_WORKERS : 0), caps, sizeof(caps));
+        printf("  %-10s %s\n             version %u%s, %s\n             capabilities: %s\n",
+            plugin->name, real, plugin->version,
+            plugin->version >= DDSBENCH_PLUGIN_VERSION_MIN && plugin->version <= DDSBENCH_PLUGIN_VERSION ?
+                (plugin->version >= 2 && plugin->ops ? ", engine" : "") : " (not supported)",
+            plugin->description, caps);
+    } else if (dlsym(lib, "tpub")) {
+        printf("  %-10s %s\n             legacy plugin without descriptor\n", "?", real);
+    } else {
+        dlclose(lib);
+        return 0;
+    }
+    dlclose(lib);
+    return 1;
+}
+
+int ddsbench_pluginList(void)
+{
+    char dirs[DDSBENCH_MAX_PLUGINDIRS][PATH_MAX], path[PATH_MAX];
+    char (*seen)[PATH_MAX] = malloc(DDSBENCH_MAX_PLUGINDIRS * 4 * PATH_MAX);
+    int count = searchPath(dirs), numSeen = 0, found = 0, i;
+
+    if (!seen) {
+        printf("error: out of memory\n");
+        return -1;
+    }
+
+    printf("Plugins (ddsbench plugin version %d)\n", DDSBENCH_PLUGIN_VERSION);
+    for (i = 0; i < count; i++) {
+        struct dirent *entry;
+        struct stat st;
+        DIR *dir;
+        printf("search %s\n", dirs[i]);
+        if (!(dir = opendir(dirs[i]))) {
+            continue;
+        }
+        while ((entry = readdir(dir))) {
+            size_t length = strlen(entry->d_name);
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            if (!pathFits(snprintf(path, sizeof(path), "%s/%s", dirs[i], entry->d_name), path, sizeof(path))) {
+                continue;
+            }
+            if (!stat(path, &st) && S_ISDIR(st.st_mode)) {
+                if (pathFits(snprintf(path, sizeof(path), "%s/%s/lib%s.so", dirs[i], entry->d_name, entry->d_name),
+                        path, sizeof(path)) && !access(path, R_OK)) {
+                    found += listPlugin(path, seen, &numSeen);
+                }
+            } else if (length > 6 && !strncmp(entry->d_name, "lib", 3) && !strcmp(entry->d_name + length - 3, ".so")) {
+                found += listPlugin(path, seen, &numSeen);
+            }
+        }
+        closedir(dir);
+    }
+    if (!found) {
+        printf("no plugins found, build them or set DDSBENCH_PLUGIN_PATH\n");
+    }
+
+    free(seen);
+    return 0;
+}
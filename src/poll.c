@@ -0,0 +1,76 @@
+
+#include <stdio.h>
+#include <sched.h>
+
+#include "core.h"
+
+static void relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+void ddsbench_pollInit(ddsbench_poll *poll, ddsbench_context *ctx, ddsbench_threadResult *result)
+{
+    poll->mode = ctx->recv;
+    poll->budgetNs = (unsigned long long)ctx->spin * 1000ULL;
+    poll->idleStart = 0;
+    poll->result = result;
+}
+
+int ddsbench_pollBlock(ddsbench_poll *poll)
+{
+    int block;
+
+    switch (poll->mode) {
+    case DDSBENCH_RECV_SPIN:
+        block = 0;
+        break;
+    case DDSBENCH_RECV_HYBRID:
+        /* Block when the spin and the yield budget are both used up */
+        block = poll->idleStart && ddsbench_time() - poll->idleStart >= 2 * poll->budgetNs;
+        break;
+    default:
+        block = 1;
+        break;
+    }
+
+    if (block) {
+        poll->result->blocks++;
+    }
+    return block;
+}
+
+int ddsbench_pollTaken(ddsbench_poll *poll, int count)
+{
+    unsigned long long now;
+
+    if (count > 0) {
+        poll->idleStart = 0;
+        return 1;
+    }
+    if (poll->mode == DDSBENCH_RECV_BLOCK) {
+        return 0;
+    }
+
+    poll->result->emptyTakes++;
+    now = ddsbench_time();
+    if (!poll->idleStart) {
+        poll->idleStart = now;
+    }
+
+    if (poll->mode == DDSBENCH_RECV_SPIN || now - poll->idleStart < poll->budgetNs) {
+        relax();
+    } else {
+        sched_yield();
+        poll->result->yields++;
+    }
+
+    return 0;
+}
+
+unsigned long long ddsbench_pollIdle(ddsbench_poll *poll)
+{
+    return poll->idleStart ? ddsbench_time() - poll->idleStart : 0;
+}
@@ -0,0 +1,287 @@
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "core.h"
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+/* Resolution of the pacing wheel */
+#define DDSBENCH_WHEEL_TICK 100000ULL
+
+int ddsbench_workers = 0;
+
+typedef struct ddsbench_workerStart {
+    ddsbench_worker worker;
+    ddsbench_workerFn fn;
+    unsigned long long cpuNs;
+    int status;                     /* Value the worker function returned */
+} ddsbench_workerStart;
+
+static void wheelInsert(ddsbench_wheel *wheel, int entry)
+{
+    unsigned long long tick = wheel->due[entry] / wheel->tickNs;
+    int slot;
+
+    /* Entries that are already late go in the slot that is being expired */
+    if (tick < wheel->cursor) {
+        tick = wheel->cursor;
+    }
+    slot = tick % wheel->slots;
+
+    wheel->next[entry] = -1;
+    if (wheel->head[slot] < 0) {
+        wheel->head[slot] = entry;
+    } else {
+        wheel->next[wheel->tail[slot]] = entry;
+    }
+    wheel->tail[slot] = entry;
+}
+
+int ddsbench_wheelInit(ddsbench_wheel *wheel, int count, unsigned long long intervalNs, unsigned long long now)
+{
+    int i;
+
+    memset(wheel, 0, sizeof(ddsbench_wheel));
+    wheel->intervalNs = intervalNs;
+    wheel->tickNs = DDSBENCH_WHEEL_TICK;
+    wheel->cursor = now / wheel->tickNs;
+
+    /* A wheel that spans one interval (and a tick of slack) holds every
+     * deadline, so that entries never wait for a full revolution */
+    wheel->slots = intervalNs / wheel->tickNs + 2;
+
+    wheel->head = malloc(wheel->slots * sizeof(int));
+    wheel->tail = malloc(wheel->slots * sizeof(int));
+    wheel->next = malloc((count ? count : 1) * sizeof(int));
+    wheel->due = malloc((count ? count : 1) * sizeof(unsigned long long));
+    if (!wheel->head || !wheel->tail || !wheel->next || !wheel->due) {
+        ddsbench_wheelFree(wheel);
+        return -1;
+    }
+
+    for (i = 0; i < wheel->slots; i++) {
+        wheel->head[i] = -1;
+    }
+    for (i = 0; i < count; i++) {
+        wheel->due[i] = now + intervalNs * i / count;
+        wheelInsert(wheel, i);
+    }
+
+    return 0;
+}
+
+void ddsbench_wheelFree(ddsbench_wheel *wheel)
+{
+    free(wheel->head);
+    free(wheel->tail);
+    free(wheel->next);
+    free(wheel->due);
+    memset(wheel, 0, sizeof(ddsbench_wheel));
+}
+
+int ddsbench_wheelPop(ddsbench_wheel *wheel, unsigned long long now, unsigned long long *waitNs)
+{
+    unsigned long long tick = now / wheel->tickNs;
+    int slot, prev, entry, i;
+
+    /* After a stall only the last revolution can hold entries */
+    if (tick > wheel->cursor + wheel->slots) {
+        wheel->cursor = tick - wheel->slots;
+    }
+
+    for (;;) {
+        slot = wheel->cursor % wheel->slots;
+        for (prev = -1, entry = wheel->head[slot]; entry >= 0; prev = entry, entry = wheel->next[entry]) {
+            if (wheel->due[entry] <= now) {
+                if (prev < 0) {
+                    wheel->head[slot] = wheel->next[entry];
+                } else {
+                    wheel->next[prev] = wheel->next[entry];
+                }
+                if (wheel->tail[slot] == entry) {
+                    wheel->tail[slot] = prev;
+                }
+                return entry;
+            }
+        }
+        if (wheel->cursor >= tick) {
+            break;
+        }
+        wheel->cursor++;
+    }
+
+    /* Nothing is due, wait until the next slot that holds an entry */
+    for (i = 1; i < wheel->slots && wheel->head[(wheel->cursor + i) % wheel->slots] < 0; i++);
+    *waitNs = (wheel->cursor + i) * wheel->tickNs - now;
+
+    return -1;
+}
+
+void ddsbench_wheelPush(ddsbench_wheel *wheel, int entry, unsigned long long now)
+{
+    /* A writer that fell more than an interval behind does not catch up */
+    wheel->due[entry] += wheel->intervalNs;
+    if (wheel->due[entry] + wheel->intervalNs < now) {
+        wheel->due[entry] = now;
+    }
+    wheelInsert(wheel, entry);
+}
+
+static void* workerMain(void *ptr)
+{
+    ddsbench_workerStart *start = ptr;
+    int i;
+
+    for (i = 0; i < start->worker.count; i++) {
+        start->worker.args[i]->startNs = ddsbench_time();
+        start->worker.args[i]->tid = syscall(SYS_gettid);
+    }
+    start->cpuNs = ddsbench_cpuTime(1);
+    start->status = start->fn(&start->worker);
+    start->cpuNs = ddsbench_cpuTime(1) - start->cpuNs;
+    for (i = 0; i < start->worker.count; i++) {
+        start->worker.args[i]->status = start->status;
+    }
+
+    return NULL;
+}
+
+/* Number of cpus this process may run on */
+static int numCpus(void)
+{
+    cpu_set_t available;
+
+    if (sched_getaffinity(0, sizeof(available), &available)) {
+        return 1;
+    }
+    return CPU_COUNT(&available);
+}
+
+static void printWorkers(ddsbench_workerStart *starts, int count)
+{
+    int w, i;
+
+    printf("\n");
+    printf("Worker pool (cpu includes entity creation)\n");
+    printf("pool: %6s %9s %11s %11s %10s %12s\n",
+        "worker", "endpoints", "written", "received", "cpu[ms]", "cpu/sample");
+    for (w = 0; w < count; w++) {
+        ddsbench_worker *worker = &starts[w].worker;
+        unsigned long long written = 0, received = 0;
+        for (i = 0; i < worker->count; i++) {
+            if (worker->args[i]->role == DDSBENCH_PUBLISHER) {
+                written += worker->args[i]->result.samples;
+            } else {
+                received += worker->args[i]->result.samples;
+            }
+        }
+        printf("pool: %6d %9d %11llu %11llu %10.1f %9.2f us\n",
+            w, worker->count, written, received, starts[w].cpuNs / 1000000.0,
+            written + received ? (double)starts[w].cpuNs / (written + received) / 1000.0 : 0);
+    }
+}
+
+/* Worker of endpoint e, args hold perTopic endpoints for every topic */
+static int endpointWorker(int e, int perTopic, int workers)
+{
+    return (e / perTopic + e % perTopic) % workers;
+}
+
+int ddsbench_runPool(ddsbench_libraryInterface *interface, ddsbench_context *ctx, ddsbench_threadArg *args, int count)
+{
+    ddsbench_workerStart *starts = NULL;
+    ddsbench_threadArg **endpoints = NULL;
+    pthread_t *threads = NULL;
+    pthread_attr_t attr;
+    int workers = ddsbench_workers < 0 ? numCpus() : ddsbench_workers;
+    int perTopic = ddsbench_numsub + ddsbench_numpub;
+    int started = 0, w, e, i, cpu, node;
+    char name[64];
+
+    if (workers > count) {
+        workers = count;
+    }
+
+    starts = calloc(workers, sizeof(ddsbench_workerStart));
+    endpoints = malloc(count * sizeof(ddsbench_threadArg*));
+    threads = malloc(workers * sizeof(pthread_t));
+    if (!starts || !endpoints || !threads) throw("out of memory\n");
+    if (!(ctx->start = ddsbench_barrierNew(workers))) throw("out of memory\n");
+
+    /* The endpoints of a topic (its subscribers, then its publishers) are
+     * dealt to consecutive workers, so that its publishers and subscribers
+     * end up on different workers. The first worker moves on by one for
+     * every topic, so that every worker serves publishers and subscribers
+     * alike, which plain round-robin over all endpoints would split by role
+     * with an even number of workers. */
+    for (e = 0; e < count; e++) {
+        starts[endpointWorker(e, perTopic, workers)].worker.count++;
+    }
+    for (w = 0, i = 0; w < workers; w++) {
+        starts[w].worker.id = w;
+        starts[w].worker.ctx = ctx;
+        starts[w].worker.args = &endpoints[i];
+        starts[w].fn = interface->plugin->tworker;
+        i += starts[w].worker.count;
+        starts[w].worker.count = 0;
+    }
+    for (e = 0; e < count; e++) {
+        ddsbench_worker *worker = &starts[endpointWorker(e, perTopic, workers)].worker;
+        worker->args[worker->count++] = &args[e];
+    }
+
+    printf("ddsbench: %d workers, %d endpoints each\n", workers, (count + workers - 1) / workers);
+
+    for (w = 0; w < workers; w++) {
+        sprintf(name, "worker %d", w);
+        pthread_attr_init(&attr);
+        if (ddsbench_affinityApply(&attr, w, w, name, &cpu, &node)) {
+            pthread_attr_destroy(&attr);
+            goto error;
+        }
+        for (i = 0; i < starts[w].worker.count; i++) {
+            starts[w].worker.args[i]->cpu = cpu;
+            starts[w].worker.args[i]->node = node;
+        }
+        if (pthread_create(&threads[w], &attr, workerMain, &starts[w])) {
+            pthread_attr_destroy(&attr);
+            throw("failed to create worker: %s\n", strerror(errno));
+        }
+        pthread_attr_destroy(&attr);
+        started++;
+    }
+
+    for (w = 0; w < started; w++) {
+        if (pthread_join(threads[w], NULL)) {
+            throw("failed to join worker %d: %s\n", w, strerror(errno));
+        }
+    }
+
+    printWorkers(starts, workers);
+
+    ddsbench_barrierFree(ctx->start);
+    ctx->start = NULL;
+    free(starts);
+    free(endpoints);
+    free(threads);
+    return 0;
+error:
+    for (w = 0; w < started; w++) {
+        pthread_join(threads[w], NULL);
+    }
+    ddsbench_barrierFree(ctx->start);
+    ctx->start = NULL;
+    free(starts);
+    free(endpoints);
+    free(threads);
+    return -1;
+}
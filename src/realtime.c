@@ -0,0 +1,122 @@
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <malloc.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+
+#include "core.h"
+
+/* SCHED_FIFO priorities of the roles. In latency mode the subscriber is the
+ * ping and the publisher the pong, the main thread reports results. */
+#define DDSBENCH_RT_PING 90
+#define DDSBENCH_RT_PONG 89
+#define DDSBENCH_RT_REPORTER 50
+
+/* Stack that is touched before the benchmark runs */
+#define DDSBENCH_RT_STACK (256 * 1024)
+
+/* Timer slack in nanoseconds */
+#define DDSBENCH_RT_SLACK 1
+
+int ddsbench_rt = 0;
+
+/* Touch the stack, so that it does not fault while measuring */
+static void prefaultStack(void)
+{
+    volatile char stack[DDSBENCH_RT_STACK];
+    memset((char*)stack, 0, sizeof(stack));
+}
+
+/* Apply and verify the scheduling policy and timer slack of the calling thread */
+static void setThread(const char *name, int priority)
+{
+    struct sched_param param = { .sched_priority = priority };
+    char sched[64], slack[64];
+    int policy, result;
+
+    if ((result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param))) {
+        sprintf(sched, "not SCHED_FIFO (%s)", strerror(result));
+    } else if (pthread_getschedparam(pthread_self(), &policy, &param) || policy != SCHED_FIFO) {
+        sprintf(sched, "not SCHED_FIFO (not applied)");
+    } else {
+        sprintf(sched, "SCHED_FIFO %d", param.sched_priority);
+    }
+
+    if (prctl(PR_SET_TIMERSLACK, DDSBENCH_RT_SLACK, 0, 0, 0)) {
+        sprintf(slack, "timerslack not set (%s)", strerror(errno));
+    } else {
+        sprintf(slack, "timerslack %d ns", prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0));
+    }
+
+    printf("ddsbench: rt: %s: %s, %s\n", name, sched, slack);
+}
+
+int ddsbench_rtInit(void)
+{
+    struct rlimit memlock;
+
+    if (!ddsbench_rt) {
+        return 0;
+    }
+
+    /* Keep freed memory in the process, so that reused heap does not fault */
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+        getrlimit(RLIMIT_MEMLOCK, &memlock);
+        printf("ddsbench: rt: mlockall failed (%s), memlock limit is %llu kB\n",
+            strerror(errno), (unsigned long long)memlock.rlim_cur / 1024);
+    } else {
+        printf("ddsbench: rt: mlockall: all current and future memory locked\n");
+    }
+
+    prefaultStack();
+    setThread("reporter", DDSBENCH_RT_REPORTER);
+
+    return 0;
+}
+
+void ddsbench_rtThreadStart(ddsbench_threadArg *arg, long *faults)
+{
+    struct rusage usage;
+    char name[64];
+    int ping = arg->role == DDSBENCH_SUBSCRIBER;
+
+    if (!ddsbench_rt) {
+        return;
+    }
+
+    if (!strcmp(ddsbench_mode, "latency")) {
+        sprintf(name, "%s %d (%s)", ping ? "sub" : "pub", arg->id, ping ? "ping" : "pong");
+    } else {
+        sprintf(name, "%s %d", ping ? "sub" : "pub", arg->id);
+    }
+    setThread(name, ping ? DDSBENCH_RT_PING : DDSBENCH_RT_PONG);
+    prefaultStack();
+
+    getrusage(RUSAGE_THREAD, &usage);
+    *faults = usage.ru_minflt + usage.ru_majflt;
+}
+
+void ddsbench_rtThreadStop(ddsbench_threadArg *arg, long faults)
+{
+    struct rusage usage;
+
+    if (!ddsbench_rt) {
+        return;
+    }
+
+    /* Faults include the ones taken while the product creates its entities */
+    getrusage(RUSAGE_THREAD, &usage);
+    printf("ddsbench: rt: %s %d: %ld page faults while running\n",
+        arg->role == DDSBENCH_SUBSCRIBER ? "sub" : "pub", arg->id,
+        usage.ru_minflt + usage.ru_majflt - faults);
+}
@@ -0,0 +1,402 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+
+/** Error reporting */
+#define throw(...) { printf("error: " __VA_ARGS__); goto error; }
+
+/** ddsbench tune options */
+int ddsbench_tune = 0;
+int ddsbench_rounds = 3;
+int ddsbench_repeats = 3;
+
+/* A candidate replaces the best configuration when it is this much better,
+ * so that the noise of short trials does not make the search wander */
+#define DDSBENCH_TUNE_MARGIN 0.02
+
+#define DDSBENCH_TUNE_KNOBS 4
+#define DDSBENCH_TUNE_MAX_VALUES 5
+
+/* A DDSI2Service setting the search varies, with the candidates in the
+ * notation of the configuration. Base is the value of ospl.xml. */
+typedef struct ddsbench_tuneKnob {
+    const char *name;               /* Element, as it is reported */
+    const char *env;                /* Variable the ospl plugin reads it from */
+    const char *values[DDSBENCH_TUNE_MAX_VALUES];
+    int count;
+    int base;
+} ddsbench_tuneKnob;
+
+enum { KNOB_WHCHIGH, KNOB_MAXMESSAGESIZE, KNOB_FRAGMENTSIZE, KNOB_MCLOOPBACK };
+
+static const ddsbench_tuneKnob knobs[DDSBENCH_TUNE_KNOBS] = {
+    {"WhcHigh", "DDSBENCH_OSPL_WHCHIGH", {"100 kB", "200 kB", "400 kB", "800 kB", "2 MB"}, 5, 2},
+    {"MaxMessageSize", "DDSBENCH_OSPL_MAXMESSAGESIZE", {"8 kB", "16 kB", "32 kB", "62 kB"}, 4, 3},
+    {"FragmentSize", "DDSBENCH_OSPL_FRAGMENTSIZE", {"1300 B", "4 kB", "16 kB", "30 kB", "60 kB"}, 5, 4},
+    {"EnableMulticastLoopback", "DDSBENCH_OSPL_MCLOOPBACK", {"true", "false"}, 2, 0}
+};
+
+/* Every combination of candidates, indexed by configKey */
+#define DDSBENCH_TUNE_CONFIGS (5 * 4 * 5 * 2)
+
+/* A measured configuration */
+typedef struct ddsbench_tuneTrial {
+    int config[DDSBENCH_TUNE_KNOBS];    /* Index of the value of every knob */
+    int failed;
+    double score;                       /* Median over the repeats of the samples/s for throughput,
+                                         * or of the median round trip in ns for latency */
+} ddsbench_tuneTrial;
+
+typedef struct ddsbench_tuneState {
+    ddsbench_context *ctx;
+    int argc;
+    char **argv;
+    int latency;                        /* Lower scores are better */
+    ddsbench_tuneTrial trials[DDSBENCH_TUNE_CONFIGS];
+    int count;
+    int measured[DDSBENCH_TUNE_CONFIGS]; /* Trial of a configuration plus one, 0 when not run */
+} ddsbench_tuneState;
+
+static int configKey(const int *config)
+{
+    int i, key = 0;
+    for (i = DDSBENCH_TUNE_KNOBS - 1; i >= 0; i--) {
+        key = key * knobs[i].count + config[i];
+    }
+    return key;
+}
+
+/* Bytes of a size like '400 kB' */
+static double sizeBytes(const char *value)
+{
+    char *unit;
+    double size = strtod(value, &unit);
+
+    while (*unit == ' ') {
+        unit++;
+    }
+    if (!strcmp(unit, "kB") || !strcmp(unit, "KiB")) {
+        size *= 1024;
+    } else if (!strcmp(unit, "MB") || !strcmp(unit, "MiB")) {
+        size *= 1024 * 1024;
+    }
+    return size;
+}
+
+/* DDSI2 sends a fragment in a message, which it has to fit */
+static int configValid(const int *config)
+{
+    return sizeBytes(knobs[KNOB_FRAGMENTSIZE].values[config[KNOB_FRAGMENTSIZE]]) <
+        sizeBytes(knobs[KNOB_MAXMESSAGESIZE].values[config[KNOB_MAXMESSAGESIZE]]);
+}
+
+static void printConfig(const char *prefix, const int *config)
+{
+    printf("%s%s %s, %s %s, %s %s, multicast loopback %s", prefix,
+        knobs[KNOB_WHCHIGH].name, knobs[KNOB_WHCHIGH].values[config[KNOB_WHCHIGH]],
+        knobs[KNOB_MAXMESSAGESIZE].name, knobs[KNOB_MAXMESSAGESIZE].values[config[KNOB_MAXMESSAGESIZE]],
+        knobs[KNOB_FRAGMENTSIZE].name, knobs[KNOB_FRAGMENTSIZE].values[config[KNOB_FRAGMENTSIZE]],
+        knobs[KNOB_MCLOOPBACK].values[config[KNOB_MCLOOPBACK]]);
+}
+
+static void printScore(const ddsbench_tuneState *state, const ddsbench_tuneTrial *trial)
+{
+    if (trial->failed) {
+        printf("failed");
+    } else if (state->latency) {
+        printf("round trip p50 %.2f us", trial->score / 1000.0);
+    } else {
+        printf("%.2fK samples/s", trial->score / 1000.0);
+    }
+}
+
+/* Whether a is better than b by more than the margin */
+static int better(const ddsbench_tuneState *state, const ddsbench_tuneTrial *a, const ddsbench_tuneTrial *b)
+{
+    if (a->failed) {
+        return 0;
+    }
+    if (b->failed) {
+        return 1;
+    }
+    if (state->latency) {
+        return a->score < b->score * (1 - DDSBENCH_TUNE_MARGIN);
+    }
+    return a->score > b->score * (1 + DDSBENCH_TUNE_MARGIN);
+}
+
+/* Launch a configuration --repeats times and score it with the median. The
+ * throughput is the rate of the subscribers over their measurement windows,
+ * a launch that did not report one failed. A configuration fails when one
+ * of its launches does. */
+static void runTrial(ddsbench_tuneState *state, const char *label, ddsbench_tuneTrial *trial)
+{
+    char values[DDSBENCH_TUNE_KNOBS][64];
+    char *env[DDSBENCH_TUNE_KNOBS + 1];
+    double scores[DDSBENCH_TUNE_MAX_REPEATS], score;
+    ddsbench_launchResult result;
+    int i, j;
+
+    for (i = 0; i < DDSBENCH_TUNE_KNOBS; i++) {
+        snprintf(values[i], sizeof(values[i]), "%s=%s", knobs[i].env, knobs[i].values[trial->config[i]]);
+        env[i] = values[i];
+    }
+    env[i] = NULL;
+
+    printf("\n");
+    printf("tune: %s: ", label);
+    printConfig("", trial->config);
+    printf("\n");
+
+    trial->failed = 0;
+    for (i = 0; i < ddsbench_repeats && !ddsbench_launchInterrupted(); i++) {
+        if (ddsbench_launchTrial(state->ctx, state->argc, state->argv, env, &result)) {
+            trial->failed = 1;
+        } else if (state->latency) {
+            trial->failed = !result.roundTripNs.count;
+            score = ddsbench_histogramQuantile(&result.roundTripNs, 0.5);
+        } else {
+            trial->failed = result.rate <= 0;
+            score = result.rate;
+        }
+        if (trial->failed) {
+            break;
+        }
+
+        /* Insert in order */
+        for (j = i; j > 0 && scores[j - 1] > score; j--) {
+            scores[j] = scores[j - 1];
+        }
+        scores[j] = score;
+    }
+
+    /* An interrupted trial is scored on the launches it completed */
+    if (!i) {
+        trial->failed = 1;
+    } else if (!trial->failed) {
+        trial->score = i % 2 ? scores[i / 2] : (scores[i / 2 - 1] + scores[i / 2]) / 2;
+    }
+
+    printf("tune: %s: ", label);
+    printScore(state, trial);
+    if (!trial->failed && i > 1) {
+        printf(", median of %d launches from ", i);
+        if (state->latency) {
+            printf("%.2f to %.2f us", scores[0] / 1000.0, scores[i - 1] / 1000.0);
+        } else {
+            printf("%.2fK to %.2fK samples/s", scores[0] / 1000.0, scores[i - 1] / 1000.0);
+        }
+    }
+    printf("\n");
+}
+
+/* Run the trial of a configuration, or return the one that ran before */
+static ddsbench_tuneTrial* measure(ddsbench_tuneState *state, const int *config)
+{
+    ddsbench_tuneTrial *trial;
+    char label[32];
+    int key = configKey(config);
+
+    if (state->measured[key]) {
+        return &state->trials[state->measured[key] - 1];
+    }
+
+    trial = &state->trials[state->count++];
+    state->measured[key] = state->count;
+    memcpy(trial->config, config, sizeof(trial->config));
+    snprintf(label, sizeof(label), "trial %d", state->count);
+    runTrial(state, label, trial);
+
+    return trial;
+}
+
+/* The settings of the best configuration, as they go in ospl.xml */
+static void printXml(const int *config)
+{
+    printf("    <DDSI2Service name=\"ddsi2\">\n");
+    printf("        <General>\n");
+    printf("            <EnableMulticastLoopback>%s</EnableMulticastLoopback>\n",
+        knobs[KNOB_MCLOOPBACK].values[config[KNOB_MCLOOPBACK]]);
+    printf("        </General>\n");
+    printf("        <Internal>\n");
+    printf("            <Watermarks>\n");
+    printf("                <WhcHigh>%s</WhcHigh>\n", knobs[KNOB_WHCHIGH].values[config[KNOB_WHCHIGH]]);
+    printf("            </Watermarks>\n");
+    printf("            <MaxMessageSize>%s</MaxMessageSize>\n",
+        knobs[KNOB_MAXMESSAGESIZE].values[config[KNOB_MAXMESSAGESIZE]]);
+    printf("            <FragmentSize>%s</FragmentSize>\n",
+        knobs[KNOB_FRAGMENTSIZE].values[config[KNOB_FRAGMENTSIZE]]);
+    printf("        </Internal>\n");
+    printf("    </DDSI2Service>\n");
+}
+
+/* Improvement of best over base in percent */
+static double improvement(const ddsbench_tuneState *state, const ddsbench_tuneTrial *base, const ddsbench_tuneTrial *best)
+{
+    return state->latency ?
+        (base->score - best->score) / base->score * 100.0 :
+        (best->score - base->score) / base->score * 100.0;
+}
+
+/* The confirmation trials are NULL when the search did not beat the
+ * baseline or was interrupted */
+static void printResults(
+    const ddsbench_tuneState *state,
+    const ddsbench_tuneTrial *base,
+    const ddsbench_tuneTrial *best,
+    const ddsbench_tuneTrial *baseCheck,
+    const ddsbench_tuneTrial *bestCheck)
+{
+    int i;
+
+    printf("\n");
+    printf("Tune results (%s, %d trials)\n", ddsbench_mode, state->count);
+    for (i = 0; i < state->count; i++) {
+        const ddsbench_tuneTrial *trial = &state->trials[i];
+        printf("tune: %c %3d ", trial == best ? '*' : ' ', i + 1);
+        printConfig("", trial->config);
+        printf(": ");
+        printScore(state, trial);
+        printf("\n");
+    }
+
+    printf("\n");
+    printf("tune: baseline (ospl.xml): ");
+    printScore(state, base);
+    printf("\n");
+    printf("tune: best: ");
+    printScore(state, best);
+    if (best == base) {
+        printf(", no configuration was more than %.0f%% better than the baseline\n", DDSBENCH_TUNE_MARGIN * 100);
+    } else if (!baseCheck) {
+        printf(", %s by %.1f%% in the search, not confirmed\n", state->latency ? "lower" : "higher",
+            improvement(state, base, best));
+    } else {
+        printf("\n");
+        printf("tune: confirmed: baseline ");
+        printScore(state, baseCheck);
+        printf(", best ");
+        printScore(state, bestCheck);
+        if (better(state, bestCheck, baseCheck)) {
+            printf(", %s by %.1f%%\n", state->latency ? "lower" : "higher",
+                improvement(state, baseCheck, bestCheck));
+        } else {
+            printf(", not more than %.0f%% better than the baseline when repeated\n", DDSBENCH_TUNE_MARGIN * 100);
+        }
+    }
+
+    printf("\n");
+    printf("Best DDSI2Service configuration\n");
+    printXml(best->config);
+    printf("\n");
+    printf("The ospl plugin generates it with:\n");
+    printf("   ");
+    for (i = 0; i < DDSBENCH_TUNE_KNOBS; i++) {
+        printf(" %s=\"%s\"", knobs[i].env, knobs[i].values[best->config[i]]);
+    }
+    printf(" ddsbench %s --ospl-mode single\n", ddsbench_mode);
+}
+
+int ddsbench_runTune(ddsbench_context *ctx, int argc, char *argv[])
+{
+    ddsbench_tuneState *state = NULL;
+    ddsbench_tuneTrial *base, *best, baseCheck, bestCheck;
+    int config[DDSBENCH_TUNE_KNOBS], candidate[DDSBENCH_TUNE_KNOBS], next[DDSBENCH_TUNE_KNOBS];
+    const char *mode = getenv("DDSBENCH_OSPL_MODE");
+    const char *services = getenv("DDSBENCH_OSPL_SERVICES");
+    char duration[16], **args = NULL;
+    int round, k, v, improved = 1, confirmed = 0;
+
+    /* The DDSI2 settings only apply to a domain the plugin configures, and
+     * to a shared memory domain when it is started */
+    if (strcmp(ddsbench_lib, "ospl")) {
+        throw("tune varies the DDSI2 settings of the ospl plugin, not %s\n", ddsbench_lib);
+    }
+    if (mode && strcmp(mode, "single")) {
+        throw("tune requires --ospl-mode single, a running domain keeps its configuration\n");
+    }
+    if (services && !strstr(services, "ddsi2")) {
+        throw("tune requires the ddsi2 service, --ospl-services is %s\n", services);
+    }
+    setenv("DDSBENCH_OSPL_MODE", "single", 1);
+
+    /* Processes of a trial stop after the duration of the tuner */
+    if (!(state = calloc(1, sizeof(ddsbench_tuneState))) || !(args = malloc((argc + 3) * sizeof(char*)))) {
+        throw("out of memory\n");
+    }
+    memcpy(args, argv, argc * sizeof(char*));
+    sprintf(duration, "%d", ctx->duration);
+    args[argc] = "--duration";
+    args[argc + 1] = duration;
+    args[argc + 2] = NULL;
+
+    state->ctx = ctx;
+    state->argc = argc + 2;
+    state->argv = args;
+    state->latency = !strcmp(ddsbench_mode, "latency");
+
+    for (k = 0; k < DDSBENCH_TUNE_KNOBS; k++) {
+        config[k] = knobs[k].base;
+    }
+    base = best = measure(state, config);
+    if (base->failed) {
+        throw("the trial of the baseline configuration failed\n");
+    }
+
+    /* Coordinate descent: vary one setting at a time, keep the best value
+     * and move on to the next, until a round brings no improvement */
+    for (round = 1; round <= ddsbench_rounds && improved && !ddsbench_launchInterrupted(); round++) {
+        improved = 0;
+        printf("\ntune: round %d of at most %d\n", round, ddsbench_rounds);
+        for (k = 0; k < DDSBENCH_TUNE_KNOBS && !ddsbench_launchInterrupted(); k++) {
+            memcpy(next, config, sizeof(next));
+            for (v = 0; v < knobs[k].count && !ddsbench_launchInterrupted(); v++) {
+                ddsbench_tuneTrial *trial;
+                memcpy(candidate, config, sizeof(candidate));
+                candidate[k] = v;
+                if (v == config[k] || !configValid(candidate)) {
+                    continue;
+                }
+                trial = measure(state, candidate);
+                if (better(state, trial, best)) {
+                    best = trial;
+                    memcpy(next, candidate, sizeof(next));
+                }
+            }
+            if (memcmp(next, config, sizeof(config))) {
+                memcpy(config, next, sizeof(config));
+                improved = 1;
+                printConfig("tune: best so far: ", config);
+                printf("\n");
+            }
+        }
+    }
+    if (ddsbench_launchInterrupted()) {
+        printf("tune: interrupted, the best of %d trials is reported\n", state->count);
+    }
+
+    /* The best of many noisy trials is biased upwards, so the improvement
+     * is reported from new launches of the baseline and the best
+     * configuration */
+    if (best != base && !ddsbench_launchInterrupted()) {
+        printf("\ntune: confirming the best configuration against the baseline\n");
+        baseCheck = *base;
+        runTrial(state, "baseline", &baseCheck);
+        bestCheck = *best;
+        runTrial(state, "best", &bestCheck);
+        confirmed = !ddsbench_launchInterrupted();
+    }
+
+    printResults(state, base, best, confirmed ? &baseCheck : NULL, confirmed ? &bestCheck : NULL);
+
+    free(args);
+    free(state);
+    return 0;
+error:
+    free(args);
+    free(state);
+    return -1;
+}
@@ -0,0 +1,260 @@
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "core.h"
+
+/* Number of middleware thread names that are reported */
+#define DDSBENCH_USAGE_TOP 10
+
+static unsigned long long timevalNs(const struct timeval *tv)
+{
+    return (unsigned long long)tv->tv_sec * 1000000000ULL + tv->tv_usec * 1000ULL;
+}
+
+/* The usage of a thread is sampled at start and stop, like threadCpuNs the
+ * result fields hold the start value in between */
+void ddsbench_usageStart(ddsbench_threadArg *arg)
+{
+    struct rusage usage;
+
+    arg->tid = syscall(SYS_gettid);
+    arg->result.threadCpuNs = ddsbench_cpuTime(1);
+    if (!getrusage(RUSAGE_THREAD, &usage)) {
+        arg->result.systemNs = timevalNs(&usage.ru_stime);
+        arg->result.voluntarySwitches = usage.ru_nvcsw;
+        arg->result.involuntarySwitches = usage.ru_nivcsw;
+    }
+}
+
+void ddsbench_usageStop(ddsbench_threadArg *arg)
+{
+    struct rusage usage;
+
+    arg->result.threadCpuNs = ddsbench_cpuTime(1) - arg->result.threadCpuNs;
+    if (!getrusage(RUSAGE_THREAD, &usage)) {
+        arg->result.systemNs = timevalNs(&usage.ru_stime) - arg->result.systemNs;
+        arg->result.voluntarySwitches = usage.ru_nvcsw - arg->result.voluntarySwitches;
+        arg->result.involuntarySwitches = usage.ru_nivcsw - arg->result.involuntarySwitches;
+    } else {
+        arg->result.systemNs = arg->result.voluntarySwitches = arg->result.involuntarySwitches = 0;
+    }
+}
+
+/* CPU time of a task of this process. schedstat has nanosecond resolution,
+ * stat (in clock ticks) is the fallback when schedstats are not available. */
+static int taskCpu(int tid, unsigned long long *ns)
+{
+    unsigned long long utime, stime;
+    char path[64], buf[1024], *ptr;
+    FILE *f;
+    int result = -1;
+
+    sprintf(path, "/proc/self/task/%d/schedstat", tid);
+    if ((f = fopen(path, "r"))) {
+        result = fscanf(f, "%llu", ns) == 1 ? 0 : -1;
+        fclose(f);
+        if (!result) {
+            return 0;
+        }
+    }
+
+    sprintf(path, "/proc/self/task/%d/stat", tid);
+    if ((f = fopen(path, "r"))) {
+        /* The name may contain spaces, fields are counted from its closing parenthesis */
+        if (fgets(buf, sizeof(buf), f) && (ptr = strrchr(buf, ')')) &&
+            sscanf(ptr + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) == 2)
+        {
+            *ns = (utime + stime) * (1000000000ULL / sysconf(_SC_CLK_TCK));
+            result = 0;
+        }
+        fclose(f);
+    }
+
+    return result;
+}
+
+static void taskName(int tid, char *name, size_t size)
+{
+    char path[64];
+    FILE *f;
+
+    sprintf(path, "/proc/self/task/%d/comm", tid);
+    name[0] = '\0';
+    if ((f = fopen(path, "r"))) {
+        if (fgets(name, size, f)) {
+            name[strcspn(name, "\n")] = '\0';
+        }
+        fclose(f);
+    }
+}
+
+int ddsbench_tasksSample(ddsbench_tasks *tasks)
+{
+    struct dirent *entry;
+    DIR *dir;
+
+    memset(tasks, 0, sizeof(*tasks));
+    if (!(dir = opendir("/proc/self/task"))) {
+        return -1;
+    }
+
+    while ((entry = readdir(dir))) {
+        ddsbench_task *task;
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        if (tasks->count == tasks->size) {
+            ddsbench_task *grown = realloc(tasks->tasks, (tasks->size + 64) * sizeof(ddsbench_task));
+            if (!grown) {
+                break;
+            }
+            tasks->tasks = grown;
+            tasks->size += 64;
+        }
+        task = &tasks->tasks[tasks->count];
+        task->tid = atoi(entry->d_name);
+        if (!taskCpu(task->tid, &task->cpuNs)) {
+            taskName(task->tid, task->name, sizeof(task->name));
+            tasks->count++;
+        }
+    }
+    closedir(dir);
+
+    return 0;
+}
+
+void ddsbench_tasksFree(ddsbench_tasks *tasks)
+{
+    free(tasks->tasks);
+    memset(tasks, 0, sizeof(*tasks));
+}
+
+/* Middleware CPU of the threads that share a name */
+typedef struct usageGroup {
+    char name[16];
+    int threads;
+    unsigned long long cpuNs;
+} usageGroup;
+
+static int compareGroup(const void *p1, const void *p2)
+{
+    const usageGroup *g1 = p1, *g2 = p2;
+    return g1->cpuNs < g2->cpuNs ? 1 : g1->cpuNs > g2->cpuNs ? -1 : 0;
+}
+
+static int isBenchmark(int tid, ddsbench_threadArg *args, int count)
+{
+    int i;
+
+    if (tid == getpid()) {
+        return 1;
+    }
+    for (i = 0; i < count; i++) {
+        if (args[i].tid == tid) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void printRow(const char *name, int threads, unsigned long long samples, unsigned long long bytes, unsigned long long cpuNs)
+{
+    printf("ddsbench: %-18s %7d %11llu %10.2f %10.1f %11.2f %11.1f\n",
+        name, threads, samples, bytes / 1048576.0, cpuNs / 1000000.0,
+        samples ? (double)cpuNs / samples / 1000.0 : 0,
+        bytes ? (double)cpuNs / (bytes / 1048576.0) / 1000.0 : 0);
+}
+
+void ddsbench_printCost(
+    ddsbench_threadArg *args,
+    int count,
+    const ddsbench_tasks *before,
+    const ddsbench_tasks *after,
+    unsigned long long processNs)
+{
+    usageGroup *groups = calloc(after->count ? after->count : 1, sizeof(usageGroup));
+    unsigned long long written = 0, writtenBytes = 0, writerNs = 0;
+    unsigned long long received = 0, receivedBytes = 0, readerNs = 0;
+    unsigned long long middlewareNs = 0, delivered, deliveredBytes, otherNs;
+    int writers = 0, readers = 0, middleware = 0, numGroups = 0, i, j;
+    char name[32];
+
+    if (!groups) {
+        return;
+    }
+
+    /* Writers do not count bytes, they write samples of the configured payload */
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        if (args[i].role == DDSBENCH_PUBLISHER) {
+            writers++;
+            written += r->samples;
+            writtenBytes += r->bytes ? r->bytes : r->samples * (args[i].ctx->payload + 8);
+            writerNs += r->threadCpuNs;
+        } else {
+            readers++;
+            received += r->samples;
+            receivedBytes += r->bytes;
+            readerNs += r->threadCpuNs;
+        }
+    }
+
+    /* Every other thread belongs to the middleware. Threads that started during
+     * the run count from zero, threads that exited during the run are lost. */
+    for (i = 0; i < after->count; i++) {
+        const ddsbench_task *task = &after->tasks[i];
+        unsigned long long cpuNs = task->cpuNs;
+        if (isBenchmark(task->tid, args, count)) {
+            continue;
+        }
+        for (j = 0; j < before->count; j++) {
+            if (before->tasks[j].tid == task->tid) {
+                cpuNs = cpuNs > before->tasks[j].cpuNs ? cpuNs - before->tasks[j].cpuNs : 0;
+                break;
+            }
+        }
+        middleware++;
+        middlewareNs += cpuNs;
+        for (j = 0; j < numGroups && strcmp(groups[j].name, task->name); j++);
+        if (j == numGroups) {
+            strcpy(groups[numGroups++].name, task->name);
+        }
+        groups[j].threads++;
+        groups[j].cpuNs += cpuNs;
+    }
+    qsort(groups, numGroups, sizeof(usageGroup), compareGroup);
+
+    /* Middleware cost is per sample delivered, or written if nothing is received here */
+    delivered = received ? received : written;
+    deliveredBytes = received ? receivedBytes : writtenBytes;
+    otherNs = processNs > writerNs + readerNs + middlewareNs ? processNs - writerNs - readerNs - middlewareNs : 0;
+
+    printf("\n");
+    printf("CPU cost per message (middleware per sample %s)\n", received ? "received" : "written");
+    printf("ddsbench: %-18s %7s %11s %10s %10s %11s %11s\n",
+        "", "threads", "samples", "MB", "cpu[ms]", "us/sample", "us/MB");
+    if (writers) {
+        printRow("writers", writers, written, writtenBytes, writerNs);
+    }
+    if (readers) {
+        printRow("readers", readers, received, receivedBytes, readerNs);
+    }
+    printRow("middleware", middleware, delivered, deliveredBytes, middlewareNs);
+    for (i = 0; i < numGroups && i < DDSBENCH_USAGE_TOP; i++) {
+        sprintf(name, "  %.15s", groups[i].name);
+        printRow(name, groups[i].threads, delivered, deliveredBytes, groups[i].cpuNs);
+    }
+    if (otherNs) {
+        printRow("other", 0, delivered, deliveredBytes, otherNs);
+    }
+    printRow("process", 0, delivered, deliveredBytes, processNs);
+
+    free(groups);
+}
@@ -0,0 +1,271 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "core.h"
+
+struct ddsbench_latch {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int count;
+};
+
+/* Threads that do not reach the barrier in time (because they failed) do not
+ * keep the others from starting */
+#define DDSBENCH_BARRIER_TIMEOUT 60
+
+struct ddsbench_barrier {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int count;                      /* Threads that have not arrived yet */
+    unsigned long long t0;          /* Time the last thread arrived */
+};
+
+unsigned long long ddsbench_cpuTime(int thread)
+{
+    struct timespec ts;
+    if (clock_gettime(thread ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID, &ts)) {
+        return 0;
+    }
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+unsigned long long ddsbench_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* The offset between the wall clock and the monotonic clock, taken once */
+static pthread_once_t wallOnce = PTHREAD_ONCE_INIT;
+static long long wallOffset;
+
+static void wallInit(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    wallOffset = (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec - (long long)ddsbench_time();
+}
+
+unsigned long long ddsbench_timeFromWall(long long wallNs)
+{
+    pthread_once(&wallOnce, wallInit);
+    return wallNs - wallOffset > 0 ? (unsigned long long)(wallNs - wallOffset) : 0;
+}
+
+ddsbench_latch* ddsbench_latchNew(int count)
+{
+    ddsbench_latch *latch = malloc(sizeof(ddsbench_latch));
+    if (latch) {
+        pthread_mutex_init(&latch->lock, NULL);
+        pthread_cond_init(&latch->cond, NULL);
+        latch->count = count;
+    }
+    return latch;
+}
+
+void ddsbench_latchFree(ddsbench_latch *latch)
+{
+    if (latch) {
+        pthread_mutex_destroy(&latch->lock);
+        pthread_cond_destroy(&latch->cond);
+        free(latch);
+    }
+}
+
+void ddsbench_latchArrive(ddsbench_latch *latch)
+{
+    if (latch) {
+        pthread_mutex_lock(&latch->lock);
+        if (latch->count && !--latch->count) {
+            pthread_cond_broadcast(&latch->cond);
+        }
+        pthread_mutex_unlock(&latch->lock);
+    }
+}
+
+void ddsbench_latchWait(ddsbench_latch *latch)
+{
+    if (latch) {
+        pthread_mutex_lock(&latch->lock);
+        while (latch->count) {
+            pthread_cond_wait(&latch->cond, &latch->lock);
+        }
+        pthread_mutex_unlock(&latch->lock);
+    }
+}
+
+ddsbench_barrier* ddsbench_barrierNew(int count)
+{
+    ddsbench_barrier *barrier = malloc(sizeof(ddsbench_barrier));
+    if (barrier) {
+        pthread_mutex_init(&barrier->lock, NULL);
+        pthread_cond_init(&barrier->cond, NULL);
+        barrier->count = count;
+        barrier->t0 = 0;
+    }
+    return barrier;
+}
+
+void ddsbench_barrierFree(ddsbench_barrier *barrier)
+{
+    if (barrier) {
+        pthread_mutex_destroy(&barrier->lock);
+        pthread_cond_destroy(&barrier->cond);
+        free(barrier);
+    }
+}
+
+unsigned long long ddsbench_startBarrier(ddsbench_context *ctx)
+{
+    ddsbench_barrier *barrier = ctx->start;
+    struct timespec deadline;
+    unsigned long long t0;
+
+    if (!barrier) {
+        ddsbench_perfEnable();
+        ddsbench_allocEnable();
+        return ddsbench_time();
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += DDSBENCH_BARRIER_TIMEOUT;
+
+    pthread_mutex_lock(&barrier->lock);
+    if (barrier->count && !--barrier->count) {
+        barrier->t0 = ddsbench_time();
+        pthread_cond_broadcast(&barrier->cond);
+    }
+    while (barrier->count) {
+        if (pthread_cond_timedwait(&barrier->cond, &barrier->lock, &deadline)) {
+            printf("ddsbench: %d threads did not get ready, starting without them\n", barrier->count);
+            barrier->count = 0;
+            barrier->t0 = ddsbench_time();
+            pthread_cond_broadcast(&barrier->cond);
+        }
+    }
+    t0 = barrier->t0;
+    pthread_mutex_unlock(&barrier->lock);
+    ddsbench_perfEnable();
+    ddsbench_allocEnable();
+
+    return t0;
+}
+
+/* Values below 8 have their own bucket, larger values are bucketed by their
+ * most significant bit and the three bits that follow it. */
+static int histogramIndex(unsigned long long ns)
+{
+    int msb = 0, index;
+
+    if (ns < 8) {
+        return ns;
+    }
+    while (ns >> (msb + 1)) msb++;
+    index = (msb - 2) * 8 + ((ns >> (msb - 3)) & 7);
+
+    return index < DDSBENCH_HISTOGRAM_BUCKETS ? index : DDSBENCH_HISTOGRAM_BUCKETS - 1;
+}
+
+static unsigned long long histogramValue(int index)
+{
+    if (index < 8) {
+        return index;
+    }
+    return (8ULL + index % 8) << (index / 8 - 1);
+}
+
+void ddsbench_histogramAdd(ddsbench_histogram *histogram, unsigned long long ns)
+{
+    histogram->bucket[histogramIndex(ns)]++;
+    histogram->count++;
+    histogram->totalNs += ns;
+    if (ns > histogram->maxNs) {
+        histogram->maxNs = ns;
+    }
+}
+
+void ddsbench_reportWrite(ddsbench_threadArg *arg, unsigned long long startNs, unsigned long long endNs, int timedOut)
+{
+    ddsbench_threadResult *result = &arg->result;
+    unsigned long long ns = endNs > startNs ? endNs - startNs : 0;
+
+    ddsbench_histogramAdd(&result->writeNs, ns);
+    if (ns > DDSBENCH_BLOCKED_NS) {
+        result->blocked++;
+    }
+    if (timedOut) {
+        result->timeouts++;
+    } else {
+        result->samples++;
+    }
+}
+
+void ddsbench_reportTake(ddsbench_threadArg *arg, unsigned long long bytes, long long latencyNs)
+{
+    ddsbench_threadResult *result = &arg->result;
+
+    if (latencyNs >= 0) {
+        ddsbench_histogramAdd(&result->latencyNs, latencyNs);
+    }
+    result->samples++;
+    result->bytes += bytes;
+}
+
+void ddsbench_histogramMerge(ddsbench_histogram *to, const ddsbench_histogram *from)
+{
+    int i;
+    for (i = 0; i < DDSBENCH_HISTOGRAM_BUCKETS; i++) {
+        to->bucket[i] += from->bucket[i];
+    }
+    to->count += from->count;
+    to->totalNs += from->totalNs;
+    if (from->maxNs > to->maxNs) {
+        to->maxNs = from->maxNs;
+    }
+}
+
+unsigned long long ddsbench_histogramQuantile(const ddsbench_histogram *histogram, double q)
+{
+    unsigned long long target = q * histogram->count, seen = 0;
+    int i;
+
+    for (i = 0; i < DDSBENCH_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->bucket[i];
+        if (seen > target) {
+            /* Report the upper bound of the bucket, but never more than the max */
+            unsigned long long value = i + 1 < DDSBENCH_HISTOGRAM_BUCKETS ? histogramValue(i + 1) - 1 : histogram->maxNs;
+            return value < histogram->maxNs ? value : histogram->maxNs;
+        }
+    }
+
+    return histogram->maxNs;
+}
+
+int ddsbench_parseList(const char *list, int *values, int max)
+{
+    const char *ptr = list;
+    char *end;
+    int count = 0;
+
+    while (*ptr) {
+        if (count == max) {
+            printf("error: list '%s' has more than %d elements\n", list, max);
+            return -1;
+        }
+        values[count++] = strtol(ptr, &end, 10);
+        if (end == ptr || (*end && *end != ',')) {
+            printf("error: invalid number in list '%s'\n", list);
+            return -1;
+        }
+        ptr = *end ? end + 1 : end;
+    }
+
+    return count;
+}
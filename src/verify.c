@@ -0,0 +1,274 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "core.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define DDSBENCH_CRC_HW 1
+#endif
+
+/* CRC32C (Castagnoli) polynomial, reflected */
+#define DDSBENCH_CRC_POLY 0x82f63b78
+
+/* The hardware kernel runs three independent streams over blocks of these
+ * sizes, so the latency of the crc32 instruction is hidden, and combines
+ * them by shifting with precomputed tables */
+#define DDSBENCH_CRC_LONG 8192
+#define DDSBENCH_CRC_SHORT 256
+
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+static uint32_t crcTable[8][256];
+static uint32_t crcLong[4][256];
+static uint32_t crcShort[4][256];
+static int crcHardware = 0;
+
+static uint32_t gf2Times(const uint32_t *mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+static void gf2Square(uint32_t *square, const uint32_t *mat)
+{
+    int n;
+
+    for (n = 0; n < 32; n++) {
+        square[n] = gf2Times(mat, mat[n]);
+    }
+}
+
+/* Tables that advance a crc over length zero bytes */
+static void crcZeros(uint32_t zeros[][256], unsigned long length)
+{
+    uint32_t even[32], odd[32], *op = NULL, row = 1;
+    int n;
+
+    odd[0] = DDSBENCH_CRC_POLY;
+    for (n = 1; n < 32; n++) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    gf2Square(even, odd);
+    gf2Square(odd, even);
+
+    /* The first square gives the operator for one zero byte */
+    do {
+        gf2Square(even, odd);
+        op = even;
+        length >>= 1;
+        if (!length) {
+            break;
+        }
+        gf2Square(odd, even);
+        op = odd;
+        length >>= 1;
+    } while (length);
+
+    for (n = 0; n < 256; n++) {
+        zeros[0][n] = gf2Times(op, n);
+        zeros[1][n] = gf2Times(op, n << 8);
+        zeros[2][n] = gf2Times(op, n << 16);
+        zeros[3][n] = gf2Times(op, (uint32_t)n << 24);
+    }
+}
+
+static uint32_t crcShift(uint32_t zeros[][256], uint32_t crc)
+{
+    return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+           zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+static void crcInit(void)
+{
+    uint32_t crc;
+    int n, k;
+
+    for (n = 0; n < 256; n++) {
+        crc = n;
+        for (k = 0; k < 8; k++) {
+            crc = crc & 1 ? (crc >> 1) ^ DDSBENCH_CRC_POLY : crc >> 1;
+        }
+        crcTable[0][n] = crc;
+    }
+    for (n = 0; n < 256; n++) {
+        crc = crcTable[0][n];
+        for (k = 1; k < 8; k++) {
+            crc = crcTable[0][crc & 0xff] ^ (crc >> 8);
+            crcTable[k][n] = crc;
+        }
+    }
+    crcZeros(crcLong, DDSBENCH_CRC_LONG);
+    crcZeros(crcShort, DDSBENCH_CRC_SHORT);
+#ifdef DDSBENCH_CRC_HW
+    __builtin_cpu_init();
+    crcHardware = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+/* Slicing-by-8, for cpus without the crc32 instruction */
+static uint32_t crcSoftware(uint32_t crc, const unsigned char *next, unsigned long length)
+{
+    uint64_t word;
+
+    while (length && ((uintptr_t)next & 7)) {
+        crc = crcTable[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+        length--;
+    }
+    while (length >= 8) {
+        memcpy(&word, next, 8);
+        word ^= crc;
+        crc = crcTable[7][word & 0xff] ^ crcTable[6][(word >> 8) & 0xff] ^
+              crcTable[5][(word >> 16) & 0xff] ^ crcTable[4][(word >> 24) & 0xff] ^
+              crcTable[3][(word >> 32) & 0xff] ^ crcTable[2][(word >> 40) & 0xff] ^
+              crcTable[1][(word >> 48) & 0xff] ^ crcTable[0][word >> 56];
+        next += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = crcTable[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef DDSBENCH_CRC_HW
+static uint64_t crcWord(const unsigned char *next)
+{
+    uint64_t word;
+    memcpy(&word, next, 8);
+    return word;
+}
+
+/* Run three streams over blocks of size bytes while they last */
+__attribute__((target("sse4.2")))
+static uint64_t crcStreams(uint64_t crc0, const unsigned char **next, unsigned long *length,
+    unsigned long size, uint32_t zeros[][256])
+{
+    while (*length >= size * 3) {
+        const unsigned char *ptr = *next, *end = ptr + size;
+        uint64_t crc1 = 0, crc2 = 0;
+        do {
+            crc0 = _mm_crc32_u64(crc0, crcWord(ptr));
+            crc1 = _mm_crc32_u64(crc1, crcWord(ptr + size));
+            crc2 = _mm_crc32_u64(crc2, crcWord(ptr + size * 2));
+            ptr += 8;
+        } while (ptr < end);
+        crc0 = crcShift(zeros, crc0) ^ crc1;
+        crc0 = crcShift(zeros, crc0) ^ crc2;
+        *next += size * 3;
+        *length -= size * 3;
+    }
+    return crc0;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crcHw(uint32_t crc, const unsigned char *next, unsigned long length)
+{
+    uint64_t crc0 = crc;
+
+    while (length && ((uintptr_t)next & 7)) {
+        crc0 = _mm_crc32_u8(crc0, *next++);
+        length--;
+    }
+    crc0 = crcStreams(crc0, &next, &length, DDSBENCH_CRC_LONG, crcLong);
+    crc0 = crcStreams(crc0, &next, &length, DDSBENCH_CRC_SHORT, crcShort);
+    while (length >= 8) {
+        crc0 = _mm_crc32_u64(crc0, crcWord(next));
+        next += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc0 = _mm_crc32_u8(crc0, *next++);
+    }
+    return (uint32_t)crc0;
+}
+#endif
+
+unsigned int ddsbench_crc32c(unsigned int crc, const void *data, unsigned long length)
+{
+    pthread_once(&crcOnce, crcInit);
+    crc = ~crc;
+#ifdef DDSBENCH_CRC_HW
+    if (crcHardware) {
+        return ~crcHw(crc, data, length);
+    }
+#endif
+    return ~crcSoftware(crc, data, length);
+}
+
+void ddsbench_payloadStamp(void *payload, unsigned long length)
+{
+    ddsbench_payloadHeader header;
+
+    if (length < sizeof(header)) {
+        return;
+    }
+    header.length = length;
+    header.crc = ddsbench_crc32c(0, (unsigned char *)payload + sizeof(header), length - sizeof(header));
+    memcpy(payload, &header, sizeof(header));
+}
+
+int ddsbench_payloadVerify(const void *payload, unsigned long length, ddsbench_threadResult *result)
+{
+    ddsbench_payloadHeader header;
+
+    result->verified++;
+    if (length >= sizeof(header)) {
+        memcpy(&header, payload, sizeof(header));
+        if (header.length == length &&
+            header.crc == ddsbench_crc32c(0, (const unsigned char *)payload + sizeof(header), length - sizeof(header)))
+        {
+            result->verifiedBytes += length;
+            return 0;
+        }
+    }
+    result->corrupt++;
+    return -1;
+}
+
+void ddsbench_printVerify(ddsbench_threadArg *args, int count)
+{
+    unsigned long long verified = 0, corrupt = 0, bytes = 0, verifyNs = 0;
+    int i;
+
+    pthread_once(&crcOnce, crcInit);
+    printf("\n");
+    printf("Payload verification (CRC32C, %s)\n", crcHardware ? "sse4.2" : "software");
+    printf("ddsbench: %-8s %11s %9s %10s %10s %12s %10s\n",
+        "thread", "verified", "corrupt", "MB", "cpu[ms]", "ns/sample", "GB/s");
+    for (i = 0; i < count; i++) {
+        ddsbench_threadResult *r = &args[i].result;
+        char thread[16];
+        if (!r->verified) {
+            continue;
+        }
+        sprintf(thread, "%s %d", args[i].role == DDSBENCH_PUBLISHER ? "pub" : "sub", args[i].id);
+        printf("ddsbench: %-8s %11llu %9llu %10.2f %10.1f %12.1f %10.2f\n",
+            thread, r->verified, r->corrupt, r->verifiedBytes / 1048576.0, r->verifyNs / 1000000.0,
+            (double)r->verifyNs / r->verified,
+            r->verifyNs ? (double)r->verifiedBytes / r->verifyNs : 0);
+        verified += r->verified;
+        corrupt += r->corrupt;
+        bytes += r->verifiedBytes;
+        verifyNs += r->verifyNs;
+    }
+    if (!verified) {
+        printf("ddsbench: no samples verified\n");
+    } else if (corrupt) {
+        printf("ddsbench: %llu of %llu samples were corrupt\n", corrupt, verified);
+    } else {
+        printf("ddsbench: all %llu samples intact, %.2f GB/s verified\n",
+            verified, verifyNs ? (double)bytes / verifyNs : 0);
+    }
+}
@@ -0,0 +1,197 @@
+
+#ifndef UDP_H
+#define UDP_H
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <ddsbench.h>
+
+#ifdef __cplusplus
+extern "c" {
+#endif
+
+/* Set when the benchmark is interrupted (SIGINT) */
+extern volatile int udp_terminated;
+
+/* Time a blocking receive waits, so that termination and deadlines are noticed */
+#define UDP_WAIT_NS 100000000ULL
+
+/* Interval at which writers look for readers, while matching and while writing */
+#define UDP_MATCH_PROBE_NS 10000000ULL
+#define UDP_PROBE_NS 100000000ULL
+
+/* Time after which a peer that was not heard from is dropped, when its
+ * process died without saying goodbye */
+#define UDP_PEER_TIMEOUT_NS 10000000000ULL
+
+/* Every topic and partition has UDP_MAX_READERS ports on the loopback
+ * interface, one of UDP_TOPIC_BUCKETS ranges from the base port up. Readers
+ * bind the first free port of the range of their topic, writers send to the
+ * readers that answer on it. DDSBENCH_UDP_PORT sets the base port. */
+#define UDP_PORT_BASE 20000
+#define UDP_TOPIC_BUCKETS 256
+#define UDP_MAX_READERS 32
+#define UDP_MAX_WRITERS 64
+
+/* Largest payload of a datagram over IPv4, and the payload bytes a fragment
+ * carries by default, which fills an Ethernet frame like a real network.
+ * DDSBENCH_UDP_FRAGMENT sets it, up to UDP_DATAGRAM_MAX less the header. */
+#define UDP_DATAGRAM_MAX 65507
+#define UDP_FRAGMENT_SIZE (1472 - (int)sizeof(udp_sample))
+
+/* Segments the kernel accepts in a single send with UDP_SEGMENT (GSO) */
+#define UDP_MAX_SEGMENTS 64
+
+/* Datagrams sent or received in one sendmmsg or recvmmsg call, and the
+ * iovecs and fragment headers a writer batches */
+#define UDP_BATCH 64
+#define UDP_IOV 1024
+#define UDP_HEADERS 256
+
+/* Socket buffers that are requested, to absorb bursts of a writer */
+#define UDP_SOCKET_BUFFER (8 * 1024 * 1024)
+
+/* Kinds of datagrams */
+#define UDP_DATA 0
+#define UDP_HELLO 1                 /* A writer looks for readers, which answer */
+#define UDP_ACK 2
+#define UDP_BYE 3                   /* An endpoint leaves */
+
+/* The header of every datagram. A sample that does not fit in a fragment is
+ * sent in fragments of consecutive offsets, which readers put back together. */
+typedef struct udp_sample {
+    unsigned int key;               /* Hash of topic and partition, which may share a port range */
+    unsigned short kind;
+    unsigned short flags;
+    unsigned long long count;
+    unsigned long long timestamp;   /* ddsbench_time of the write, the clock is shared by the host */
+    int id;
+    int filter;
+    unsigned int length;            /* Bytes of payload of the whole sample */
+    unsigned int offset;            /* Offset of the payload of this fragment */
+} udp_sample;
+
+#define UDP_PAYLOAD(sample) ((unsigned char *)(sample) + sizeof(udp_sample))
+
+/* Configuration from the environment, see init */
+extern unsigned short udp_portBase;
+extern unsigned int udp_fragment;
+extern int udp_gso;
+
+/* An endpoint on the other side, by the port of its socket */
+typedef struct udp_peer {
+    unsigned short port;
+    unsigned long long lastSeen;
+    udp_sample *buffer;             /* Sample that is put back together, readers only */
+    unsigned int size;              /* Payload bytes buffer holds */
+    unsigned int received;          /* Payload bytes of buffer received so far */
+} udp_peer;
+
+/* Sockets of the loopback interface. udp_socketOpen binds the first free
+ * port from port up to port + count, any port when count is 0, and returns
+ * the descriptor or -1. */
+int udp_socketOpen(unsigned short port, int count, unsigned short *bound);
+void udp_socketAddress(struct sockaddr_in *address, unsigned short port);
+
+/* Key of a topic in a partition, and the first port of its range */
+unsigned int udp_topicKey(const char *topicName, const char *partition);
+unsigned short udp_topicPort(unsigned int key);
+
+/* Send a datagram without payload to port */
+void udp_sendControl(int fd, unsigned int key, unsigned short kind, int id, unsigned short port);
+
+/* Endpoints */
+typedef struct udp_writer {
+    int fd;
+    int id;
+    unsigned int key;
+    unsigned short port;            /* First port of the range of the topic */
+    udp_peer readers[UDP_MAX_READERS];
+    int numReaders;
+    unsigned long long lastProbe;
+    int probed;                     /* Answers to a probe were processed */
+    int batch;                      /* Send a burst with a single sendmmsg */
+    int segments;                   /* Fragments in a single send, more than one with GSO */
+    unsigned int fragment;          /* Payload bytes of a fragment */
+
+    /* Datagrams waiting to be sent, and their iovecs and headers */
+    struct mmsghdr msgs[UDP_BATCH];
+    struct sockaddr_in addresses[UDP_BATCH];
+    struct iovec iov[UDP_IOV];
+    udp_sample headers[UDP_HEADERS];
+    int numMsgs;
+    int numIov;
+    int numHeaders;
+    int failed;                     /* A send failed, which is reported once */
+} udp_writer;
+
+typedef struct udp_reader {
+    int fd;
+    int id;
+    unsigned int key;
+    unsigned short port;            /* Port the reader is bound to */
+    udp_peer writers[UDP_MAX_WRITERS];
+    int numWriters;
+    int matched;                    /* Saw a writer once, see udp_writersGone */
+    int held;                       /* A sample was put back together in this take */
+
+    /* Datagrams of the last recvmmsg, and the next one to parse */
+    struct mmsghdr msgs[UDP_BATCH];
+    struct sockaddr_in addresses[UDP_BATCH];
+    struct iovec iov[UDP_BATCH];
+    unsigned char *buffers;
+    unsigned long bufferSize;
+    int count;
+    int next;
+    int truncated;                  /* A datagram did not fit, which is reported once */
+} udp_reader;
+
+udp_writer* udp_writerNew(ddsbench_threadArg *arg, const char *partition);
+void udp_writerFree(udp_writer *writer);
+udp_reader* udp_readerNew(ddsbench_threadArg *arg, const char *partition);
+void udp_readerFree(udp_reader *reader);
+
+/* Send a sample to every reader. The datagrams refer to payload until they
+ * are sent, which happens right away when flush is set or the writer does not
+ * batch, and otherwise when the batch is full or flushed. There is no flow
+ * control, a reader that has no space in its socket buffer loses the sample.
+ * Returns nonzero when sending failed. */
+int udp_write(udp_writer *writer, int id, unsigned long long count, const void *payload, unsigned int length, int flush);
+void udp_writerFlush(udp_writer *writer);
+
+/* Look for readers when the last look was longer than intervalNs ago, and
+ * process their answers */
+void udp_writerProbe(udp_writer *writer, unsigned long long now, unsigned long long intervalNs);
+
+/* Take the next sample. udp_readerTake starts a take, which receives a batch
+ * of datagrams when the last one is used up, blocking up to UDP_WAIT_NS when
+ * block is set. udp_readerNext continues it without receiving. The samples of
+ * a take stay valid until the next take starts. Returns NULL when no sample
+ * is left. */
+udp_sample* udp_readerTake(udp_reader *reader, int block);
+udp_sample* udp_readerNext(udp_reader *reader);
+
+/* Matched counts */
+int udp_matchedReaders(udp_writer *writer);
+int udp_matchedWriters(udp_reader *reader);
+
+/* Whether the writers a reader was matched with are all gone */
+int udp_writersGone(udp_reader *reader);
+
+/* Wait until writer and reader (either may be NULL) are matched with the
+ * number of readers and writers the benchmark expects, and set readyNs */
+void udp_waitMatched(ddsbench_threadArg *arg, udp_writer *writer, udp_reader *reader);
+
+/* Endpoints the harness runs the latency and throughput threads on */
+extern const ddsbench_ops udp_ops;
+
+/* Functions of the plugin, exported through its descriptor in udp.c */
+int init(ddsbench_context *ctx);
+void fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
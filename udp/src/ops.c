@@ -0,0 +1,144 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <udp.h>
+
+/* The most memory a copying reader takes samples into */
+#define COPY_BYTES (16UL * 1024 * 1024)
+
+/* A reader of the engine. Waiting is left to the next take, which blocks in
+ * recvmmsg, so that a blocking receive stays a single system call. */
+typedef struct opsReader {
+    udp_reader *reader;
+    unsigned char *copies;          /* Copies of the samples taken, NULL when loaned */
+    unsigned long slotSize;
+    int maxTake;
+    int block;                      /* The engine waits, the next take blocks */
+} opsReader;
+
+static void* opsWriterNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos)
+{
+    return udp_writerNew(arg, partition);
+}
+
+static void* opsReaderNew(ddsbench_threadArg *arg, ddsbench_endpointKind kind, const char *partition,
+    const ddsbench_qos *qos, ddsbench_listenerFn listener, void *listenerArg)
+{
+    ddsbench_context *ctx = arg->ctx;
+    opsReader *reader;
+
+    if (!(reader = calloc(1, sizeof(opsReader)))) {
+        printf("sub %d: out of memory\n", arg->id);
+        return NULL;
+    }
+    reader->slotSize = sizeof(udp_sample) + ctx->payload;
+    reader->maxTake = COPY_BYTES / reader->slotSize ? COPY_BYTES / reader->slotSize : 1;
+
+    /* Bound the memory of the copies a reader takes */
+    if (ctx->take == DDSBENCH_TAKE_COPY && !(reader->copies = malloc(reader->maxTake * reader->slotSize))) {
+        printf("sub %d: out of memory\n", arg->id);
+        free(reader);
+        return NULL;
+    }
+    if (!(reader->reader = udp_readerNew(arg, partition))) {
+        free(reader->copies);
+        free(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+static void opsWriterFree(void *writer)
+{
+    udp_writerFree(writer);
+}
+
+static void opsReaderFree(void *ptr)
+{
+    opsReader *reader = ptr;
+
+    udp_readerFree(reader->reader);
+    free(reader->copies);
+    free(reader);
+}
+
+static void opsWaitMatched(ddsbench_threadArg *arg, void *writer, void *reader)
+{
+    udp_waitMatched(arg, writer, reader ? ((opsReader *)reader)->reader : NULL);
+}
+
+static int opsWrite(void *writer, const ddsbench_sample *sample)
+{
+    return udp_write(writer, sample->id, sample->count, sample->payload, sample->length, 0) ?
+        DDSBENCH_WRITE_ERROR : DDSBENCH_WRITE_OK;
+}
+
+static void opsFlush(void *writer)
+{
+    udp_writerFlush(writer);
+}
+
+/* Take the samples of the datagrams received, copied out or in place */
+static int opsTake(void *ptr, ddsbench_sample *samples, int max)
+{
+    opsReader *reader = ptr;
+    udp_sample *sample;
+    int n = 0;
+
+    if (reader->copies && max > reader->maxTake) {
+        max = reader->maxTake;
+    }
+    sample = udp_readerTake(reader->reader, reader->block);
+    reader->block = 0;
+    while (sample) {
+        if (reader->copies) {
+            sample = memcpy(reader->copies + n * reader->slotSize, sample, sizeof(udp_sample) + sample->length);
+        }
+        samples[n].id = sample->id;
+        samples[n].filter = sample->filter;
+        samples[n].count = sample->count;
+        samples[n].timestamp = sample->timestamp;
+        samples[n].payload = UDP_PAYLOAD(sample);
+        samples[n].length = sample->length;
+        sample = ++n < max ? udp_readerNext(reader->reader) : NULL;
+    }
+    return n;
+}
+
+/* Samples stay valid until the next take */
+static void opsTakeDone(void *reader)
+{
+}
+
+static void opsWait(void *reader, unsigned long long timeoutNs)
+{
+    ((opsReader *)reader)->block = 1;
+}
+
+static int opsWritersGone(void *reader)
+{
+    return udp_writersGone(((opsReader *)reader)->reader);
+}
+
+static int opsTerminated(void)
+{
+    return udp_terminated;
+}
+
+const ddsbench_ops udp_ops = {
+    .writerNew = opsWriterNew,
+    .readerNew = opsReaderNew,
+    .writerFree = opsWriterFree,
+    .readerFree = opsReaderFree,
+    .waitMatched = opsWaitMatched,
+    .write = opsWrite,
+    .flush = opsFlush,
+    .take = opsTake,
+    .takeDone = opsTakeDone,
+    .wait = opsWait,
+    .writersGone = opsWritersGone,
+    .terminated = opsTerminated
+};
@@ -0,0 +1,98 @@
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <udp.h>
+
+/* Ask for big socket buffers, beyond the limits of the system if permitted */
+static void socketBuffers(int fd)
+{
+    int size = UDP_SOCKET_BUFFER;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size))) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    if (setsockopt(fd, SOL_SOCKET, SO_SNDBUFFORCE, &size, sizeof(size))) {
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+}
+
+void udp_socketAddress(struct sockaddr_in *address, unsigned short port)
+{
+    memset(address, 0, sizeof(struct sockaddr_in));
+    address->sin_family = AF_INET;
+    address->sin_port = htons(port);
+    address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+int udp_socketOpen(unsigned short port, int count, unsigned short *bound)
+{
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int fd, i;
+
+    if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        printf("error: failed to create a socket: %s\n", strerror(errno));
+        return -1;
+    }
+    socketBuffers(fd);
+
+    /* Ports of other endpoints are in use, the first free one is taken */
+    for (i = 0; i < (count ? count : 1); i++) {
+        udp_socketAddress(&address, count ? port + i : 0);
+        if (!bind(fd, (struct sockaddr *)&address, sizeof(address))) {
+            break;
+        }
+        if (errno != EADDRINUSE) {
+            i = count;
+            break;
+        }
+    }
+    if (i == (count ? count : 1)) {
+        printf("error: failed to bind a socket to ports %u to %u: %s\n",
+            count ? port : 0, count ? port + count - 1 : 0, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    getsockname(fd, (struct sockaddr *)&address, &length);
+    *bound = ntohs(address.sin_port);
+    return fd;
+}
+
+/* FNV-1a of the partition and the name of the topic */
+unsigned int udp_topicKey(const char *topicName, const char *partition)
+{
+    unsigned int hash = 2166136261u;
+    const char *c;
+
+    for (c = partition; *c; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    hash = (hash ^ '/') * 16777619u;
+    for (c = topicName; *c; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    return hash;
+}
+
+unsigned short udp_topicPort(unsigned int key)
+{
+    return udp_portBase + (key % UDP_TOPIC_BUCKETS) * UDP_MAX_READERS;
+}
+
+void udp_sendControl(int fd, unsigned int key, unsigned short kind, int id, unsigned short port)
+{
+    struct sockaddr_in address;
+    udp_sample header;
+
+    memset(&header, 0, sizeof(header));
+    header.key = key;
+    header.kind = kind;
+    header.id = id;
+    udp_socketAddress(&address, port);
+    sendto(fd, &header, sizeof(header), 0, (struct sockaddr *)&address, sizeof(address));
+}
@@ -0,0 +1,586 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/udp.h>
+
+#include <udp.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+volatile int udp_terminated;
+
+unsigned short udp_portBase = UDP_PORT_BASE;
+unsigned int udp_fragment = UDP_FRAGMENT_SIZE;
+int udp_gso = 1;
+
+static struct sigaction oldAction;
+
+static void CtrlHandler(int fdwCtrlType)
+{
+    udp_terminated = 1;
+}
+
+/* Writers are reliable unless the QoS codes end with best effort */
+static int isReliable(const char *qos)
+{
+    int reliable = 1;
+
+    for (; qos && *qos; qos++) {
+        if (*qos == 'b') {
+            reliable = 0;
+        } else if (*qos == 'r') {
+            reliable = 1;
+        }
+    }
+    return reliable;
+}
+
+int init(ddsbench_context *ctx)
+{
+    struct sigaction sat;
+    const char *value;
+
+    if ((value = getenv("DDSBENCH_UDP_PORT"))) {
+        int port = atoi(value);
+        if (port <= 0 || port + UDP_TOPIC_BUCKETS * UDP_MAX_READERS > 65536) {
+            printf("error: DDSBENCH_UDP_PORT %s leaves no room for %d ports\n", value, UDP_TOPIC_BUCKETS * UDP_MAX_READERS);
+            return -1;
+        }
+        udp_portBase = port;
+    }
+    if ((value = getenv("DDSBENCH_UDP_FRAGMENT"))) {
+        int fragment = atoi(value);
+        if (fragment <= 0 || fragment > UDP_DATAGRAM_MAX - (int)sizeof(udp_sample)) {
+            printf("error: DDSBENCH_UDP_FRAGMENT must be 1 to %d bytes\n", UDP_DATAGRAM_MAX - (int)sizeof(udp_sample));
+            return -1;
+        }
+        udp_fragment = fragment;
+    }
+    if ((value = getenv("DDSBENCH_UDP_GSO"))) {
+        udp_gso = atoi(value) != 0;
+    }
+
+    sat.sa_handler = CtrlHandler;
+    sigemptyset(&sat.sa_mask);
+    sat.sa_flags = 0;
+    sigaction(SIGINT, &sat, &oldAction);
+    udp_terminated = 0;
+
+    /* Readers process samples in their receive buffers unless copies are requested */
+    if (ctx->take == DDSBENCH_TAKE_DEFAULT) {
+        ctx->take = DDSBENCH_TAKE_LOAN;
+    }
+    if (isReliable(ctx->qos)) {
+        printf("udp: samples are not retransmitted, reliable QoS is measured best effort\n");
+    }
+
+    return 0;
+}
+
+void fini(void)
+{
+    sigaction(SIGINT, &oldAction, 0);
+}
+
+/* The plugin descriptor. Writers send samples in datagrams over the loopback
+ * interface to the readers that answer on the ports of their topic. There is
+ * no protocol on top, so readers filter after take, and nothing is kept for
+ * late joiners. */
+const ddsbench_plugin ddsbench_pluginDescriptor = {
+    .version = DDSBENCH_PLUGIN_VERSION,
+    .name = "udp",
+    .description = "loopback UDP sockets with sendmmsg and recvmmsg, no protocol",
+    .capabilities = DDSBENCH_CAP_LOANS | DDSBENCH_CAP_BATCHING,
+    .init = init,
+    .fini = fini,
+    .ops = &udp_ops
+};
+
+/* Look up a peer by port, or add it */
+static udp_peer* peerGet(udp_peer *peers, int *count, int max, unsigned short port, int add)
+{
+    int i;
+
+    for (i = 0; i < *count; i++) {
+        if (peers[i].port == port) {
+            return &peers[i];
+        }
+    }
+    if (!add || *count == max) {
+        return NULL;
+    }
+    memset(&peers[*count], 0, sizeof(udp_peer));
+    peers[*count].port = port;
+    peers[*count].lastSeen = ddsbench_time();
+    return &peers[(*count)++];
+}
+
+static void peerRemove(udp_peer *peers, int *count, udp_peer *peer)
+{
+    free(peer->buffer);
+    *peer = peers[--(*count)];
+}
+
+/* Drop the peers that were not heard from, their process is gone */
+static void peersExpire(udp_peer *peers, int *count, unsigned long long now)
+{
+    int i;
+
+    for (i = 0; i < *count; i++) {
+        if (now - peers[i].lastSeen > UDP_PEER_TIMEOUT_NS) {
+            peerRemove(peers, count, &peers[i--]);
+        }
+    }
+}
+
+udp_writer* udp_writerNew(ddsbench_threadArg *arg, const char *partition)
+{
+    udp_writer *writer;
+    unsigned short bound;
+    int i, size;
+
+    if (!(writer = calloc(1, sizeof(udp_writer)))) {
+        return NULL;
+    }
+    writer->id = arg->id;
+    writer->key = udp_topicKey(arg->topicName, partition);
+    writer->port = udp_topicPort(writer->key);
+    writer->batch = arg->ctx->batch;
+    writer->fragment = udp_fragment;
+    writer->segments = 1;
+    if ((writer->fd = udp_socketOpen(0, 0, &bound)) < 0) {
+        free(writer);
+        return NULL;
+    }
+
+    /* With GSO the kernel cuts a send of many fragments in datagrams */
+    size = sizeof(udp_sample) + writer->fragment;
+    if (udp_gso && UDP_DATAGRAM_MAX / size > 1) {
+        if (!setsockopt(writer->fd, IPPROTO_UDP, UDP_SEGMENT, &size, sizeof(size))) {
+            writer->segments = UDP_DATAGRAM_MAX / size;
+            if (writer->segments > UDP_MAX_SEGMENTS) {
+                writer->segments = UDP_MAX_SEGMENTS;
+            }
+        } else {
+            printf("pub %d: GSO is not supported (%s), sending fragments one by one\n", arg->id, strerror(errno));
+        }
+    }
+
+    for (i = 0; i < UDP_BATCH; i++) {
+        writer->msgs[i].msg_hdr.msg_name = &writer->addresses[i];
+        writer->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+    return writer;
+}
+
+/* Send the datagrams that are waiting, the headers they refer to may be reused after this */
+static int writerSend(udp_writer *writer)
+{
+    int sent = 0, n, result = 0;
+
+    while (sent < writer->numMsgs) {
+        if ((n = sendmmsg(writer->fd, writer->msgs + sent, writer->numMsgs - sent, 0)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (!writer->failed) {
+                printf("pub %d: failed to send: %s\n", writer->id, strerror(errno));
+            }
+            writer->failed = 1;
+            result = -1;
+            break;
+        }
+        sent += n;
+    }
+    writer->numMsgs = 0;
+    writer->numIov = 0;
+    return result;
+}
+
+void udp_writerFlush(udp_writer *writer)
+{
+    writerSend(writer);
+    writer->numHeaders = 0;
+}
+
+void udp_writerFree(udp_writer *writer)
+{
+    int i;
+
+    if (!writer) {
+        return;
+    }
+
+    /* Readers notice that the writer is gone after its last samples */
+    udp_writerFlush(writer);
+    for (i = 0; i < writer->numReaders; i++) {
+        udp_sendControl(writer->fd, writer->key, UDP_BYE, writer->id, writer->readers[i].port);
+    }
+    close(writer->fd);
+    free(writer);
+}
+
+void udp_writerProbe(udp_writer *writer, unsigned long long now, unsigned long long intervalNs)
+{
+    struct mmsghdr msgs[UDP_MAX_READERS];
+    struct sockaddr_in addresses[UDP_MAX_READERS];
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    struct iovec iov;
+    udp_sample header;
+    udp_peer *peer;
+    int i;
+
+    if (now - writer->lastProbe < intervalNs) {
+        return;
+    }
+    writer->probed = writer->lastProbe != 0;
+    writer->lastProbe = now;
+
+    /* Readers answered the last probe, or left */
+    while (recvfrom(writer->fd, &header, sizeof(header), MSG_DONTWAIT, (struct sockaddr *)&address, &length) >= (int)sizeof(header)) {
+        length = sizeof(address);
+        if (header.key != writer->key) {
+            continue;
+        }
+        if (header.kind == UDP_ACK) {
+            if ((peer = peerGet(writer->readers, &writer->numReaders, UDP_MAX_READERS, ntohs(address.sin_port), 1))) {
+                peer->lastSeen = now;
+            }
+        } else if (header.kind == UDP_BYE) {
+            if ((peer = peerGet(writer->readers, &writer->numReaders, UDP_MAX_READERS, ntohs(address.sin_port), 0))) {
+                peerRemove(writer->readers, &writer->numReaders, peer);
+            }
+        }
+    }
+    peersExpire(writer->readers, &writer->numReaders, now);
+
+    /* Every port of the topic is probed, the ones without a reader do not answer */
+    memset(&header, 0, sizeof(header));
+    header.key = writer->key;
+    header.kind = UDP_HELLO;
+    header.id = writer->id;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < UDP_MAX_READERS; i++) {
+        udp_socketAddress(&addresses[i], writer->port + i);
+        msgs[i].msg_hdr.msg_name = &addresses[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        msgs[i].msg_hdr.msg_iov = &iov;
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    sendmmsg(writer->fd, msgs, UDP_MAX_READERS, 0);
+}
+
+/* Queue a datagram of count fragments for port, which GSO cuts when there
+ * are more than one. The fragments refer to payload, length is the length
+ * of the whole sample. */
+static int writerQueue(udp_writer *writer, unsigned short port, udp_sample *headers, int count, const unsigned char *payload, unsigned int length)
+{
+    struct msghdr *msg;
+    struct iovec *iov;
+    int i, result = 0;
+
+    if (writer->numMsgs == UDP_BATCH || writer->numIov + 2 * count > UDP_IOV) {
+        result = writerSend(writer);
+    }
+    msg = &writer->msgs[writer->numMsgs].msg_hdr;
+    iov = &writer->iov[writer->numIov];
+    for (i = 0; i < count; i++) {
+        unsigned int offset = headers[i].offset;
+        iov[2 * i].iov_base = &headers[i];
+        iov[2 * i].iov_len = sizeof(udp_sample);
+        iov[2 * i + 1].iov_base = (void *)(payload + offset);
+        iov[2 * i + 1].iov_len = length - offset < writer->fragment ? length - offset : writer->fragment;
+    }
+    udp_socketAddress(&writer->addresses[writer->numMsgs], port);
+    msg->msg_iov = iov;
+    msg->msg_iovlen = 2 * count;
+    writer->numMsgs++;
+    writer->numIov += 2 * count;
+    return result;
+}
+
+int udp_write(udp_writer *writer, int id, unsigned long long count, const void *payload, unsigned int length, int flush)
+{
+    unsigned long long now = ddsbench_time();
+    unsigned int offset = 0;
+    udp_sample *headers;
+    int i, segments, result = 0;
+
+    udp_writerProbe(writer, now, UDP_PROBE_NS);
+    if (!writer->numReaders) {
+        return 0;
+    }
+
+    /* Fragments that are sent together share their headers between readers */
+    do {
+        segments = (length - offset + writer->fragment - 1) / writer->fragment;
+        if (segments < 1) {
+            segments = 1;
+        } else if (segments > writer->segments) {
+            segments = writer->segments;
+        }
+        if (writer->numHeaders + segments > UDP_HEADERS) {
+            result |= writerSend(writer);
+            writer->numHeaders = 0;
+        }
+        headers = &writer->headers[writer->numHeaders];
+        writer->numHeaders += segments;
+        for (i = 0; i < segments; i++) {
+            headers[i].key = writer->key;
+            headers[i].kind = UDP_DATA;
+            headers[i].flags = 0;
+            headers[i].count = count;
+            headers[i].timestamp = now;
+            headers[i].id = id;
+            headers[i].filter = count % 10;
+            headers[i].length = length;
+            headers[i].offset = offset + i * writer->fragment;
+        }
+        for (i = 0; i < writer->numReaders; i++) {
+            result |= writerQueue(writer, writer->readers[i].port, headers, segments, payload, length);
+        }
+        offset += segments * writer->fragment;
+    } while (offset < length);
+
+    if (flush || !writer->batch) {
+        result |= writerSend(writer);
+        writer->numHeaders = 0;
+    }
+    return result;
+}
+
+udp_reader* udp_readerNew(ddsbench_threadArg *arg, const char *partition)
+{
+    ddsbench_context *ctx = arg->ctx;
+    struct timeval timeout = { 0, UDP_WAIT_NS / 1000 };
+    udp_reader *reader;
+    unsigned int datagram = ctx->payload < udp_fragment ? ctx->payload : udp_fragment;
+    int i;
+
+    if (!(reader = calloc(1, sizeof(udp_reader)))) {
+        return NULL;
+    }
+    reader->id = arg->id;
+    reader->key = udp_topicKey(arg->topicName, partition);
+    reader->bufferSize = (sizeof(udp_sample) + datagram + 63) & ~63UL;
+    if (!(reader->buffers = malloc(UDP_BATCH * reader->bufferSize))) {
+        free(reader);
+        return NULL;
+    }
+    if ((reader->fd = udp_socketOpen(udp_topicPort(reader->key), UDP_MAX_READERS, &reader->port)) < 0) {
+        printf("sub %d: topic %s has %d readers already\n", arg->id, arg->topicName, UDP_MAX_READERS);
+        free(reader->buffers);
+        free(reader);
+        return NULL;
+    }
+    setsockopt(reader->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    /* A receiver that polls lets the kernel poll the device before it sleeps */
+    if (ctx->recv != DDSBENCH_RECV_BLOCK && ctx->spin) {
+        int busyPoll = ctx->spin;
+        if (setsockopt(reader->fd, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll))) {
+            printf("sub %d: SO_BUSY_POLL of %u us is not permitted (%s), ignoring\n", arg->id, ctx->spin, strerror(errno));
+        }
+    }
+
+    for (i = 0; i < UDP_BATCH; i++) {
+        reader->iov[i].iov_base = reader->buffers + i * reader->bufferSize;
+        reader->iov[i].iov_len = reader->bufferSize;
+        reader->msgs[i].msg_hdr.msg_name = &reader->addresses[i];
+        reader->msgs[i].msg_hdr.msg_iov = &reader->iov[i];
+        reader->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return reader;
+}
+
+void udp_readerFree(udp_reader *reader)
+{
+    int i;
+
+    if (!reader) {
+        return;
+    }
+
+    /* Writers stop sending to the reader */
+    for (i = 0; i < reader->numWriters; i++) {
+        udp_sendControl(reader->fd, reader->key, UDP_BYE, reader->id, reader->writers[i].port);
+        free(reader->writers[i].buffer);
+    }
+    close(reader->fd);
+    free(reader->buffers);
+    free(reader);
+}
+
+/* Add a fragment to the sample a writer is sending, returns nonzero when it
+ * is complete. A fragment that does not follow the last one means that some
+ * were lost, and the sample is dropped. */
+static int sampleAssemble(udp_peer *peer, udp_sample *fragment, unsigned int size)
+{
+    if (!fragment->offset) {
+        if (peer->size < fragment->length) {
+            udp_sample *buffer = realloc(peer->buffer, sizeof(udp_sample) + fragment->length);
+            if (!buffer) {
+                return 0;
+            }
+            peer->buffer = buffer;
+            peer->size = fragment->length;
+        }
+        *peer->buffer = *fragment;
+        peer->received = 0;
+    }
+    if (!peer->buffer || fragment->count != peer->buffer->count || fragment->offset != peer->received ||
+        fragment->length != peer->buffer->length || size > fragment->length - fragment->offset)
+    {
+        return 0;
+    }
+    memcpy(UDP_PAYLOAD(peer->buffer) + fragment->offset, UDP_PAYLOAD(fragment), size);
+    peer->received += size;
+    return peer->received == fragment->length;
+}
+
+/* Return the next sample of the datagrams received, answering the writers
+ * that look for readers on the way */
+static udp_sample* readerParse(udp_reader *reader)
+{
+    while (reader->next < reader->count) {
+        int i = reader->next++;
+        udp_sample *sample = (udp_sample *)(reader->buffers + i * reader->bufferSize);
+        unsigned int size = reader->msgs[i].msg_len;
+        unsigned short port = ntohs(reader->addresses[i].sin_port);
+        udp_peer *peer;
+
+        if (reader->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            if (!reader->truncated) {
+                printf("sub %d: dropping datagrams of more than %lu bytes, check DDSBENCH_UDP_FRAGMENT\n",
+                    reader->id, reader->bufferSize);
+                reader->truncated = 1;
+            }
+            continue;
+        }
+        if (size < sizeof(udp_sample) || sample->key != reader->key) {
+            continue;
+        }
+
+        if (sample->kind == UDP_DATA) {
+            size -= sizeof(udp_sample);
+            if (!sample->offset && size == sample->length) {
+                return sample;
+            }
+            peer = peerGet(reader->writers, &reader->numWriters, UDP_MAX_WRITERS, port, 1);
+            if (peer && sampleAssemble(peer, sample, size)) {
+                reader->held = 1;
+                return peer->buffer;
+            }
+        } else if (sample->kind == UDP_HELLO) {
+            if ((peer = peerGet(reader->writers, &reader->numWriters, UDP_MAX_WRITERS, port, 1))) {
+                peer->lastSeen = ddsbench_time();
+                reader->matched = 1;
+                udp_sendControl(reader->fd, reader->key, UDP_ACK, reader->id, port);
+            }
+        } else if (sample->kind == UDP_BYE) {
+            if ((peer = peerGet(reader->writers, &reader->numWriters, UDP_MAX_WRITERS, port, 0))) {
+                peerRemove(reader->writers, &reader->numWriters, peer);
+            }
+        }
+    }
+    return NULL;
+}
+
+static int readerReceive(udp_reader *reader, int block)
+{
+    int i, n;
+
+    for (i = 0; i < UDP_BATCH; i++) {
+        reader->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+    n = recvmmsg(reader->fd, reader->msgs, UDP_BATCH, block ? MSG_WAITFORONE : MSG_DONTWAIT, NULL);
+    reader->count = n > 0 ? n : 0;
+    reader->next = 0;
+    return reader->count;
+}
+
+udp_sample* udp_readerTake(udp_reader *reader, int block)
+{
+    udp_sample *sample;
+
+    reader->held = 0;
+    if ((sample = readerParse(reader))) {
+        return sample;
+    }
+    if (readerReceive(reader, block)) {
+        return readerParse(reader);
+    }
+    if (block) {
+        peersExpire(reader->writers, &reader->numWriters, ddsbench_time());
+    }
+    return NULL;
+}
+
+udp_sample* udp_readerNext(udp_reader *reader)
+{
+    /* A sample that was put back together is in the buffer of its writer,
+     * the next one of that writer would overwrite it */
+    if (reader->held) {
+        return NULL;
+    }
+    return readerParse(reader);
+}
+
+int udp_matchedReaders(udp_writer *writer)
+{
+    return writer->numReaders;
+}
+
+int udp_matchedWriters(udp_reader *reader)
+{
+    return reader->numWriters;
+}
+
+int udp_writersGone(udp_reader *reader)
+{
+    return reader->matched && !reader->numWriters;
+}
+
+void udp_waitMatched(ddsbench_threadArg *arg, udp_writer *writer, udp_reader *reader)
+{
+    unsigned long long deadline = ddsbench_time() + DDSBENCH_MATCH_TIMEOUT_NS;
+    struct timespec delay = { 0, 1000000 };
+
+    for (;;) {
+        if (writer) {
+            udp_writerProbe(writer, ddsbench_time(), UDP_MATCH_PROBE_NS);
+        }
+
+        /* Answer writers, samples of the ones that started already are dropped */
+        if (reader && udp_matchedWriters(reader) < (int)arg->ctx->writers) {
+            while (udp_readerTake(reader, 0));
+        }
+
+        /* Readers in other processes are not counted, they answer the first probe */
+        if ((!writer || (writer->probed && udp_matchedReaders(writer) >= (int)arg->ctx->readers)) &&
+            (!reader || udp_matchedWriters(reader) >= (int)arg->ctx->writers)) {
+            break;
+        }
+        if (udp_terminated || ddsbench_time() > deadline) {
+            printf("%s %d: matched %d of %u readers and %d of %u writers, starting anyway\n",
+                arg->role == DDSBENCH_PUBLISHER ? "pub" : "sub", arg->id,
+                writer ? udp_matchedReaders(writer) : 0, writer ? arg->ctx->readers : 0,
+                reader ? udp_matchedWriters(reader) : 0, reader ? arg->ctx->writers : 0);
+            break;
+        }
+        nanosleep(&delay, NULL);
+    }
+
+    arg->result.readyNs = ddsbench_time() - arg->startNs;
+}